@@ -0,0 +1,105 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+#include "xocl-host-lib.hpp"
+#include "device.hpp"
+#include "compute_unit.hpp"
+#include "sparse-io.hpp"
+#include "spmv-cpu.hpp"
+#include "validate.hpp"
+#include "module_pagerank.hpp"
+
+#include "profiling-infra.h"
+
+#include "xcl2.hpp"
+
+//----------------------------------------------------------------------------
+// CPU reference
+//----------------------------------------------------------------------------
+std::vector<float> compute_ref(
+    CSRMatrix<float> graph, float damping, unsigned iterations
+) {
+    normalize_csr_matrix_by_outdegree(graph);
+    CPUSpMVEngine<float> engine(graph);
+    std::vector<float> rank(graph.num_rows, 1.0f / graph.num_rows);
+    std::vector<float> next(graph.num_rows);
+    const float teleport = (1 - damping) / graph.num_rows;
+    for (unsigned i = 0; i < iterations; i++) {
+        engine.spmv(rank.data(), next.data());
+        for (auto &r : next) r = teleport + damping * r;
+        rank.swap(next);
+    }
+    return rank;
+}
+
+//----------------------------------------------------------------------------
+// Testbench
+//----------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    const float damping = 0.85;
+    // parse arguments
+    if(argc < 3) {
+        std::cout << "Usage : " << argv[0] << " <xclbin path> <dataset path> [tolerance] [max iterations]" << std::endl;
+        std::cout << "Aborting..." << std::endl;
+        return 1;
+    }
+    float tolerance = (argc > 3) ? std::stof(argv[3]) : 1e-4;
+    unsigned max_iterations = (argc > 4) ? std::stoul(argv[4]) : 100;
+
+    //--------------------------------------------------------------------
+    // loading graph data
+    //--------------------------------------------------------------------
+    std::cout << "INFO : Loading Dataset" << std::endl;
+    CSRMatrix<float> graph = load_csr_matrix_from_float_npz(argv[2]);
+
+    //--------------------------------------------------------------------
+    // Profiling Setup
+    //--------------------------------------------------------------------
+    TIMER_INIT(time);
+    Measure load_time;
+    Measure compute_time;
+
+    //--------------------------------------------------------------------
+    // Module Setup
+    //--------------------------------------------------------------------
+    std::cout << "INFO : PageRank Test" << std::endl;
+    std::vector<xhl::Device> devices = xhl::find_devices(
+        xhl::boards::alveo::u280::identifier
+    );
+    devices[0].program_device(argv[1]);
+
+    xhl::Module_pagerank module(damping, tolerance, max_iterations);
+    module.initialize(devices);
+    TIME_IT(time) {
+        module.load_graph(graph);
+    }
+    load_time.addSample(time);
+
+    xhl::aligned_vector<float> rank;
+    TIME_IT(time) {
+        rank = module.run();
+    }
+    compute_time.addSample(time);
+    std::cout << "INFO : Stopped after " << module.iterations() << " iterations, L1 delta "
+              << module.delta() << std::endl;
+
+    //--------------------------------------------------------------------
+    // compare result
+    //--------------------------------------------------------------------
+    std::vector<float> ref_result = compute_ref(graph, damping, module.iterations());
+    ValidationReport report = validate_results(rank, ref_result, 0, 1e-3);
+    print_validation_report(std::cout, report, rank.data(), ref_result.data());
+    bool pass = report.passed();
+    std::cout << (pass ? "[INFO]: Test Passed !" : "[ERROR]: Test Failed!") << std::endl;
+    std::cout << "\t\tTotal\t\tAvg\t\tMin\t\tMax" << std::endl;
+    std::cout << "Load:\t\t" << load_time << std::endl;
+    std::cout << "Compute:\t" << compute_time << std::endl;
+
+    std::cout << "INFO : PageRank module complete!" << std::endl;
+
+    return pass ? 0 : 1;
+}
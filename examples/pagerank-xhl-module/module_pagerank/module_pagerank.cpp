@@ -0,0 +1,197 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+
+#include "xocl-host-lib.hpp"
+#include "device.hpp"
+#include "compute_unit.hpp"
+#include "placement.hpp"
+#include "module_pagerank.hpp"
+
+namespace xhl{
+
+// chunks start on page boundaries of the rank buffers so they can be read back as sub-buffers
+const uint32_t CHUNK_ALIGNMENT = 4096 / sizeof(float);
+
+Module_pagerank::Module_pagerank(
+    float damping, float tolerance, unsigned max_iterations, uint32_t chunk_rows
+) : pagerank_cu(nullptr), _damping(damping), _tolerance(tolerance),
+    _max_iterations(max_iterations),
+    _chunk_rows(std::max(CHUNK_ALIGNMENT, chunk_rows / CHUNK_ALIGNMENT * CHUNK_ALIGNMENT)),
+    _iterations(0), _delta(0) {
+    this->_graph.num_rows = 0;
+    this->_graph.num_cols = 0;
+}
+
+void Module_pagerank::initialize(std::vector<Device>& devices) {
+    this->pagerank_cu = devices[0].find(this->pagerank);
+}
+
+void Module_pagerank::free_cu(){
+    delete this->pagerank_cu;
+    this->pagerank_cu = nullptr;
+}
+
+Module_pagerank::~Module_pagerank(){
+    this->free_cu();
+}
+
+void Module_pagerank::_release_buffers() {
+    auto device_1 = this->pagerank_cu->cu_device;
+    this->_chunks[0].clear();
+    this->_chunks[1].clear();
+    for (const char *name : {"values", "col_idx", "row_ptr", "rank_0", "rank_1"}) {
+        if (device_1->contains_buffer(name)) device_1->release_buffer(name);
+    }
+}
+
+void Module_pagerank::load_graph(const CSRMatrix<float> &graph) {
+    if (graph.num_rows != graph.num_cols) {
+        throw std::runtime_error(
+            "PageRank needs a square matrix, got " + std::to_string(graph.num_rows)
+            + "x" + std::to_string(graph.num_cols)
+        );
+    }
+    auto device_1 = this->pagerank_cu->cu_device;
+    device_1->finish_all_tasks();
+    this->_release_buffers();
+
+    this->_graph = graph;
+    normalize_csr_matrix_by_outdegree(this->_graph);
+    const uint32_t num_rows = this->_graph.num_rows;
+    const size_t nnz = this->_graph.adj_data.size();
+    this->_rank[0].assign(num_rows, 0);
+    this->_rank[1].assign(num_rows, 0);
+
+    const std::vector<int> pagerank_banks = {0, 1, 2, 3, 4, 5, 6, 7};
+    PlacementPlanner planner(boards::alveo::u280::HBM, 32, boards::alveo::u280::HBM_CHANNEL_SIZE);
+    planner.add_buffer({"values", nnz * sizeof(float), (double)nnz, pagerank_banks});
+    planner.add_buffer({"col_idx", nnz * sizeof(unsigned), (double)nnz, pagerank_banks});
+    planner.add_buffer({"row_ptr", (num_rows + 1) * sizeof(unsigned), (double)num_rows, pagerank_banks});
+    // either rank buffer is gathered from by one iteration and written by the next
+    planner.add_buffer({"rank_0", num_rows * sizeof(float), (double)nnz, pagerank_banks});
+    planner.add_buffer({"rank_1", num_rows * sizeof(float), (double)nnz, pagerank_banks});
+    this->_placement = planner.plan();
+    for (auto &placement : this->_placement) {
+        if (placement.second.segments.size() > 1) {
+            throw std::runtime_error(
+                "Buffer " + placement.first + " does not fit in one HBM channel"
+            );
+        }
+    }
+
+    // the graph never changes on the device, the ranks ping-pong between rank_0 and rank_1
+    create_placed_buffer(device_1, this->_placement["values"],
+        this->_graph.adj_data.data(), BufferType::ReadOnly);
+    create_placed_buffer(device_1, this->_placement["col_idx"],
+        this->_graph.adj_indices.data(), BufferType::ReadOnly);
+    create_placed_buffer(device_1, this->_placement["row_ptr"],
+        this->_graph.adj_indptr.data(), BufferType::ReadOnly);
+    create_placed_buffer(device_1, this->_placement["rank_0"],
+        this->_rank[0].data(), BufferType::ReadWrite);
+    create_placed_buffer(device_1, this->_placement["rank_1"],
+        this->_rank[1].data(), BufferType::ReadWrite);
+    nb_sync_data_htod(device_1, "values");
+    nb_sync_data_htod(device_1, "col_idx");
+    nb_sync_data_htod(device_1, "row_ptr");
+
+    for (int i = 0; i < 2; i++) {
+        cl::Buffer rank = device_1->get_buffer("rank_" + std::to_string(i));
+        for (uint32_t row = 0; row < num_rows; row += this->_chunk_rows) {
+            uint32_t n = std::min(this->_chunk_rows, num_rows - row);
+            cl_buffer_region region = {row * sizeof(float), n * sizeof(float)};
+            cl_int err = 0;
+            this->_chunks[i].push_back(rank.createSubBuffer(
+                CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION, &region, &err
+            ));
+            if (err != CL_SUCCESS) {
+                throw std::runtime_error(
+                    "Failed to create sub-buffer for rank chunk (code:" + std::to_string(err) + ")"
+                );
+            }
+        }
+    }
+}
+
+cl::Event Module_pagerank::_launch(unsigned iteration) {
+    auto device_1 = this->pagerank_cu->cu_device;
+    const uint32_t num_rows = this->_graph.num_rows;
+    // the input is only read, so reading back its chunks overlaps with this iteration
+    return this->pagerank_cu->launch(
+        device_1->get_buffer("values"),
+        device_1->get_buffer("col_idx"),
+        device_1->get_buffer("row_ptr"),
+        as_input(device_1->get_buffer("rank_" + std::to_string(iteration % 2))),
+        device_1->get_buffer("rank_" + std::to_string((iteration + 1) % 2)),
+        num_rows,
+        this->_damping,
+        (1 - this->_damping) / num_rows
+    );
+}
+
+std::vector<cl::Event> Module_pagerank::_read_back(unsigned iteration) {
+    auto device_1 = this->pagerank_cu->cu_device;
+    std::vector<cl::Event> events;
+    for (auto &chunk : this->_chunks[iteration % 2]) {
+        events.push_back(device_1->enqueue_dtoh(chunk));
+    }
+    return events;
+}
+
+float Module_pagerank::_check(unsigned iteration, std::vector<cl::Event> &chunks) {
+    const uint32_t num_rows = this->_graph.num_rows;
+    const float *rank = this->_rank[iteration % 2].data();
+    float *checked = this->_checked.data();
+    double delta = 0;
+    for (size_t c = 0; c < chunks.size(); c++) {
+        chunks[c].wait();
+        uint32_t begin = c * this->_chunk_rows;
+        uint32_t end = std::min(begin + this->_chunk_rows, num_rows);
+        double sum = 0;
+        for (uint32_t i = begin; i < end; i++) {
+            sum += std::fabs(rank[i] - checked[i]);
+            checked[i] = rank[i];
+        }
+        delta += sum;
+    }
+    return delta;
+}
+
+const aligned_vector<float> &Module_pagerank::run() {
+    if (this->_rank[0].empty()) {
+        throw std::runtime_error("No graph loaded, call load_graph first");
+    }
+    auto device_1 = this->pagerank_cu->cu_device;
+    const uint32_t num_rows = this->_graph.num_rows;
+    std::fill(this->_rank[0].begin(), this->_rank[0].end(), 1.0f / num_rows);
+    this->_checked.assign(this->_rank[0].begin(), this->_rank[0].end());
+    nb_sync_data_htod(device_1, "rank_0");
+
+    // iteration k turns the ranks x_k into x_(k+1). x_k is read back and
+    // checked while iteration k runs, since both only read its buffer.
+    unsigned k = 0;
+    this->_delta = 0;
+    if (this->_max_iterations > 0) this->_launch(0);
+    for (k = 1; k <= this->_max_iterations; k++) {
+        std::vector<cl::Event> chunks = this->_read_back(k);
+        if (k < this->_max_iterations) this->_launch(k);
+        this->_delta = this->_check(k, chunks);
+        if (this->_delta < this->_tolerance) break;
+    }
+    this->_iterations = std::min(k, this->_max_iterations);
+    // drop the iteration still running on the device
+    device_1->finish_compute_tasks();
+    return this->_rank[this->_iterations % 2];
+}
+
+unsigned Module_pagerank::iterations() const {
+    return this->_iterations;
+}
+
+float Module_pagerank::delta() const {
+    return this->_delta;
+}
+
+} // namespace xhl
@@ -0,0 +1,107 @@
+#ifndef MODULE_PAGERANK_HPP
+#define MODULE_PAGERANK_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+
+#include "xocl-host-lib.hpp"
+#include "compute_unit.hpp"
+#include "module.hpp"
+#include "device.hpp"
+#include "placement.hpp"
+#include "sparse-io.hpp"
+
+namespace xhl{
+/**
+ * @brief PageRank on the FPGA. The normalized graph stays resident on the
+ * device and the ranks ping-pong between two device buffers. While an
+ * iteration runs, the host reads back the ranks of the previous one in
+ * chunks and checks convergence on each chunk as soon as it arrives.
+ */
+class Module_pagerank : public xhl::Module {
+    public:
+    ComputeUnit* pagerank_cu;
+
+    const KernelSignature pagerank = {
+        "pagerank", {
+            {"values", "float*"},
+            {"col_idx", "unsigned*"},
+            {"row_ptr", "unsigned*"},
+            {"rank_in", "float*"},
+            {"rank_out", "float*"},
+            {"num_rows", "unsigned"},
+            {"damping", "float"},
+            {"teleport", "float"}
+        }
+    };
+
+    /**
+     * @brief constructor
+     *
+     * @param damping the damping factor
+     * @param tolerance stop once the L1 norm of the rank change is below it
+     * @param max_iterations the maximum number of iterations
+     * @param chunk_rows the number of ranks read back per chunk
+     */
+    Module_pagerank(
+        float damping = 0.85, float tolerance = 1e-4,
+        unsigned max_iterations = 100, uint32_t chunk_rows = 1 << 18
+    );
+
+    void initialize(std::vector<Device>& devices) override;
+
+    void free_cu() override;
+
+    ~Module_pagerank();
+
+    /**
+     * @brief normalize a copy of the graph by out-degree and upload it, it
+     * stays resident on the device for all runs
+     *
+     * @param graph square adjacency matrix, row i lists the in-neighbours of vertex i
+     *
+     * @exception std::runtime_error if the matrix is not square
+     */
+    void load_graph(const CSRMatrix<float> &graph);
+
+    /**
+     * @brief iterate from uniform ranks until convergence or the maximum
+     * number of iterations. The check of an iteration overlaps with the next
+     * one on the device, which is discarded once the check passes.
+     *
+     * @return the ranks, valid until the next run or load_graph
+     */
+    const aligned_vector<float> &run();
+
+    /**
+     * @brief get the number of iterations of the last run
+     */
+    unsigned iterations() const;
+
+    /**
+     * @brief get the L1 norm of the last rank change of the last run
+     */
+    float delta() const;
+
+    private:
+    float _damping;
+    float _tolerance;
+    unsigned _max_iterations;
+    uint32_t _chunk_rows;
+    CSRMatrix<float> _graph;
+    std::map<std::string, BufferPlacement> _placement;
+    aligned_vector<float> _rank[2];
+    std::vector<cl::Buffer> _chunks[2]; // sub-buffers of rank_0 and rank_1
+    std::vector<float> _checked; // host copy of the last ranks checked for convergence
+    unsigned _iterations;
+    float _delta;
+
+    void _release_buffers();
+    cl::Event _launch(unsigned iteration);
+    std::vector<cl::Event> _read_back(unsigned iteration);
+    float _check(unsigned iteration, std::vector<cl::Event> &chunks);
+};
+} // namespace xhl
+#endif // MODULE_PAGERANK_HPP
@@ -0,0 +1,2 @@
+module_pagerank_CXXFLAGS += -I$(XOCL_HOST_LIB)/examples/pagerank-xhl-module/module_pagerank
+module_pagerank_SRCS += $(XOCL_HOST_LIB)/examples/pagerank-xhl-module/module_pagerank/module_pagerank.cpp
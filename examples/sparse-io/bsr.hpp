@@ -0,0 +1,329 @@
+#ifndef BSR_HPP
+#define BSR_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "sparse-io.hpp"
+#include "parallel-for.hpp"
+#include "semiring.hpp"
+
+//--------------------------------------------------
+// Block Sparse Row (BSR) format support
+//--------------------------------------------------
+
+// The matrix is cut into square blocks of block_size x block_size and every block holding a
+// non-zero is stored densely, with a single column index. Matrices with dense sub-blocks (e.g.,
+// FEM or GNN matrices with 4x4 or 8x8 blocks) move one index per block instead of one per non-zero.
+// The entries of a block missing from the csr matrix hold semiring::zero(), and so do the entries
+// of the last block row and column beyond the matrix.
+
+// Data structure for bsr matrix.
+template<typename data_type>
+struct BSRMatrix {
+    /*! \brief The number of rows of the sparse matrix */
+    uint32_t num_rows;
+    /*! \brief The number of columns of the sparse matrix */
+    uint32_t num_cols;
+    /*! \brief The number of rows (and columns) of a block */
+    uint32_t block_size;
+    /*! \brief The number of block rows, num_rows / block_size rounded up */
+    uint32_t num_block_rows;
+    /*! \brief The blocks, block_size * block_size row-major entries each */
+    std::vector<data_type> adj_data;
+    /*! \brief The block column of each block */
+    std::vector<uint32_t> adj_indices;
+    /*! \brief The block index pointers of each block row */
+    std::vector<uint32_t> adj_indptr;
+
+    uint32_t num_blocks() const { return this->adj_indices.size(); }
+    uint32_t num_block_cols() const { return (this->num_cols + this->block_size - 1) / this->block_size; }
+};
+
+
+// The number of distinct blocks of each block row of a csr matrix, on num_threads threads (0 means
+// all cores).
+template<typename data_type>
+std::vector<uint32_t> count_bsr_blocks(CSRMatrix<data_type> const &csr, uint32_t block_size,
+                                       unsigned num_threads = 0) {
+    uint32_t num_block_rows = (csr.num_rows + block_size - 1) / block_size;
+    uint32_t num_block_cols = (csr.num_cols + block_size - 1) / block_size;
+    std::vector<uint32_t> counts(num_block_rows);
+    if (num_threads == 0) num_threads = default_num_threads();
+    parallel_for(0, num_block_rows, num_threads, [&](size_t begin, size_t end, unsigned) {
+        // stamp[bc] == br once block (br, bc) is counted
+        std::vector<uint32_t> stamp(num_block_cols, UINT32_MAX);
+        for (size_t br = begin; br < end; br++) {
+            uint32_t count = 0;
+            uint32_t row_end = std::min<uint64_t>(csr.num_rows, (br + 1) * block_size);
+            for (uint32_t e = csr.adj_indptr[br * block_size]; e < csr.adj_indptr[row_end]; e++) {
+                uint32_t bc = csr.adj_indices[e] / block_size;
+                if (stamp[bc] != br) {
+                    stamp[bc] = br;
+                    count++;
+                }
+            }
+            counts[br] = count;
+        }
+    }, 64);
+    return counts;
+}
+
+
+// Pick the block size among candidates that moves the fewest bytes (values and indices) for a csr
+// matrix, or 1 if no block size beats the csr matrix itself.
+template<typename data_type>
+uint32_t detect_bsr_block_size(CSRMatrix<data_type> const &csr,
+                               std::initializer_list<uint32_t> candidates = {8, 4, 2},
+                               unsigned num_threads = 0) {
+    uint64_t nnz = csr.adj_indices.size();
+    uint64_t best_bytes = nnz * (sizeof(data_type) + sizeof(uint32_t))
+                        + (uint64_t)(csr.num_rows + 1) * sizeof(uint32_t);
+    uint32_t best = 1;
+    for (uint32_t block_size : candidates) {
+        std::vector<uint32_t> counts = count_bsr_blocks(csr, block_size, num_threads);
+        uint64_t blocks = 0;
+        for (uint32_t c : counts) blocks += c;
+        uint64_t bytes = blocks * (block_size * block_size * sizeof(data_type) + sizeof(uint32_t))
+                       + (uint64_t)(counts.size() + 1) * sizeof(uint32_t);
+        if (bytes < best_bytes) {
+            best_bytes = bytes;
+            best = block_size;
+        }
+    }
+    return best;
+}
+
+
+// Convert csr to bsr on num_threads threads (0 means all cores). The blocks of a block row are in
+// increasing column order.
+template<typename data_type, typename semiring = PlusTimes<data_type>>
+BSRMatrix<data_type> csr2bsr(CSRMatrix<data_type> const &csr, uint32_t block_size, unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    BSRMatrix<data_type> bsr;
+    bsr.num_rows = csr.num_rows;
+    bsr.num_cols = csr.num_cols;
+    bsr.block_size = block_size;
+    bsr.num_block_rows = (csr.num_rows + block_size - 1) / block_size;
+    uint32_t num_block_cols = bsr.num_block_cols();
+    uint32_t block_area = block_size * block_size;
+
+    std::vector<uint32_t> counts = count_bsr_blocks(csr, block_size, num_threads);
+    bsr.adj_indptr.resize(bsr.num_block_rows + 1);
+    uint64_t total = 0;
+    bsr.adj_indptr[0] = 0;
+    for (uint32_t br = 0; br < bsr.num_block_rows; br++) {
+        total += counts[br];
+        if (total * block_area > UINT32_MAX) {
+            throw std::runtime_error("BSR blocks exceed 32-bit indices");
+        }
+        bsr.adj_indptr[br + 1] = total;
+    }
+    bsr.adj_indices.resize(total);
+    bsr.adj_data.resize(total * block_area);
+
+    parallel_for(0, bsr.num_block_rows, num_threads, [&](size_t begin, size_t end, unsigned) {
+        // slot[bc] is the block of column bc in the current block row, valid if stamp[bc] == br
+        std::vector<uint32_t> stamp(num_block_cols, UINT32_MAX);
+        std::vector<uint32_t> slot(num_block_cols);
+        for (size_t br = begin; br < end; br++) {
+            uint32_t first = bsr.adj_indptr[br];
+            uint32_t row_begin = br * block_size;
+            uint32_t row_end = std::min<uint64_t>(csr.num_rows, (br + 1) * block_size);
+            uint32_t n = first;
+            for (uint32_t e = csr.adj_indptr[row_begin]; e < csr.adj_indptr[row_end]; e++) {
+                uint32_t bc = csr.adj_indices[e] / block_size;
+                if (stamp[bc] != br) {
+                    stamp[bc] = br;
+                    bsr.adj_indices[n++] = bc;
+                }
+            }
+            std::sort(bsr.adj_indices.begin() + first, bsr.adj_indices.begin() + n);
+            for (uint32_t k = first; k < n; k++) {
+                slot[bsr.adj_indices[k]] = k;
+            }
+            std::fill(bsr.adj_data.begin() + (size_t)first * block_area,
+                      bsr.adj_data.begin() + (size_t)n * block_area, semiring::zero());
+            for (uint32_t r = row_begin; r < row_end; r++) {
+                for (uint32_t e = csr.adj_indptr[r]; e < csr.adj_indptr[r + 1]; e++) {
+                    uint32_t c = csr.adj_indices[e];
+                    size_t pos = (size_t)slot[c / block_size] * block_area
+                               + (r - row_begin) * block_size + c % block_size;
+                    bsr.adj_data[pos] = csr.adj_data[e];
+                }
+            }
+        }
+    }, 64);
+    return bsr;
+}
+
+
+// The fraction of stored block entries that are non-zeros of the csr matrix.
+template<typename data_type>
+double bsr_fill_ratio(BSRMatrix<data_type> const &bsr, uint64_t nnz) {
+    uint64_t stored = (uint64_t)bsr.num_blocks() * bsr.block_size * bsr.block_size;
+    return stored ? (double)nnz / stored : 1.0;
+}
+
+
+// Row boundaries splitting the block rows into num_parts ranges of about the same number of blocks,
+// e.g., one per HBM channel. Returns num_parts + 1 block row boundaries.
+template<typename data_type>
+std::vector<uint32_t> partition_bsr_block_rows(BSRMatrix<data_type> const &bsr, size_t num_parts) {
+    std::vector<uint32_t> bounds(num_parts + 1);
+    uint64_t total = (uint64_t)bsr.num_blocks() + bsr.num_block_rows;
+    for (size_t p = 0; p < num_parts; p++) {
+        uint64_t target = total * p / num_parts;
+        // first block row whose prefix cost (blocks plus one per block row) reaches the target
+        uint32_t lo = p ? bounds[p - 1] : 0, hi = bsr.num_block_rows;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if ((uint64_t)bsr.adj_indptr[mid] + mid < target) lo = mid + 1;
+            else hi = mid;
+        }
+        bounds[p] = lo;
+    }
+    bounds[num_parts] = bsr.num_block_rows;
+    return bounds;
+}
+
+
+// Copy the block rows [begin, end) into a bsr matrix of their own, covering rows
+// [begin * block_size, ...) of the original matrix and all of its columns.
+template<typename data_type>
+BSRMatrix<data_type> slice_bsr_block_rows(BSRMatrix<data_type> const &bsr, uint32_t begin, uint32_t end) {
+    BSRMatrix<data_type> slice;
+    uint32_t block_area = bsr.block_size * bsr.block_size;
+    uint32_t first = bsr.adj_indptr[begin];
+    slice.num_rows = std::min<uint64_t>(bsr.num_rows, (uint64_t)end * bsr.block_size) - begin * bsr.block_size;
+    slice.num_cols = bsr.num_cols;
+    slice.block_size = bsr.block_size;
+    slice.num_block_rows = end - begin;
+    slice.adj_indices.assign(bsr.adj_indices.begin() + first, bsr.adj_indices.begin() + bsr.adj_indptr[end]);
+    slice.adj_data.assign(bsr.adj_data.begin() + (size_t)first * block_area,
+                          bsr.adj_data.begin() + (size_t)bsr.adj_indptr[end] * block_area);
+    slice.adj_indptr.resize(end - begin + 1);
+    for (uint32_t br = begin; br <= end; br++) {
+        slice.adj_indptr[br - begin] = bsr.adj_indptr[br] - first;
+    }
+    return slice;
+}
+
+
+//--------------------------------------------------
+// CPU BSR SpMV
+//--------------------------------------------------
+
+#if defined(__AVX2__) && defined(__FMA__)
+// One float block row of 8x8 blocks: a lane-wise product per block row, summed once at the end.
+inline void spmv_bsr8_row(const float *blocks, const uint32_t *indices, uint32_t num_blocks,
+                          const float *vector_in, float *res) {
+    __m256 acc[8];
+    for (int r = 0; r < 8; r++) acc[r] = _mm256_setzero_ps();
+    for (uint32_t k = 0; k < num_blocks; k++) {
+        __m256 x = _mm256_loadu_ps(vector_in + (size_t)indices[k] * 8);
+        const float *block = blocks + (size_t)k * 64;
+        for (int r = 0; r < 8; r++) {
+            acc[r] = _mm256_fmadd_ps(_mm256_loadu_ps(block + r * 8), x, acc[r]);
+        }
+    }
+    // transpose-free horizontal sums of the 8 accumulators
+    __m256 s01 = _mm256_hadd_ps(acc[0], acc[1]);
+    __m256 s23 = _mm256_hadd_ps(acc[2], acc[3]);
+    __m256 s45 = _mm256_hadd_ps(acc[4], acc[5]);
+    __m256 s67 = _mm256_hadd_ps(acc[6], acc[7]);
+    __m256 s0123 = _mm256_hadd_ps(s01, s23);
+    __m256 s4567 = _mm256_hadd_ps(s45, s67);
+    __m256 lo = _mm256_permute2f128_ps(s0123, s4567, 0x20);
+    __m256 hi = _mm256_permute2f128_ps(s0123, s4567, 0x31);
+    _mm256_storeu_ps(res, _mm256_add_ps(lo, hi));
+}
+
+
+// One float block row of 4x4 blocks: two block rows of a block share a register.
+inline void spmv_bsr4_row(const float *blocks, const uint32_t *indices, uint32_t num_blocks,
+                          const float *vector_in, float *res) {
+    __m256 acc01 = _mm256_setzero_ps();
+    __m256 acc23 = _mm256_setzero_ps();
+    for (uint32_t k = 0; k < num_blocks; k++) {
+        __m128 x4 = _mm_loadu_ps(vector_in + (size_t)indices[k] * 4);
+        __m256 x = _mm256_set_m128(x4, x4);
+        const float *block = blocks + (size_t)k * 16;
+        acc01 = _mm256_fmadd_ps(_mm256_loadu_ps(block), x, acc01);
+        acc23 = _mm256_fmadd_ps(_mm256_loadu_ps(block + 8), x, acc23);
+    }
+    // lanes: [r0 r0 r0 r0 r1 r1 r1 r1] and [r2 ... r3 ...]
+    __m256 s = _mm256_hadd_ps(acc01, acc23); // [r0 r0 r2 r2 r1 r1 r3 r3]
+    s = _mm256_hadd_ps(s, s);                // [r0 r2 r0 r2 r1 r3 r1 r3]
+    __m128 v = _mm_unpacklo_ps(_mm256_castps256_ps128(s), _mm256_extractf128_ps(s, 1)); // [r0 r1 r2 r3]
+    _mm_storeu_ps(res, v);
+}
+#endif
+
+
+// Compute the rows of block rows [block_row_begin, block_row_end) of mat * vector_in on the
+// calling thread. Float 8x8 and 4x4 blocks use AVX2 when built with it (e.g., -march=native),
+// except for the last block column when num_cols is not a multiple of the block size.
+template<typename data_type, typename semiring = PlusTimes<data_type>>
+void spmv_bsr_rows(BSRMatrix<data_type> const &bsr, const data_type *vector_in, data_type *vector_out,
+                   uint32_t block_row_begin, uint32_t block_row_end) {
+    const uint32_t b = bsr.block_size;
+    const uint32_t block_area = b * b;
+    const uint32_t full_block_cols = bsr.num_cols / b;
+    std::vector<data_type> res(b);
+    for (uint32_t br = block_row_begin; br < block_row_end; br++) {
+        uint32_t k = bsr.adj_indptr[br];
+        uint32_t end = bsr.adj_indptr[br + 1];
+        // blocks within the columns of the matrix come first, blocks of a row are sorted
+        uint32_t full_end = k;
+        while (full_end < end && bsr.adj_indices[full_end] < full_block_cols) full_end++;
+        std::fill(res.begin(), res.end(), semiring::zero());
+#if defined(__AVX2__) && defined(__FMA__)
+        if constexpr (std::is_same<data_type, float>::value && std::is_same<semiring, PlusTimes<float>>::value) {
+            if (b == 8 || b == 4) {
+                (b == 8 ? spmv_bsr8_row : spmv_bsr4_row)(
+                    bsr.adj_data.data() + (size_t)k * block_area, bsr.adj_indices.data() + k,
+                    full_end - k, vector_in, res.data());
+                k = full_end;
+            }
+        }
+#endif
+        for (; k < end; k++) {
+            uint32_t col = bsr.adj_indices[k] * b;
+            uint32_t width = std::min(b, bsr.num_cols - col);
+            const data_type *block = bsr.adj_data.data() + (size_t)k * block_area;
+            for (uint32_t r = 0; r < b; r++) {
+                for (uint32_t c = 0; c < width; c++) {
+                    res[r] = semiring::add(res[r], semiring::mul(block[r * b + c], vector_in[col + c]));
+                }
+            }
+        }
+        uint32_t height = std::min(b, bsr.num_rows - br * b);
+        std::copy(res.begin(), res.begin() + height, vector_out + (size_t)br * b);
+    }
+}
+
+
+// Compute mat * vector_in on num_threads threads (0 means all cores), balancing the threads by blocks.
+template<typename data_type, typename semiring = PlusTimes<data_type>>
+void spmv_bsr_parallel(BSRMatrix<data_type> const &bsr, const data_type *vector_in, data_type *vector_out,
+                       unsigned num_threads = 0) {
+    if (bsr.num_block_rows == 0) return;
+    if (num_threads == 0) num_threads = default_num_threads();
+    size_t work = (size_t)bsr.num_blocks() * bsr.block_size * bsr.block_size;
+    num_threads = std::max<size_t>(1, std::min<size_t>({num_threads, bsr.num_block_rows, (work + 4095) / 4096}));
+    std::vector<uint32_t> bounds = partition_bsr_block_rows(bsr, num_threads);
+    parallel_run(num_threads, [&](unsigned t) {
+        spmv_bsr_rows<data_type, semiring>(bsr, vector_in, vector_out, bounds[t], bounds[t + 1]);
+    });
+}
+
+#endif  // BSR_HPP
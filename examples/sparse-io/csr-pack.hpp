@@ -0,0 +1,118 @@
+#ifndef CSR_PACK_HPP
+#define CSR_PACK_HPP
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "sparse-io.hpp"
+#include "parallel-for.hpp"
+
+//--------------------------------------------------
+// Packing many small csr matrices into one
+//--------------------------------------------------
+
+// Many independent matrices (e.g., the graphs of a GNN inference batch) packed into one
+// block-diagonal csr matrix, so that they need a single upload and a single SpMV launch.
+template<typename data_type>
+struct PackedCSRMatrix {
+    /*! \brief The block-diagonal matrix holding all packed matrices */
+    CSRMatrix<data_type> matrix;
+    /*! \brief The first row of each packed matrix, plus the total number of rows */
+    std::vector<uint32_t> row_offsets;
+    /*! \brief The first column of each packed matrix, plus the total number of columns */
+    std::vector<uint32_t> col_offsets;
+    /*! \brief The first non-zero of each packed matrix, plus the total number of non-zeros */
+    std::vector<uint32_t> nnz_offsets;
+
+    size_t num_matrices() const { return row_offsets.size() - 1; }
+};
+
+
+// A slice of a packed vector, which reads and writes the packed storage in place.
+template<typename data_type>
+struct ArrayView {
+    /*! \brief The first entry of the slice */
+    data_type *data;
+    /*! \brief The number of entries of the slice */
+    size_t size;
+
+    data_type &operator[](size_t i) const { return data[i]; }
+    data_type *begin() const { return data; }
+    data_type *end() const { return data + size; }
+};
+
+
+// Pack matrices along the diagonal on num_threads threads (0 means all cores). Matrix m covers
+// rows [row_offsets[m], row_offsets[m + 1]) and columns [col_offsets[m], col_offsets[m + 1]).
+template<typename data_type>
+PackedCSRMatrix<data_type> pack_csr_matrices(std::vector<CSRMatrix<data_type>> const &matrices,
+                                             unsigned num_threads = 0) {
+    PackedCSRMatrix<data_type> packed;
+    const size_t count = matrices.size();
+    packed.row_offsets.resize(count + 1);
+    packed.col_offsets.resize(count + 1);
+    packed.nnz_offsets.resize(count + 1);
+    uint64_t rows = 0, cols = 0, nnz = 0;
+    for (size_t m = 0; m < count; m++) {
+        packed.row_offsets[m] = rows;
+        packed.col_offsets[m] = cols;
+        packed.nnz_offsets[m] = nnz;
+        rows += matrices[m].num_rows;
+        cols += matrices[m].num_cols;
+        nnz += matrices[m].adj_indptr[matrices[m].num_rows];
+    }
+    if (rows >= UINT32_MAX || cols >= UINT32_MAX || nnz >= UINT32_MAX) {
+        throw std::runtime_error(
+            "Packed matrix exceeds 32-bit indices (" + std::to_string(nnz) + " non-zeros)"
+        );
+    }
+    packed.row_offsets[count] = rows;
+    packed.col_offsets[count] = cols;
+    packed.nnz_offsets[count] = nnz;
+
+    CSRMatrix<data_type> &out = packed.matrix;
+    out.num_rows = rows;
+    out.num_cols = cols;
+    out.adj_data.resize(nnz);
+    out.adj_indices.resize(nnz);
+    out.adj_indptr.resize(rows + 1);
+    out.adj_indptr[rows] = nnz;
+    if (num_threads == 0) num_threads = default_num_threads();
+    // every matrix lands in its own ranges, so the matrices are copied independently
+    parallel_for(0, count, num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t m = begin; m < end; m++) {
+            const CSRMatrix<data_type> &in = matrices[m];
+            uint32_t row0 = packed.row_offsets[m], col0 = packed.col_offsets[m];
+            uint32_t nnz0 = packed.nnz_offsets[m];
+            uint32_t in_nnz = in.adj_indptr[in.num_rows];
+            std::copy(in.adj_data.begin(), in.adj_data.begin() + in_nnz, out.adj_data.begin() + nnz0);
+            for (uint32_t i = 0; i < in_nnz; i++) {
+                out.adj_indices[nnz0 + i] = in.adj_indices[i] + col0;
+            }
+            for (uint32_t r = 0; r < in.num_rows; r++) {
+                out.adj_indptr[row0 + r] = in.adj_indptr[r] + nnz0;
+            }
+        }
+    }, 64);
+    return packed;
+}
+
+
+// The rows of packed matrix m in a vector of packed.matrix.num_rows entries (e.g., the SpMV output).
+template<typename data_type, typename vector_type>
+ArrayView<data_type> packed_rows_view(PackedCSRMatrix<data_type> const &packed, size_t m,
+                                      vector_type &vector) {
+    return {vector.data() + packed.row_offsets[m], (size_t)packed.row_offsets[m + 1] - packed.row_offsets[m]};
+}
+
+
+// The columns of packed matrix m in a vector of packed.matrix.num_cols entries (e.g., the SpMV input).
+template<typename data_type, typename vector_type>
+ArrayView<data_type> packed_cols_view(PackedCSRMatrix<data_type> const &packed, size_t m,
+                                      vector_type &vector) {
+    return {vector.data() + packed.col_offsets[m], (size_t)packed.col_offsets[m + 1] - packed.col_offsets[m]};
+}
+
+#endif  // CSR_PACK_HPP
@@ -0,0 +1,252 @@
+#ifndef CSR_PARTITION_HPP
+#define CSR_PARTITION_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "sparse-io.hpp"
+#include "parallel-for.hpp"
+#include "spmv-cpu.hpp"
+#include "semiring.hpp"
+
+//--------------------------------------------------
+// Row partitions with 32-bit local indices
+//--------------------------------------------------
+
+// A block of consecutive rows of a larger matrix, re-indexed for one device: the rows are numbered
+// from row_begin and the index pointers restart at 0. The whole matrix may need 64-bit offsets, a
+// partition does not, so the devices keep reading 4 bytes per index pointer and column index.
+template<typename data_type>
+struct CSRRowPartition {
+    /*! \brief The first row of the partition in the whole matrix */
+    uint64_t row_begin;
+    /*! \brief The rows [row_begin, row_begin + local.num_rows) of the whole matrix */
+    CSRMatrix<data_type> local;
+};
+
+
+// Cut a csr matrix of any index widths into row partitions at the given boundaries (the first and
+// the last being 0 and num_rows). Throws if a partition holds 2^32 non-zeros or more (use more
+// partitions), or if the columns do not fit 32-bit indices.
+template<typename data_type, typename index_type, typename offset_type>
+std::vector<CSRRowPartition<data_type>>
+partition_csr_rows(CSRMatrix<data_type, index_type, offset_type> const &csr, std::vector<uint64_t> const &bounds) {
+    if (uint64_t(csr.num_cols) > UINT32_MAX) {
+        throw std::runtime_error("Matrix of " + std::to_string(csr.num_cols)
+                                 + " columns exceeds 32-bit local column indices");
+    }
+    if (bounds.size() < 2 || bounds.front() != 0 || bounds.back() != uint64_t(csr.num_rows)) {
+        throw std::runtime_error("Row partition boundaries must go from 0 to the number of rows");
+    }
+    size_t num_parts = bounds.size() - 1;
+    for (size_t p = 0; p < num_parts; p++) {
+        if (bounds[p] > bounds[p + 1]) {
+            throw std::runtime_error("Row partition boundaries must be sorted");
+        }
+        uint64_t nnz = uint64_t(csr.adj_indptr[bounds[p + 1]]) - csr.adj_indptr[bounds[p]];
+        if (nnz > UINT32_MAX || bounds[p + 1] - bounds[p] > UINT32_MAX) {
+            throw std::runtime_error("Row partition " + std::to_string(p) + " of " + std::to_string(nnz)
+                                     + " non-zeros exceeds 32-bit local indices, use more partitions");
+        }
+    }
+    std::vector<CSRRowPartition<data_type>> parts(num_parts);
+    unsigned num_threads = std::min<size_t>(num_parts, default_num_threads());
+    parallel_run(num_threads, [&](unsigned t) {
+        for (size_t p = t; p < num_parts; p += num_threads) {
+            uint64_t row_begin = bounds[p];
+            uint64_t row_end = bounds[p + 1];
+            uint64_t first = csr.adj_indptr[row_begin];
+            uint64_t last = csr.adj_indptr[row_end];
+            parts[p].row_begin = row_begin;
+            CSRMatrix<data_type> &local = parts[p].local;
+            local.num_rows = row_end - row_begin;
+            local.num_cols = csr.num_cols;
+            local.adj_data.assign(csr.adj_data.begin() + first, csr.adj_data.begin() + last);
+            local.adj_indices.assign(csr.adj_indices.begin() + first, csr.adj_indices.begin() + last);
+            local.adj_indptr.resize(local.num_rows + 1);
+            for (uint64_t r = row_begin; r <= row_end; r++) {
+                local.adj_indptr[r - row_begin] = csr.adj_indptr[r] - first;
+            }
+        }
+    });
+    return parts;
+}
+
+
+// Cut a csr matrix into num_parts row partitions of about the same number of non-zeros, e.g., one
+// per device. See partition_csr_rows above for the limits of a partition.
+template<typename data_type, typename index_type, typename offset_type>
+std::vector<CSRRowPartition<data_type>>
+partition_csr_rows_by_nnz(CSRMatrix<data_type, index_type, offset_type> const &csr, size_t num_parts) {
+    std::vector<index_type> bounds = partition_rows_by_nnz(csr, num_parts);
+    return partition_csr_rows(csr, std::vector<uint64_t>(bounds.begin(), bounds.end()));
+}
+
+
+// The fewest nnz-balanced row partitions that could fit 32-bit local indices. Heavy rows can make
+// the balance uneven, so partition_csr_rows_by_nnz may still need one more.
+template<typename data_type, typename index_type, typename offset_type>
+size_t min_partitions_for_32bit_indices(CSRMatrix<data_type, index_type, offset_type> const &csr) {
+    uint64_t nnz = csr.adj_indices.size();
+    return std::max<uint64_t>(1, (nnz + UINT32_MAX - 1) / UINT32_MAX);
+}
+
+
+//--------------------------------------------------
+// Tiles with compacted column sets
+//--------------------------------------------------
+
+// A tile of a matrix keeping only the columns it references, renumbered in increasing order. A
+// device running the tile only needs those entries of vector_in: gather them with
+// gather_tile_vector, upload col_map.size() values instead of num_cols.
+template<typename data_type>
+struct CompactCSRTile {
+    /*! \brief The first row of the tile in the whole matrix */
+    uint64_t row_begin;
+    /*! \brief The tile, with local.num_cols = col_map.size() */
+    CSRMatrix<data_type> local;
+    /*! \brief The column of the whole matrix behind each local column, increasing */
+    std::vector<uint32_t> col_map;
+};
+
+
+// Renumber the columns of a matrix in place to the columns it references, and return the column
+// behind each new index. The referenced columns are marked in a bitmap, so the pass is linear and
+// the remap needs no num_cols table: the new index of a column is the number of marked columns
+// before it, a prefix count per 64-bit word plus a popcount.
+template<typename data_type>
+std::vector<uint32_t> compact_columns(CSRMatrix<data_type> &tile, unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    size_t num_words = (size_t(tile.num_cols) + 63) / 64;
+    std::vector<std::atomic<uint64_t>> bitmap(num_words);
+    parallel_for(0, num_words, num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t w = begin; w < end; w++) {
+            bitmap[w].store(0, std::memory_order_relaxed);
+        }
+    });
+    parallel_for(0, tile.adj_indices.size(), num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t k = begin; k < end; k++) {
+            uint32_t c = tile.adj_indices[k];
+            uint64_t bit = uint64_t(1) << (c % 64);
+            if (!(bitmap[c / 64].load(std::memory_order_relaxed) & bit)) {
+                bitmap[c / 64].fetch_or(bit, std::memory_order_relaxed);
+            }
+        }
+    });
+    std::vector<uint32_t> word_rank(num_words + 1, 0);
+    for (size_t w = 0; w < num_words; w++) {
+        word_rank[w + 1] = word_rank[w] + __builtin_popcountll(bitmap[w].load(std::memory_order_relaxed));
+    }
+    std::vector<uint32_t> col_map(word_rank[num_words]);
+    parallel_for(0, num_words, num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t w = begin; w < end; w++) {
+            uint64_t bits = bitmap[w].load(std::memory_order_relaxed);
+            for (uint32_t i = word_rank[w]; bits != 0; i++, bits &= bits - 1) {
+                col_map[i] = w * 64 + __builtin_ctzll(bits);
+            }
+        }
+    });
+    parallel_for(0, tile.adj_indices.size(), num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t k = begin; k < end; k++) {
+            uint32_t c = tile.adj_indices[k];
+            uint64_t below = bitmap[c / 64].load(std::memory_order_relaxed) & ((uint64_t(1) << (c % 64)) - 1);
+            tile.adj_indices[k] = word_rank[c / 64] + __builtin_popcountll(below);
+        }
+    });
+    tile.num_cols = col_map.size();
+    return col_map;
+}
+
+
+// Cut a matrix into a grid of tiles, row block i and column block j at tiles[i * num_col_blocks + j],
+// each with 32-bit local indices and compacted columns. row_bounds and col_bounds go from 0 to
+// num_rows and num_cols. A single column block gives row partitions whose devices only receive
+// the columns they read; more column blocks bound the vector of a tile, and the partial results
+// of a row block are then reduced over its tiles, e.g., with reduce_tile_results.
+template<typename data_type, typename index_type, typename offset_type>
+std::vector<CompactCSRTile<data_type>>
+partition_csr_2d(CSRMatrix<data_type, index_type, offset_type> const &csr, std::vector<uint64_t> const &row_bounds,
+                 std::vector<uint64_t> const &col_bounds, unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    if (col_bounds.size() < 2 || col_bounds.front() != 0 || col_bounds.back() != uint64_t(csr.num_cols)) {
+        throw std::runtime_error("Column block boundaries must go from 0 to the number of columns");
+    }
+    std::vector<CSRRowPartition<data_type>> parts = partition_csr_rows(csr, row_bounds);
+    size_t num_col_blocks = col_bounds.size() - 1;
+    std::vector<CompactCSRTile<data_type>> tiles(parts.size() * num_col_blocks);
+    unsigned tile_threads = std::min<size_t>(tiles.size(), num_threads);
+    parallel_run(tile_threads, [&](unsigned t) {
+        for (size_t i = t; i < tiles.size(); i += tile_threads) {
+            CSRMatrix<data_type> const &rows = parts[i / num_col_blocks].local;
+            uint64_t col_begin = col_bounds[i % num_col_blocks];
+            uint64_t col_end = col_bounds[i % num_col_blocks + 1];
+            CompactCSRTile<data_type> &tile = tiles[i];
+            tile.row_begin = parts[i / num_col_blocks].row_begin;
+            tile.local.num_rows = rows.num_rows;
+            tile.local.num_cols = rows.num_cols;
+            tile.local.adj_indptr.assign(size_t(rows.num_rows) + 1, 0);
+            for (uint32_t r = 0; r < rows.num_rows; r++) {
+                for (uint32_t k = rows.adj_indptr[r]; k < rows.adj_indptr[r + 1]; k++) {
+                    if (rows.adj_indices[k] >= col_begin && rows.adj_indices[k] < col_end) {
+                        tile.local.adj_indices.push_back(rows.adj_indices[k]);
+                        tile.local.adj_data.push_back(rows.adj_data[k]);
+                    }
+                }
+                tile.local.adj_indptr[r + 1] = tile.local.adj_indices.size();
+            }
+            tile.col_map = compact_columns(tile.local, 1);
+        }
+    });
+    return tiles;
+}
+
+
+// Gather the entries of vector_in a tile reads, out[i] = vector_in[col_map[i]], with AVX2 gathers
+// for float vectors (col_map below 2^31).
+template<typename data_type>
+void gather_tile_vector(const data_type *vector_in, std::vector<uint32_t> const &col_map, data_type *out) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    if constexpr (std::is_same<data_type, float>::value) {
+        for (; i + 8 <= col_map.size(); i += 8) {
+            __m256i idx = _mm256_loadu_si256((const __m256i*)(col_map.data() + i));
+            _mm256_storeu_ps(out + i, _mm256_i32gather_ps(vector_in, idx, 4));
+        }
+    }
+#endif
+    for (; i < col_map.size(); i++) {
+        out[i] = vector_in[col_map[i]];
+    }
+}
+
+
+// Reduce the partial results of the tiles of a grid into vector_out, with semiring::add over the
+// column blocks of a row block. partial[i] holds the rows of tiles[i].
+template<typename data_type, typename semiring = PlusTimes<data_type>>
+void reduce_tile_results(std::vector<CompactCSRTile<data_type>> const &tiles, size_t num_col_blocks,
+                         std::vector<const data_type*> const &partial, data_type *vector_out,
+                         unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    for (size_t i = 0; i < tiles.size(); i += num_col_blocks) {
+        parallel_for(0, tiles[i].local.num_rows, num_threads, [&](size_t begin, size_t end, unsigned) {
+            for (size_t r = begin; r < end; r++) {
+                data_type acc = partial[i][r];
+                for (size_t j = 1; j < num_col_blocks; j++) {
+                    acc = semiring::add(acc, partial[i + j][r]);
+                }
+                vector_out[tiles[i].row_begin + r] = acc;
+            }
+        });
+    }
+}
+
+#endif  // CSR_PARTITION_HPP
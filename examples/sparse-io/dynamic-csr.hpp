@@ -0,0 +1,305 @@
+#ifndef DYNAMIC_CSR_HPP
+#define DYNAMIC_CSR_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "sparse-io.hpp"
+#include "semiring.hpp"
+
+//--------------------------------------------------
+// Dynamic CSR with per-row slack and a delta overlay
+//--------------------------------------------------
+
+// Every row owns a fixed range of slots, its edges followed by free slots. The free slots hold
+// semiring::zero() in column 0, so the slot arrays are a valid CSR matrix for any SpMV kernel and
+// the row pointers only change on a merge. An edge update rewrites one or two slots, and only the
+// changed slots are migrated to the device. Inserts into a full row go to a COO overlay, applied
+// on the host after the SpMV, until a background merge rebuilds the slots with fresh slack.
+
+// An edge update, kept to replay the updates made while a merge runs.
+template<typename data_type>
+struct EdgeUpdate {
+    /*! \brief The row of the edge */
+    uint32_t row;
+    /*! \brief The column of the edge */
+    uint32_t col;
+    /*! \brief The new value, unused for a removal */
+    data_type value;
+    /*! \brief Remove the edge instead of setting it */
+    bool remove;
+};
+
+
+template<typename data_type, typename semiring = PlusTimes<data_type>>
+class DynamicCSRMatrix {
+public:
+    // slack: the free slots of a row as a fraction of its edges, at least min_slack per row.
+    // merge_fraction: merge once the overlay holds this fraction of the edges.
+    explicit DynamicCSRMatrix(CSRMatrix<data_type> const &csr, double slack = 0.25, uint32_t min_slack = 2,
+                              double merge_fraction = 0.02)
+        : _slack(slack), _min_slack(min_slack), _merge_fraction(merge_fraction) {
+        this->_install(_build(csr, slack, min_slack));
+    }
+
+    ~DynamicCSRMatrix() {
+        if (this->_merge.valid()) {
+            this->_merge.wait();
+        }
+    }
+
+    // The slot arrays to hand to the device. The row pointers and the array sizes only change when
+    // poll_merge returns true.
+    CSRMatrix<data_type> const &slots() const { return this->_slots; }
+
+    // The number of edges, including the overlay.
+    uint64_t nnz() const { return this->_nnz + this->_overlay.size(); }
+
+    uint64_t overlay_size() const { return this->_overlay.size(); }
+
+    bool merging() const { return this->_merge.valid(); }
+
+    // Set the value of an edge, inserting it if needed.
+    void insert_edge(uint32_t row, uint32_t col, data_type value) {
+        this->_check(row, col);
+        if (this->_merge.valid()) {
+            this->_journal.push_back({row, col, value, false});
+        }
+        this->_insert(row, col, value);
+    }
+
+    // Remove an edge, returns false if the matrix does not have it.
+    bool remove_edge(uint32_t row, uint32_t col) {
+        this->_check(row, col);
+        if (this->_merge.valid()) {
+            this->_journal.push_back({row, col, data_type(), true});
+        }
+        return this->_remove(row, col);
+    }
+
+    // Return the slot ranges [begin, end) changed since the last call, sorted, and forget them.
+    // Ranges closer than max_gap slots are coalesced, fewer and larger transfers are cheaper
+    // than many tiny ones. A range covers the same entries of adj_data and adj_indices.
+    std::vector<std::pair<size_t, size_t>> take_dirty_ranges(size_t max_gap = 16) {
+        std::vector<std::pair<size_t, size_t>> ranges;
+        std::sort(this->_dirty.begin(), this->_dirty.end());
+        for (auto const &d : this->_dirty) {
+            if (!ranges.empty() && d.first <= ranges.back().second + max_gap) {
+                ranges.back().second = std::max(ranges.back().second, d.second);
+            } else {
+                ranges.push_back(d);
+            }
+        }
+        this->_dirty.clear();
+        return ranges;
+    }
+
+    // Whether the overlay is large enough to be worth a merge.
+    bool needs_merge() const {
+        return this->_overlay.size() > this->_merge_fraction * this->_nnz;
+    }
+
+    // Start rebuilding the slots with the overlay folded in on another thread. The matrix takes
+    // updates in the meantime, they are replayed on the new slots by poll_merge. Returns false if
+    // a merge is already running. The current slots are copied first, O(nnz) on this thread.
+    bool start_merge() {
+        if (this->_merge.valid()) {
+            return false;
+        }
+        CSRMatrix<data_type> csr = this->to_csr();
+        double slack = this->_slack;
+        uint32_t min_slack = this->_min_slack;
+        this->_merge = std::async(std::launch::async, [csr = std::move(csr), slack, min_slack]() {
+            return _build(csr, slack, min_slack);
+        });
+        return true;
+    }
+
+    // Install the merged slots once the merge is done (or wait for it). Returns true if the slots
+    // were replaced: their sizes and row pointers changed and every slot is dirty.
+    bool poll_merge(bool wait = false) {
+        if (!this->_merge.valid()) {
+            return false;
+        }
+        if (!wait && this->_merge.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return false;
+        }
+        this->_install(this->_merge.get());
+        std::vector<EdgeUpdate<data_type>> journal;
+        journal.swap(this->_journal);
+        for (auto const &u : journal) {
+            if (u.remove) {
+                this->_remove(u.row, u.col);
+            } else {
+                this->_insert(u.row, u.col, u.value);
+            }
+        }
+        return true;
+    }
+
+    // y[r] = add(y[r], mul(value, x[col])) over the overlay edges, to complete an SpMV on the slots.
+    void spmv_overlay(const data_type *x, data_type *y) const {
+        for (auto const &e : this->_overlay) {
+            uint32_t row = e.first >> 32;
+            uint32_t col = e.first & 0xffffffff;
+            y[row] = semiring::add(y[row], semiring::mul(e.second, x[col]));
+        }
+    }
+
+    // A compact copy without free slots, the overlay merged in, columns sorted within each row.
+    CSRMatrix<data_type> to_csr() const {
+        CSRMatrix<data_type> out;
+        out.num_rows = this->_slots.num_rows;
+        out.num_cols = this->_slots.num_cols;
+        std::vector<std::vector<std::pair<uint32_t, data_type>>> extra(out.num_rows);
+        for (auto const &e : this->_overlay) {
+            extra[e.first >> 32].push_back({uint32_t(e.first & 0xffffffff), e.second});
+        }
+        out.adj_data.reserve(this->nnz());
+        out.adj_indices.reserve(this->nnz());
+        out.adj_indptr.reserve(out.num_rows + 1);
+        out.adj_indptr.push_back(0);
+        std::vector<std::pair<uint32_t, data_type>> row_edges;
+        for (uint32_t r = 0; r < out.num_rows; r++) {
+            row_edges.assign(extra[r].begin(), extra[r].end());
+            uint32_t begin = this->_slots.adj_indptr[r];
+            for (uint32_t i = begin; i < begin + this->_row_size[r]; i++) {
+                row_edges.push_back({this->_slots.adj_indices[i], this->_slots.adj_data[i]});
+            }
+            std::sort(row_edges.begin(), row_edges.end(),
+                      [](auto const &a, auto const &b) { return a.first < b.first; });
+            for (auto const &e : row_edges) {
+                out.adj_indices.push_back(e.first);
+                out.adj_data.push_back(e.second);
+            }
+            out.adj_indptr.push_back(out.adj_indices.size());
+        }
+        return out;
+    }
+
+private:
+    struct _Layout {
+        CSRMatrix<data_type> slots;
+        std::vector<uint32_t> row_size;
+        uint64_t nnz;
+    };
+
+    static uint64_t _key(uint32_t row, uint32_t col) { return (uint64_t(row) << 32) | col; }
+
+    // Lay out the edges of csr with free slots after every row.
+    static _Layout _build(CSRMatrix<data_type> const &csr, double slack, uint32_t min_slack) {
+        _Layout layout;
+        layout.slots.num_rows = csr.num_rows;
+        layout.slots.num_cols = csr.num_cols;
+        layout.row_size.resize(csr.num_rows);
+        layout.nnz = csr.adj_indices.size();
+        std::vector<uint32_t> &indptr = layout.slots.adj_indptr;
+        indptr.resize(csr.num_rows + 1);
+        indptr[0] = 0;
+        uint64_t total = 0;
+        for (uint32_t r = 0; r < csr.num_rows; r++) {
+            uint32_t size = csr.adj_indptr[r + 1] - csr.adj_indptr[r];
+            layout.row_size[r] = size;
+            total += size + std::max<uint64_t>(min_slack, std::ceil(size * slack));
+            if (total > UINT32_MAX) {
+                throw std::runtime_error("Dynamic CSR slots exceed 32-bit indices");
+            }
+            indptr[r + 1] = total;
+        }
+        layout.slots.adj_data.assign(total, semiring::zero());
+        layout.slots.adj_indices.assign(total, 0);
+        for (uint32_t r = 0; r < csr.num_rows; r++) {
+            std::copy(csr.adj_data.begin() + csr.adj_indptr[r], csr.adj_data.begin() + csr.adj_indptr[r + 1],
+                      layout.slots.adj_data.begin() + indptr[r]);
+            std::copy(csr.adj_indices.begin() + csr.adj_indptr[r],
+                      csr.adj_indices.begin() + csr.adj_indptr[r + 1],
+                      layout.slots.adj_indices.begin() + indptr[r]);
+        }
+        return layout;
+    }
+
+    void _install(_Layout layout) {
+        this->_slots = std::move(layout.slots);
+        this->_row_size = std::move(layout.row_size);
+        this->_nnz = layout.nnz;
+        this->_overlay.clear();
+        this->_dirty.clear();
+        this->_dirty.push_back({0, this->_slots.adj_indices.size()});
+    }
+
+    void _check(uint32_t row, uint32_t col) const {
+        if (row >= this->_slots.num_rows || col >= this->_slots.num_cols) {
+            throw std::runtime_error("Edge (" + std::to_string(row) + ", " + std::to_string(col)
+                                     + ") out of the matrix");
+        }
+    }
+
+    // The slot of an edge, or UINT32_MAX if it is not in the slots.
+    uint32_t _find(uint32_t row, uint32_t col) const {
+        uint32_t begin = this->_slots.adj_indptr[row];
+        for (uint32_t i = begin; i < begin + this->_row_size[row]; i++) {
+            if (this->_slots.adj_indices[i] == col) {
+                return i;
+            }
+        }
+        return UINT32_MAX;
+    }
+
+    void _insert(uint32_t row, uint32_t col, data_type value) {
+        uint32_t slot = this->_find(row, col);
+        if (slot == UINT32_MAX) {
+            auto e = this->_overlay.find(_key(row, col));
+            if (e != this->_overlay.end()) {
+                e->second = value;
+                return;
+            }
+            uint32_t begin = this->_slots.adj_indptr[row];
+            if (begin + this->_row_size[row] == this->_slots.adj_indptr[row + 1]) {
+                this->_overlay[_key(row, col)] = value;
+                return;
+            }
+            slot = begin + this->_row_size[row]++;
+            this->_slots.adj_indices[slot] = col;
+            this->_nnz++;
+        }
+        this->_slots.adj_data[slot] = value;
+        this->_dirty.push_back({slot, slot + 1});
+    }
+
+    bool _remove(uint32_t row, uint32_t col) {
+        uint32_t slot = this->_find(row, col);
+        if (slot == UINT32_MAX) {
+            return this->_overlay.erase(_key(row, col)) > 0;
+        }
+        // move the last edge of the row into the hole and free its slot
+        uint32_t last = this->_slots.adj_indptr[row] + --this->_row_size[row];
+        this->_slots.adj_indices[slot] = this->_slots.adj_indices[last];
+        this->_slots.adj_data[slot] = this->_slots.adj_data[last];
+        this->_slots.adj_indices[last] = 0;
+        this->_slots.adj_data[last] = semiring::zero();
+        this->_nnz--;
+        this->_dirty.push_back({slot, slot + 1});
+        this->_dirty.push_back({last, last + 1});
+        return true;
+    }
+
+    double _slack;
+    uint32_t _min_slack;
+    double _merge_fraction;
+    CSRMatrix<data_type> _slots;
+    std::vector<uint32_t> _row_size;
+    uint64_t _nnz;
+    std::unordered_map<uint64_t, data_type> _overlay;
+    std::vector<std::pair<size_t, size_t>> _dirty;
+    std::future<_Layout> _merge;
+    std::vector<EdgeUpdate<data_type>> _journal;
+};
+
+#endif  // DYNAMIC_CSR_HPP
@@ -0,0 +1,458 @@
+#ifndef EDGE_LIST_HPP
+#define EDGE_LIST_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "sparse-io.hpp"
+#include "parallel-for.hpp"
+
+//--------------------------------------------------
+// Coordinate (COO) format and the csr build
+//--------------------------------------------------
+
+// Data structure for a coo matrix, e.g., a loaded edge list. Entry k is (rows[k], cols[k], values[k]).
+template<typename data_type>
+struct COOMatrix {
+    /*! \brief The number of rows of the sparse matrix */
+    uint32_t num_rows;
+    /*! \brief The number of columns of the sparse matrix */
+    uint32_t num_cols;
+    /*! \brief The row of each entry */
+    std::vector<uint32_t> rows;
+    /*! \brief The column of each entry */
+    std::vector<uint32_t> cols;
+    /*! \brief The value of each entry */
+    std::vector<data_type> values;
+};
+
+
+// What the csr build does with the entries of a coo matrix.
+struct EdgeListOptions {
+    /*! \brief Drop the entries (i, i) */
+    bool remove_self_loops = false;
+    /*! \brief Add (j, i) for every (i, j), on a square matrix; combine with deduplicate if the input
+     *  may already hold both directions */
+    bool symmetrize = false;
+    /*! \brief With symmetrize, add -value at (j, i) instead, for a skew-symmetric matrix */
+    bool negate_mirror = false;
+    /*! \brief Merge the entries with the same (i, j), adding their values, as scipy does */
+    bool deduplicate = false;
+    /*! \brief Store an entry (i, j) at (j, i), e.g., so that row i lists the in-neighbours of i */
+    bool transpose = false;
+    /*! \brief The worker threads, 0 means all cores */
+    unsigned num_threads = 0;
+};
+
+
+// Build a csr matrix from a coo matrix with a parallel two-pass counting sort: the entries of every
+// row are counted, then scattered to their row. The columns of each row are sorted (by value on
+// equal columns, so the result does not depend on the scatter order).
+template<typename data_type, typename offset_type = uint32_t>
+CSRMatrix<data_type, uint32_t, offset_type> coo_to_csr(COOMatrix<data_type> const &coo,
+                                                       EdgeListOptions const &options = EdgeListOptions()) {
+    unsigned num_threads = (options.num_threads == 0) ? default_num_threads() : options.num_threads;
+    if (options.symmetrize && coo.num_rows != coo.num_cols) {
+        throw std::runtime_error("Only a square matrix can be symmetrized");
+    }
+    CSRMatrix<data_type, uint32_t, offset_type> csr;
+    csr.num_rows = options.transpose ? coo.num_cols : coo.num_rows;
+    csr.num_cols = options.transpose ? coo.num_rows : coo.num_cols;
+    size_t n = csr.num_rows;
+    size_t num_entries = coo.rows.size();
+    // call fn(row, col, value) for every entry to store, including the mirrored ones
+    auto for_entries = [&](size_t begin, size_t end, auto fn) {
+        for (size_t k = begin; k < end; k++) {
+            uint32_t r = options.transpose ? coo.cols[k] : coo.rows[k];
+            uint32_t c = options.transpose ? coo.rows[k] : coo.cols[k];
+            if (r == c && options.remove_self_loops) continue;
+            fn(r, c, coo.values[k]);
+            if (options.symmetrize && r != c) fn(c, r, options.negate_mirror ? -coo.values[k] : coo.values[k]);
+        }
+    };
+    // pass 1: count the entries of every row
+    std::vector<std::atomic<offset_type>> cursor(n);
+    parallel_for(0, n, num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t r = begin; r < end; r++) cursor[r].store(0, std::memory_order_relaxed);
+    });
+    parallel_for(0, num_entries, num_threads, [&](size_t begin, size_t end, unsigned) {
+        for_entries(begin, end, [&](uint32_t r, uint32_t, data_type const &) {
+            cursor[r].fetch_add(1, std::memory_order_relaxed);
+        });
+    });
+    csr.adj_indptr.resize(n + 1);
+    csr.adj_indptr[0] = 0;
+    for (size_t r = 0; r < n; r++) {
+        uint64_t next = uint64_t(csr.adj_indptr[r]) + cursor[r].load(std::memory_order_relaxed);
+        if (next > std::numeric_limits<offset_type>::max()) {
+            throw std::runtime_error("The matrix exceeds " + std::to_string(8 * sizeof(offset_type))
+                                     + "-bit offsets, build it with a 64-bit offset_type");
+        }
+        csr.adj_indptr[r + 1] = next;
+        cursor[r].store(csr.adj_indptr[r], std::memory_order_relaxed);
+    }
+    // pass 2: scatter the entries to their row
+    csr.adj_indices.resize(csr.adj_indptr[n]);
+    csr.adj_data.resize(csr.adj_indptr[n]);
+    parallel_for(0, num_entries, num_threads, [&](size_t begin, size_t end, unsigned) {
+        for_entries(begin, end, [&](uint32_t r, uint32_t c, data_type const &v) {
+            offset_type dest = cursor[r].fetch_add(1, std::memory_order_relaxed);
+            csr.adj_indices[dest] = c;
+            csr.adj_data[dest] = v;
+        });
+    });
+    // sort every row, merging the duplicates in place; the new row lengths go to row_size
+    std::vector<offset_type> row_size(n);
+    parallel_for(0, n, num_threads, [&](size_t begin, size_t end, unsigned) {
+        std::vector<std::pair<uint32_t, data_type>> row;
+        for (size_t r = begin; r < end; r++) {
+            offset_type start = csr.adj_indptr[r];
+            offset_type stop = csr.adj_indptr[r + 1];
+            row.clear();
+            for (offset_type k = start; k < stop; k++) {
+                row.push_back({csr.adj_indices[k], csr.adj_data[k]});
+            }
+            std::sort(row.begin(), row.end());
+            offset_type dest = start;
+            for (size_t i = 0; i < row.size(); i++) {
+                if (options.deduplicate && dest > start && csr.adj_indices[dest - 1] == row[i].first) {
+                    csr.adj_data[dest - 1] += row[i].second;
+                    continue;
+                }
+                csr.adj_indices[dest] = row[i].first;
+                csr.adj_data[dest++] = row[i].second;
+            }
+            row_size[r] = dest - start;
+        }
+    }, 1024);
+    if (!options.deduplicate) {
+        return csr;
+    }
+    // close the gaps left by the merged duplicates
+    CSRMatrix<data_type, uint32_t, offset_type> out;
+    out.num_rows = csr.num_rows;
+    out.num_cols = csr.num_cols;
+    out.adj_indptr.resize(n + 1);
+    out.adj_indptr[0] = 0;
+    for (size_t r = 0; r < n; r++) {
+        out.adj_indptr[r + 1] = out.adj_indptr[r] + row_size[r];
+    }
+    if (out.adj_indptr[n] == csr.adj_indptr[n]) {
+        return csr;
+    }
+    out.adj_indices.resize(out.adj_indptr[n]);
+    out.adj_data.resize(out.adj_indptr[n]);
+    parallel_for(0, n, num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t r = begin; r < end; r++) {
+            std::copy_n(csr.adj_indices.begin() + csr.adj_indptr[r], row_size[r],
+                        out.adj_indices.begin() + out.adj_indptr[r]);
+            std::copy_n(csr.adj_data.begin() + csr.adj_indptr[r], row_size[r], out.adj_data.begin() + out.adj_indptr[r]);
+        }
+    }, 1024);
+    return out;
+}
+
+
+//--------------------------------------------------
+// Text and binary loaders
+//--------------------------------------------------
+
+// Read a whole file.
+inline std::vector<char> read_file(std::string const &path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    std::vector<char> buffer(file.tellg());
+    file.seekg(0);
+    if (!file.read(buffer.data(), buffer.size())) {
+        throw std::runtime_error("Cannot read " + path);
+    }
+    return buffer;
+}
+
+
+// Parse the number at the start of [p, stop) into value, returns the end of the number or nullptr.
+// Floating-point from_chars needs GCC 11, so floats go through strtod on a bounded, terminated copy.
+template<typename data_type>
+const char *parse_coo_value(const char *p, const char *stop, data_type &value) {
+    if constexpr (std::is_integral_v<data_type>) {
+        auto v = std::from_chars(p, stop, value);
+        return v.ec == std::errc() ? v.ptr : nullptr;
+    } else {
+        char token[64];
+        size_t len = 0;
+        while (p + len < stop && len < sizeof(token) - 1 && !std::isspace((unsigned char)p[len])) {
+            token[len] = p[len];
+            len++;
+        }
+        token[len] = '\0';
+        char *end;
+        double parsed = std::strtod(token, &end);
+        if (end == token) return nullptr;
+        value = (data_type)parsed;
+        return p + (end - token);
+    }
+}
+
+
+// Parse the entries "row col [value]" of text[begin, end) into coo, one entry per line, in
+// parallel: each thread takes the lines starting in its share of the bytes. Blank lines and lines
+// starting with one of comment_chars are skipped. An entry without a value gets 1. index_base is
+// subtracted from the indices (1 for Matrix Market). Returns the largest row and column + 1.
+template<typename data_type>
+std::pair<uint32_t, uint32_t> parse_coo_text(const char *text, size_t begin, size_t end, uint32_t index_base,
+                                             const char *comment_chars, COOMatrix<data_type> &coo,
+                                             std::string const &path, unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    std::vector<COOMatrix<data_type>> chunks(num_threads);
+    std::vector<std::pair<uint32_t, uint32_t>> extent(num_threads, {0, 0});
+    // the byte of the first malformed line of every thread, thrown once the threads are done
+    std::vector<size_t> error_at(num_threads, SIZE_MAX);
+    parallel_for(begin, end, num_threads, [&](size_t chunk_begin, size_t chunk_end, unsigned t) {
+        // a line belongs to the chunk holding its first byte
+        const char *p = text + chunk_begin;
+        if (chunk_begin > begin) {
+            while (p < text + end && p[-1] != '\n') p++;
+        }
+        const char *stop = text + end;
+        COOMatrix<data_type> &out = chunks[t];
+        auto skip_blanks = [&](const char *q) {
+            while (q < stop && (*q == ' ' || *q == '\t' || *q == '\r')) q++;
+            return q;
+        };
+        while (p < text + chunk_end) {
+            const char *line = p;
+            p = skip_blanks(p);
+            if (p < stop && *p != '\n' && !std::strchr(comment_chars, *p)) {
+                uint64_t row = 0, col = 0;
+                data_type value = 1;
+                auto r = std::from_chars(p, stop, row);
+                auto c = std::from_chars(skip_blanks(r.ptr), stop, col);
+                bool ok = r.ec == std::errc() && c.ec == std::errc() && row >= index_base && col >= index_base
+                          && row - index_base < UINT32_MAX && col - index_base < UINT32_MAX;
+                p = skip_blanks(c.ptr);
+                if (ok && p < stop && *p != '\n') {
+                    const char *v = parse_coo_value(p, stop, value);
+                    ok = v != nullptr;
+                    p = ok ? v : p;
+                }
+                if (!ok) {
+                    error_at[t] = line - text;
+                    return;
+                }
+                out.rows.push_back(row - index_base);
+                out.cols.push_back(col - index_base);
+                out.values.push_back(value);
+                extent[t].first = std::max<uint32_t>(extent[t].first, row - index_base + 1);
+                extent[t].second = std::max<uint32_t>(extent[t].second, col - index_base + 1);
+            }
+            while (p < stop && *p != '\n') p++;
+            p++;
+        }
+    }, 1 << 20);
+    size_t first_error = *std::min_element(error_at.begin(), error_at.end());
+    if (first_error != SIZE_MAX) {
+        throw std::runtime_error("Malformed entry at byte " + std::to_string(first_error) + " of " + path);
+    }
+    // append the chunks in order
+    std::vector<size_t> offset(num_threads + 1, coo.rows.size());
+    for (unsigned t = 0; t < num_threads; t++) {
+        offset[t + 1] = offset[t] + chunks[t].rows.size();
+    }
+    coo.rows.resize(offset[num_threads]);
+    coo.cols.resize(offset[num_threads]);
+    coo.values.resize(offset[num_threads]);
+    parallel_run(num_threads, [&](unsigned t) {
+        std::copy(chunks[t].rows.begin(), chunks[t].rows.end(), coo.rows.begin() + offset[t]);
+        std::copy(chunks[t].cols.begin(), chunks[t].cols.end(), coo.cols.begin() + offset[t]);
+        std::copy(chunks[t].values.begin(), chunks[t].values.end(), coo.values.begin() + offset[t]);
+    });
+    std::pair<uint32_t, uint32_t> total = {0, 0};
+    for (auto const &e : extent) {
+        total.first = std::max(total.first, e.first);
+        total.second = std::max(total.second, e.second);
+    }
+    return total;
+}
+
+
+// Load a text edge list, e.g., from SNAP: one "source target [weight]" per line, '#' or '%'
+// comments, 0-based vertices unless index_base says otherwise. The matrix is square, with as many
+// vertices as the largest index + 1, and edge (s, t) is entry (s, t) (see EdgeListOptions::transpose).
+template<typename data_type>
+COOMatrix<data_type> load_edge_list(std::string const &path, uint32_t index_base = 0, unsigned num_threads = 0) {
+    std::vector<char> text = read_file(path);
+    COOMatrix<data_type> coo;
+    std::pair<uint32_t, uint32_t> extent = parse_coo_text(text.data(), 0, text.size(), index_base, "#%", coo,
+                                                          path, num_threads);
+    coo.num_rows = coo.num_cols = std::max(extent.first, extent.second);
+    return coo;
+}
+
+
+// Load a binary edge list: consecutive little-endian records of a uint32_t source and target,
+// followed by a float weight if weighted (12 bytes per record, 8 otherwise).
+template<typename data_type>
+COOMatrix<data_type> load_binary_edge_list(std::string const &path, bool weighted = false, unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    std::vector<char> bytes = read_file(path);
+    size_t record = weighted ? 12 : 8;
+    if (bytes.size() % record != 0) {
+        throw std::runtime_error(path + " is not a list of " + std::to_string(record) + "-byte edges");
+    }
+    size_t num_edges = bytes.size() / record;
+    COOMatrix<data_type> coo;
+    coo.rows.resize(num_edges);
+    coo.cols.resize(num_edges);
+    coo.values.resize(num_edges);
+    std::vector<uint32_t> extent(num_threads, 0);
+    parallel_for(0, num_edges, num_threads, [&](size_t begin, size_t end, unsigned t) {
+        for (size_t k = begin; k < end; k++) {
+            const char *p = bytes.data() + k * record;
+            float weight = 1;
+            std::memcpy(&coo.rows[k], p, 4);
+            std::memcpy(&coo.cols[k], p + 4, 4);
+            if (weighted) std::memcpy(&weight, p + 8, 4);
+            coo.values[k] = weight;
+            extent[t] = std::max({extent[t], coo.rows[k] + 1, coo.cols[k] + 1});
+        }
+    });
+    coo.num_rows = coo.num_cols = *std::max_element(extent.begin(), extent.end());
+    return coo;
+}
+
+
+//--------------------------------------------------
+// Matrix Market loader
+//--------------------------------------------------
+
+// The banner of a Matrix Market coordinate file, "%%MatrixMarket matrix coordinate <field> <symmetry>".
+struct MatrixMarketHeader {
+    /*! \brief real, integer or pattern (complex is not supported) */
+    std::string field;
+    /*! \brief general, symmetric or skew-symmetric */
+    std::string symmetry;
+    /*! \brief The number of rows, columns and stored entries from the size line */
+    uint32_t num_rows, num_cols;
+    uint64_t num_entries;
+};
+
+
+// Load a Matrix Market coordinate file. A symmetric or skew-symmetric file only stores one
+// triangle, returned as is: build with EdgeListOptions::symmetrize to get the full matrix (and
+// negate_mirror for skew-symmetric), or keep the triangle as a SymmetricCSRMatrix with
+// load_symmetric_from_matrix_market. Other symmetries, e.g., hermitian, throw.
+template<typename data_type>
+COOMatrix<data_type> load_matrix_market(std::string const &path, MatrixMarketHeader &header, unsigned num_threads = 0) {
+    std::vector<char> text = read_file(path);
+    const char *p = text.data();
+    const char *end = p + text.size();
+    auto next_line = [&](const char *q) {
+        q = static_cast<const char*>(std::memchr(q, '\n', end - q));
+        return q ? q + 1 : end;
+    };
+    const char *banner_end = next_line(p);
+    std::string banner(p, banner_end);
+    for (auto &ch : banner) ch = std::tolower(static_cast<unsigned char>(ch));
+    char object[32], format[32], field[32], symmetry[32];
+    if (std::sscanf(banner.c_str(), "%%%%matrixmarket %31s %31s %31s %31s", object, format, field, symmetry) != 4
+        || std::string(object) != "matrix" || std::string(format) != "coordinate") {
+        throw std::runtime_error(path + " is not a Matrix Market coordinate file");
+    }
+    header.field = field;
+    header.symmetry = symmetry;
+    if (header.field == "complex") {
+        throw std::runtime_error(path + ": complex matrices are not supported");
+    }
+    if (header.symmetry != "general" && header.symmetry != "symmetric" && header.symmetry != "skew-symmetric") {
+        throw std::runtime_error(path + ": " + header.symmetry + " matrices are not supported");
+    }
+    // the size line is the first line that is not a comment
+    p = banner_end;
+    while (p < end && *p == '%') p = next_line(p);
+    unsigned long long rows, cols, entries;
+    if (std::sscanf(std::string(p, next_line(p)).c_str(), "%llu %llu %llu", &rows, &cols, &entries) != 3
+        || rows > UINT32_MAX || cols > UINT32_MAX) {
+        throw std::runtime_error(path + ": malformed size line");
+    }
+    header.num_rows = rows;
+    header.num_cols = cols;
+    header.num_entries = entries;
+    COOMatrix<data_type> coo;
+    coo.num_rows = rows;
+    coo.num_cols = cols;
+    coo.rows.reserve(entries);
+    coo.cols.reserve(entries);
+    coo.values.reserve(entries);
+    std::pair<uint32_t, uint32_t> extent = parse_coo_text(text.data(), next_line(p) - text.data(), text.size(), 1,
+                                                          "%", coo, path, num_threads);
+    if (coo.rows.size() != entries || extent.first > coo.num_rows || extent.second > coo.num_cols) {
+        throw std::runtime_error(path + ": the entries do not match the size line");
+    }
+    return coo;
+}
+
+
+// Load a symmetric Matrix Market file as its upper triangle, without expanding it.
+template<typename data_type>
+SymmetricCSRMatrix<data_type> load_symmetric_from_matrix_market(std::string const &path, EdgeListOptions options = EdgeListOptions()) {
+    MatrixMarketHeader header;
+    COOMatrix<data_type> coo = load_matrix_market<data_type>(path, header, options.num_threads);
+    if (header.symmetry != "symmetric") {
+        throw std::runtime_error(path + " is not a symmetric Matrix Market file");
+    }
+    // the file stores one triangle, usually the lower one: move every entry to the upper one
+    options.symmetrize = false;
+    options.transpose = false;
+    parallel_for(0, coo.rows.size(), options.num_threads ? options.num_threads : default_num_threads(),
+                 [&](size_t begin, size_t end, unsigned) {
+        for (size_t k = begin; k < end; k++) {
+            if (coo.rows[k] > coo.cols[k]) std::swap(coo.rows[k], coo.cols[k]);
+        }
+    });
+    SymmetricCSRMatrix<data_type> sym;
+    sym.upper = coo_to_csr(coo, options);
+    return sym;
+}
+
+
+// Load a float csr matrix from a file of any supported format, picked by its extension: .npz
+// (scipy), .mtx (Matrix Market, symmetric files expanded), .bin (binary edge list, unweighted) or
+// anything else as a text edge list. The options apply to all but npz; stats gets the bytes and
+// time of an npz load.
+inline CSRMatrix<float> load_float_csr_matrix(std::string const &path, EdgeListOptions options = EdgeListOptions(),
+                                              NpzLoadStats *stats = nullptr) {
+    auto ends_with = [&](std::string const &suffix) {
+        return path.size() >= suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    if (ends_with(".npz")) {
+        return load_csr_matrix_from_float_npz(path, stats);
+    }
+    if (ends_with(".mtx")) {
+        MatrixMarketHeader header;
+        COOMatrix<float> coo = load_matrix_market<float>(path, header, options.num_threads);
+        options.symmetrize = header.symmetry != "general";
+        options.negate_mirror = header.symmetry == "skew-symmetric";
+        return coo_to_csr(coo, options);
+    }
+    if (ends_with(".bin")) {
+        return coo_to_csr(load_binary_edge_list<float>(path, false, options.num_threads), options);
+    }
+    return coo_to_csr(load_edge_list<float>(path, 0, options.num_threads), options);
+}
+
+#endif  // EDGE_LIST_HPP
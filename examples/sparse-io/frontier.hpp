@@ -0,0 +1,149 @@
+#ifndef FRONTIER_HPP
+#define FRONTIER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "sparse-io.hpp"
+#include "parallel-for.hpp"
+
+//--------------------------------------------------
+// Frontier-based traversal (BFS / SSSP)
+//--------------------------------------------------
+
+// A graph is a square matrix whose row i lists the in-neighbours of vertex i, with the edge
+// weights as values (all ones for BFS). A level relaxes the out-edges of the frontier, i.e., the
+// vertices whose distance changed in the previous level. Sparse frontiers push along the columns
+// (csc), dense ones pull along the rows (csr) of every vertex.
+
+// Compacted sparse vector.
+template<typename data_type>
+struct SparseVector {
+    /*! \brief The length of the dense vector */
+    uint32_t size;
+    /*! \brief The indices of the non-zeros, in no particular order */
+    std::vector<uint32_t> indices;
+    /*! \brief The values of the non-zeros */
+    std::vector<data_type> values;
+};
+
+
+enum class Direction {Push, Pull};
+
+// Pick the direction of a level: pull once the out-edges of the frontier exceed nnz / alpha, where
+// pulling every row costs about as much as pushing from the frontier.
+inline Direction choose_direction(uint64_t frontier_edges, uint64_t nnz, double alpha = 14) {
+    return (frontier_edges * alpha > nnz) ? Direction::Pull : Direction::Push;
+}
+
+
+// The number of out-edges of the vertices in the frontier.
+template<typename data_type>
+uint64_t frontier_edges(CSCMatrix<data_type> const &csc, const uint32_t *frontier, size_t frontier_size) {
+    uint64_t edges = 0;
+    for (size_t k = 0; k < frontier_size; k++) {
+        edges += csc.adj_indptr[frontier[k] + 1] - csc.adj_indptr[frontier[k]];
+    }
+    return edges;
+}
+
+
+// One push level: relax the out-edges of the frontier and return the vertices whose distance
+// dropped, each once. mark holds a level stamp per vertex and is never cleared, level must grow.
+template<typename data_type>
+std::vector<uint32_t> sssp_push_step(CSCMatrix<data_type> const &csc, std::vector<data_type> &dist,
+                                     std::vector<uint32_t> &mark, std::vector<uint32_t> const &frontier,
+                                     uint32_t level) {
+    std::vector<uint32_t> next;
+    for (uint32_t j : frontier) {
+        data_type dj = dist[j];
+        for (uint32_t e = csc.adj_indptr[j]; e < csc.adj_indptr[j + 1]; e++) {
+            uint32_t i = csc.adj_indices[e];
+            data_type nd = dj + csc.adj_data[e];
+            if (nd < dist[i]) {
+                dist[i] = nd;
+                if (mark[i] != level) {
+                    mark[i] = level;
+                    next.push_back(i);
+                }
+            }
+        }
+    }
+    return next;
+}
+
+
+// One pull level over all rows on num_threads threads (0 means all cores). Returns the vertices
+// whose distance dropped, in increasing order. scratch must have num_rows entries.
+template<typename data_type>
+std::vector<uint32_t> sssp_pull_step(CSRMatrix<data_type> const &csr, std::vector<data_type> &dist,
+                                     std::vector<data_type> &scratch, unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    std::vector<std::vector<uint32_t>> changed(num_threads);
+    // new distances go to scratch first, so no thread reads a distance another one writes
+    parallel_for(0, csr.num_rows, num_threads, [&](size_t begin, size_t end, unsigned t) {
+        for (size_t i = begin; i < end; i++) {
+            data_type best = dist[i];
+            for (uint32_t e = csr.adj_indptr[i]; e < csr.adj_indptr[i + 1]; e++) {
+                best = std::min<data_type>(best, csr.adj_data[e] + dist[csr.adj_indices[e]]);
+            }
+            scratch[i] = best;
+            if (best < dist[i]) changed[t].push_back(i);
+        }
+    });
+    std::vector<uint32_t> next;
+    for (auto &c : changed) {
+        for (uint32_t i : c) dist[i] = scratch[i];
+        next.insert(next.end(), c.begin(), c.end());
+    }
+    return next;
+}
+
+
+// Statistics of a traversal.
+struct TraversalStats {
+    /*! \brief The number of levels until the frontier was empty */
+    uint32_t levels = 0;
+    /*! \brief The number of levels run in pull direction */
+    uint32_t pull_levels = 0;
+    /*! \brief The number of edges relaxed over all levels */
+    uint64_t edges = 0;
+};
+
+
+// Single-source shortest paths on the CPU, switching direction every level. Unreachable vertices
+// stay at infinity. Pass a matrix with all values 1 for BFS levels. csc must be csr2csc(csr).
+template<typename data_type>
+std::vector<data_type> sssp_frontier_cpu(CSRMatrix<data_type> const &csr, CSCMatrix<data_type> const &csc,
+                                         uint32_t source, TraversalStats *stats = nullptr,
+                                         double alpha = 14, unsigned num_threads = 0) {
+    const data_type inf = std::numeric_limits<data_type>::has_infinity
+        ? std::numeric_limits<data_type>::infinity() : std::numeric_limits<data_type>::max();
+    const uint64_t nnz = csr.adj_indptr[csr.num_rows];
+    std::vector<data_type> dist(csr.num_rows, inf);
+    std::vector<data_type> scratch(csr.num_rows);
+    std::vector<uint32_t> mark(csr.num_rows, 0);
+    std::vector<uint32_t> frontier = {source};
+    dist[source] = 0;
+    TraversalStats local;
+    // a vertex can enter the frontier again when a shorter path shows up, but there are at most
+    // num_rows levels for non-negative weights
+    for (uint32_t level = 1; !frontier.empty() && level <= csr.num_rows; level++) {
+        uint64_t edges = frontier_edges(csc, frontier.data(), frontier.size());
+        if (choose_direction(edges, nnz, alpha) == Direction::Pull) {
+            frontier = sssp_pull_step(csr, dist, scratch, num_threads);
+            local.pull_levels++;
+            local.edges += nnz;
+        } else {
+            frontier = sssp_push_step(csc, dist, mark, frontier, level);
+            local.edges += edges;
+        }
+        local.levels++;
+    }
+    if (stats) *stats = local;
+    return dist;
+}
+
+#endif  // FRONTIER_HPP
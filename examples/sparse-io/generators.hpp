@@ -0,0 +1,300 @@
+#ifndef GENERATORS_HPP
+#define GENERATORS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "sparse-io.hpp"
+#include "parallel-for.hpp"
+#include "edge-list.hpp"
+
+//--------------------------------------------------
+// Seeded random streams
+//--------------------------------------------------
+
+// The generators give every row (or block of edges) its own random stream, derived from the seed
+// and the index of the row: a matrix only depends on its parameters and seed, not on the number of
+// threads, so a scaling study sweeps the same matrices on every machine.
+
+// SplitMix64, small and fast enough to be reseeded per row.
+struct SplitMix64 {
+    /*! \brief The state, advanced by every draw */
+    uint64_t state;
+
+    explicit SplitMix64(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+    // uniform in [0, 1)
+    double uniform() { return (next() >> 11) * 0x1.0p-53; }
+    // uniform in [0, n), n > 0
+    uint32_t below(uint64_t n) { return ((next() >> 32) * n) >> 32; }
+};
+
+
+// The stream of a row or block of a generator.
+inline SplitMix64 random_stream(uint64_t seed, uint64_t stream) {
+    SplitMix64 mix(seed ^ (stream * 0xD1B54A32D192ED03ull));
+    return SplitMix64(mix.next());
+}
+
+
+// A non-zero value, uniform in (0, 1].
+template<typename data_type>
+data_type random_value(SplitMix64 &rng) {
+    return data_type(1.0 - rng.uniform());
+}
+
+
+//--------------------------------------------------
+// Row-by-row construction
+//--------------------------------------------------
+
+// Build a matrix row by row in parallel. row_fn(row, rng, scratch, emit) calls emit(col, value) for
+// the entries of the row in increasing column order; scratch is a vector reused by the thread. It
+// runs twice per row, once to count and once to fill, with the same stream both times.
+template<typename data_type, typename offset_type = uint32_t, typename RowFn>
+CSRMatrix<data_type, uint32_t, offset_type> generate_csr_by_rows(uint32_t num_rows, uint32_t num_cols, uint64_t seed,
+                                                                 RowFn row_fn, unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    CSRMatrix<data_type, uint32_t, offset_type> csr;
+    csr.num_rows = num_rows;
+    csr.num_cols = num_cols;
+    std::vector<uint64_t> row_len(num_rows);
+    parallel_for(0, num_rows, num_threads, [&](size_t begin, size_t end, unsigned) {
+        std::vector<uint32_t> scratch;
+        for (size_t r = begin; r < end; r++) {
+            SplitMix64 rng = random_stream(seed, r);
+            uint64_t len = 0;
+            row_fn(r, rng, scratch, [&](uint32_t, data_type) { len++; });
+            row_len[r] = len;
+        }
+    }, 1024);
+    csr.adj_indptr.resize(size_t(num_rows) + 1);
+    csr.adj_indptr[0] = 0;
+    uint64_t nnz = 0;
+    for (uint32_t r = 0; r < num_rows; r++) {
+        nnz += row_len[r];
+        if (nnz > std::numeric_limits<offset_type>::max()) {
+            throw std::runtime_error("The generated matrix exceeds " + std::to_string(8 * sizeof(offset_type))
+                                     + "-bit offsets, generate it with a 64-bit offset_type");
+        }
+        csr.adj_indptr[r + 1] = nnz;
+    }
+    csr.adj_indices.resize(nnz);
+    csr.adj_data.resize(nnz);
+    parallel_for(0, num_rows, num_threads, [&](size_t begin, size_t end, unsigned) {
+        std::vector<uint32_t> scratch;
+        for (size_t r = begin; r < end; r++) {
+            SplitMix64 rng = random_stream(seed, r);
+            offset_type k = csr.adj_indptr[r];
+            row_fn(r, rng, scratch, [&](uint32_t col, data_type value) {
+                csr.adj_indices[k] = col;
+                csr.adj_data[k++] = value;
+            });
+        }
+    }, 1024);
+    return csr;
+}
+
+
+// Draw k distinct columns with draw() into cols, sorted. k must not exceed the columns draw() reaches.
+template<typename Draw>
+void sample_distinct_columns(size_t k, std::vector<uint32_t> &cols, Draw draw) {
+    cols.clear();
+    while (cols.size() < k) {
+        for (size_t i = cols.size(); i < k; i++) {
+            cols.push_back(draw());
+        }
+        std::sort(cols.begin(), cols.end());
+        cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+    }
+}
+
+
+//--------------------------------------------------
+// Generators
+//--------------------------------------------------
+
+// Uniform random: every row holds nnz_per_row distinct columns drawn uniformly (all of them if
+// nnz_per_row >= num_cols). No locality and no skew, the worst case of the vector gathers.
+template<typename data_type, typename offset_type = uint32_t>
+CSRMatrix<data_type, uint32_t, offset_type> uniform_random_csr(uint32_t num_rows, uint32_t num_cols, uint32_t nnz_per_row,
+                                                               uint64_t seed = 1, unsigned num_threads = 0) {
+    uint32_t k = std::min(nnz_per_row, num_cols);
+    return generate_csr_by_rows<data_type, offset_type>(num_rows, num_cols, seed,
+        [&](uint32_t, SplitMix64 &rng, std::vector<uint32_t> &cols, auto emit) {
+            sample_distinct_columns(k, cols, [&]() { return rng.below(num_cols); });
+            for (uint32_t c : cols) emit(c, random_value<data_type>(rng));
+        }, num_threads);
+}
+
+
+// Banded: the square matrix of n rows with the entries |row - col| <= half_bandwidth, each kept
+// with probability fill. The locality is set by the bandwidth.
+template<typename data_type, typename offset_type = uint32_t>
+CSRMatrix<data_type, uint32_t, offset_type> banded_csr(uint32_t n, uint32_t half_bandwidth, double fill = 1.0,
+                                                       uint64_t seed = 1, unsigned num_threads = 0) {
+    return generate_csr_by_rows<data_type, offset_type>(n, n, seed,
+        [&](uint32_t r, SplitMix64 &rng, std::vector<uint32_t> &, auto emit) {
+            uint32_t first = (r > half_bandwidth) ? r - half_bandwidth : 0;
+            uint32_t last = std::min<uint64_t>(uint64_t(r) + half_bandwidth, n - 1);
+            for (uint64_t c = first; c <= last; c++) {
+                if (fill >= 1.0 || rng.uniform() < fill) emit(c, random_value<data_type>(rng));
+            }
+        }, num_threads);
+}
+
+
+// Block-diagonal: the rows are cut into blocks of block_size, and every row holds nnz_per_row
+// distinct columns drawn from its own block, except a fraction off_block of them drawn from the
+// whole matrix. off_block = 0 gives independent blocks, e.g., a batch of graphs; raising it blurs
+// the communities. nnz_per_row is capped by the columns a row can reach.
+template<typename data_type, typename offset_type = uint32_t>
+CSRMatrix<data_type, uint32_t, offset_type> block_diagonal_csr(uint32_t n, uint32_t block_size, uint32_t nnz_per_row,
+                                                               double off_block = 0.0, uint64_t seed = 1,
+                                                               unsigned num_threads = 0) {
+    block_size = std::max<uint32_t>(block_size, 1);
+    return generate_csr_by_rows<data_type, offset_type>(n, n, seed,
+        [&](uint32_t r, SplitMix64 &rng, std::vector<uint32_t> &cols, auto emit) {
+            uint32_t block_begin = r / block_size * block_size;
+            uint32_t width = std::min<uint64_t>(block_size, n - block_begin);
+            uint32_t k = std::min(nnz_per_row, (off_block > 0) ? n : width);
+            sample_distinct_columns(k, cols, [&]() {
+                return (off_block > 0 && rng.uniform() < off_block) ? rng.below(n) : block_begin + rng.below(width);
+            });
+            for (uint32_t c : cols) emit(c, random_value<data_type>(rng));
+        }, num_threads);
+}
+
+
+// The R-MAT quadrant probabilities, d = 1 - a - b - c. The defaults are those of Graph500.
+struct RMATParameters {
+    /*! \brief The probabilities of the top-left, top-right and bottom-left quadrants */
+    double a = 0.57, b = 0.19, c = 0.19;
+    /*! \brief Relabel the vertices with a fixed bijection, so that the degree does not fall
+     *  with the index as in raw R-MAT */
+    bool scramble = true;
+};
+
+
+// R-MAT (recursive Kronecker) graph of 2^scale vertices and edge_factor * 2^scale edges: every
+// edge descends scale levels of the adjacency matrix, picking a quadrant with the probabilities of
+// params. The degrees follow a power law, skewed by a against d (a = b = c = 0.25 is uniform).
+// Edge (s, t) is entry (s, t); the edges are built with coo_to_csr and options, e.g., deduplicate,
+// symmetrize or remove_self_loops, which are all off by default.
+template<typename data_type, typename offset_type = uint32_t>
+CSRMatrix<data_type, uint32_t, offset_type> rmat_csr(unsigned scale, uint32_t edge_factor, uint64_t seed = 1,
+                                                     RMATParameters const &params = RMATParameters(),
+                                                     EdgeListOptions const &options = EdgeListOptions()) {
+    if (scale > 31) {
+        throw std::runtime_error("R-MAT scale " + std::to_string(scale) + " exceeds 32-bit vertices");
+    }
+    unsigned num_threads = (options.num_threads == 0) ? default_num_threads() : options.num_threads;
+    uint64_t num_vertices = uint64_t(1) << scale;
+    uint64_t num_edges = num_vertices * edge_factor;
+    uint64_t mask = num_vertices - 1;
+    // a bijection of [0, 2^scale): odd multipliers and xor-shifts
+    unsigned shift = std::max(scale / 2, 1u);
+    auto relabel = [&](uint64_t v) -> uint64_t {
+        if (!params.scramble) return v;
+        v = (v * 0x9E3779B97F4A7C15ull) & mask;
+        v ^= v >> shift;
+        return (v * 0xBF58476D1CE4E5B9ull) & mask;
+    };
+    COOMatrix<data_type> coo;
+    coo.num_rows = coo.num_cols = num_vertices;
+    coo.rows.resize(num_edges);
+    coo.cols.resize(num_edges);
+    coo.values.resize(num_edges);
+    // edges in fixed blocks, each with its own stream
+    const uint64_t block = 1 << 16;
+    uint64_t num_blocks = (num_edges + block - 1) / block;
+    double ab = params.a + params.b;
+    double abc = ab + params.c;
+    parallel_for(0, num_blocks, num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t blk = begin; blk < end; blk++) {
+            SplitMix64 rng = random_stream(seed, blk);
+            for (uint64_t e = blk * block; e < std::min(num_edges, (blk + 1) * block); e++) {
+                uint64_t s = 0, t = 0;
+                for (unsigned level = 0; level < scale; level++) {
+                    double u = rng.uniform();
+                    s = (s << 1) | (u >= ab);
+                    t = (t << 1) | ((u >= params.a && u < ab) || u >= abc);
+                }
+                coo.rows[e] = relabel(s);
+                coo.cols[e] = relabel(t);
+                coo.values[e] = random_value<data_type>(rng);
+            }
+        }
+    }, 1);
+    return coo_to_csr<data_type, offset_type>(coo, options);
+}
+
+
+//--------------------------------------------------
+// Dataset specifications
+//--------------------------------------------------
+
+// A float matrix from a generator specification, with the parameters separated by colons and an
+// optional seed last:
+//   rmat:<scale>:<edge factor>[:seed]              (duplicates merged)
+//   uniform:<rows>:<non-zeros per row>[:seed]      (square)
+//   banded:<rows>:<half bandwidth>[:seed]
+//   blockdiag:<rows>:<block size>:<non-zeros per row>[:seed]
+// Returns false if spec does not name a generator.
+inline bool generate_float_csr_matrix(std::string const &spec, CSRMatrix<float> &csr) {
+    std::vector<std::string> fields;
+    for (size_t begin = 0, end; begin <= spec.size(); begin = end + 1) {
+        end = std::min(spec.find(':', begin), spec.size());
+        fields.push_back(spec.substr(begin, end - begin));
+    }
+    size_t num_params;
+    if (fields[0] == "rmat" || fields[0] == "uniform" || fields[0] == "banded") {
+        num_params = 2;
+    } else if (fields[0] == "blockdiag") {
+        num_params = 3;
+    } else {
+        return false;
+    }
+    if (fields.size() != num_params + 1 && fields.size() != num_params + 2) {
+        throw std::runtime_error("Generator " + spec + " takes " + std::to_string(num_params) + " parameters and a seed");
+    }
+    std::vector<uint64_t> p;
+    for (size_t i = 1; i < fields.size(); i++) {
+        p.push_back(std::stoull(fields[i]));
+    }
+    uint64_t seed = (p.size() > num_params) ? p.back() : 1;
+    if (fields[0] == "rmat") {
+        EdgeListOptions options;
+        options.deduplicate = true;
+        csr = rmat_csr<float>(p[0], p[1], seed, RMATParameters(), options);
+    } else if (fields[0] == "uniform") {
+        csr = uniform_random_csr<float>(p[0], p[0], p[1], seed);
+    } else if (fields[0] == "banded") {
+        csr = banded_csr<float>(p[0], p[1], 1.0, seed);
+    } else {
+        csr = block_diagonal_csr<float>(p[0], p[1], p[2], 0.0, seed);
+    }
+    return true;
+}
+
+
+// Generate the matrix if path is a generator specification, e.g., rmat:20:16, or load it.
+inline CSRMatrix<float> load_or_generate_float_csr_matrix(std::string const &path, NpzLoadStats *stats = nullptr) {
+    CSRMatrix<float> csr;
+    if (!generate_float_csr_matrix(path, csr)) {
+        csr = load_float_csr_matrix(path, EdgeListOptions(), stats);
+    }
+    return csr;
+}
+
+#endif  // GENERATORS_HPP
@@ -0,0 +1,388 @@
+#ifndef NPZ_READER_HPP
+#define NPZ_READER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <zlib.h>
+
+#include "parallel-for.hpp"
+
+//--------------------------------------------------
+// npz archives
+//--------------------------------------------------
+
+// A npz file is a zip archive of npy arrays, deflated by scipy.sparse.save_npz(compressed=True) or
+// stored as is. Every member is read by its own thread with its own file stream, and inflated
+// straight into the destination vector: the members of a csr matrix (data, indices, indptr) load
+// concurrently, with no intermediate copy when the stored type is the destination type. A deflate
+// stream is sequential, so the load takes as long as its largest member, usually data or indices.
+
+// A member of a zip archive, from its central directory.
+struct NpzMember {
+    /*! \brief The file name in the archive, e.g., data.npy */
+    std::string name;
+    /*! \brief The zip compression method, 0 (stored) or 8 (deflate) */
+    uint16_t method;
+    /*! \brief The sizes of the member in the archive and once inflated */
+    uint64_t compressed_size, size;
+    /*! \brief The offset of its local header in the archive */
+    uint64_t header_offset;
+};
+
+
+// The bytes and time of a load, to report the decompression throughput.
+struct NpzLoadStats {
+    /*! \brief The bytes read from the archive */
+    uint64_t compressed_bytes = 0;
+    /*! \brief The bytes of the inflated arrays */
+    uint64_t uncompressed_bytes = 0;
+    /*! \brief The wall time of the load */
+    double seconds = 0;
+};
+
+
+inline uint64_t read_le(const unsigned char *p, unsigned bytes) {
+    uint64_t v = 0;
+    for (unsigned i = 0; i < bytes; i++) v |= uint64_t(p[i]) << (8 * i);
+    return v;
+}
+
+
+// List the members of a zip archive, zip64 included.
+inline std::vector<NpzMember> list_npz_members(std::string const &path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    uint64_t file_size = file.tellg();
+    auto read_at = [&](uint64_t offset, size_t n) {
+        std::vector<unsigned char> bytes(n);
+        file.seekg(offset);
+        if (!file.read(reinterpret_cast<char*>(bytes.data()), n)) {
+            throw std::runtime_error(path + ": truncated zip archive");
+        }
+        return bytes;
+    };
+    // the end of central directory record is in the last 64 KB (its comment) + 22 bytes
+    size_t tail_size = std::min<uint64_t>(file_size, 65536 + 22);
+    std::vector<unsigned char> tail = read_at(file_size - tail_size, tail_size);
+    size_t eocd = tail_size;
+    for (size_t i = tail_size >= 22 ? tail_size - 22 + 1 : 0; i-- > 0;) {
+        if (read_le(&tail[i], 4) == 0x06054b50) {
+            eocd = i;
+            break;
+        }
+    }
+    if (eocd == tail_size) {
+        throw std::runtime_error(path + " is not a zip archive");
+    }
+    uint64_t num_entries = read_le(&tail[eocd + 10], 2);
+    uint64_t dir_size = read_le(&tail[eocd + 12], 4);
+    uint64_t dir_offset = read_le(&tail[eocd + 16], 4);
+    if ((num_entries == 0xFFFF || dir_offset == 0xFFFFFFFF) && eocd >= 20
+        && read_le(&tail[eocd - 20], 4) == 0x07064b50) {
+        std::vector<unsigned char> zip64 = read_at(read_le(&tail[eocd - 20 + 8], 8), 56);
+        if (read_le(&zip64[0], 4) != 0x06064b50) {
+            throw std::runtime_error(path + ": malformed zip64 directory");
+        }
+        num_entries = read_le(&zip64[32], 8);
+        dir_size = read_le(&zip64[40], 8);
+        dir_offset = read_le(&zip64[48], 8);
+    }
+    std::vector<unsigned char> dir = read_at(dir_offset, dir_size);
+    std::vector<NpzMember> members;
+    for (size_t p = 0; members.size() < num_entries; ) {
+        if (p + 46 > dir.size() || read_le(&dir[p], 4) != 0x02014b50) {
+            throw std::runtime_error(path + ": malformed zip central directory");
+        }
+        NpzMember m;
+        m.method = read_le(&dir[p + 10], 2);
+        m.compressed_size = read_le(&dir[p + 20], 4);
+        m.size = read_le(&dir[p + 24], 4);
+        m.header_offset = read_le(&dir[p + 42], 4);
+        size_t name_len = read_le(&dir[p + 28], 2);
+        size_t extra_len = read_le(&dir[p + 30], 2);
+        size_t comment_len = read_le(&dir[p + 32], 2);
+        if (p + 46 + name_len + extra_len + comment_len > dir.size()) {
+            throw std::runtime_error(path + ": malformed zip central directory");
+        }
+        m.name.assign(reinterpret_cast<const char*>(&dir[p + 46]), name_len);
+        // the zip64 extra field holds, in order, the 64-bit values of the saturated fields
+        for (size_t e = p + 46 + name_len; e + 4 <= p + 46 + name_len + extra_len; ) {
+            size_t id = read_le(&dir[e], 2);
+            size_t len = read_le(&dir[e + 2], 2);
+            if (id == 0x0001) {
+                size_t f = e + 4;
+                for (uint64_t *field : {&m.size, &m.compressed_size, &m.header_offset}) {
+                    if (*field == 0xFFFFFFFF && f + 8 <= e + 4 + len) {
+                        *field = read_le(&dir[f], 8);
+                        f += 8;
+                    }
+                }
+            }
+            e += 4 + len;
+        }
+        members.push_back(m);
+        p += 46 + name_len + extra_len + comment_len;
+    }
+    return members;
+}
+
+
+// Sequential reader of the inflated bytes of one member, with its own file stream.
+class NpzMemberReader {
+public:
+    NpzMemberReader(std::string const &path, NpzMember const &member)
+        : path_(path), member_(member), file_(path, std::ios::binary), remaining_(member.compressed_size) {
+        if (!file_) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        if (member.method != 0 && member.method != 8) {
+            throw std::runtime_error(path + ": " + member.name + " uses unsupported zip method "
+                                     + std::to_string(member.method));
+        }
+        unsigned char header[30];
+        file_.seekg(member.header_offset);
+        if (!file_.read(reinterpret_cast<char*>(header), 30) || read_le(header, 4) != 0x04034b50) {
+            throw std::runtime_error(path + ": malformed local header of " + member.name);
+        }
+        file_.seekg(member.header_offset + 30 + read_le(header + 26, 2) + read_le(header + 28, 2));
+        if (member.method == 8) {
+            std::memset(&stream_, 0, sizeof(stream_));
+            // raw deflate, without the zlib header
+            if (inflateInit2(&stream_, -MAX_WBITS) != Z_OK) {
+                throw std::runtime_error("inflateInit2 failed");
+            }
+            inflating_ = true;
+            input_.resize(1 << 22);
+        }
+    }
+
+    ~NpzMemberReader() {
+        if (inflating_) inflateEnd(&stream_);
+    }
+
+    NpzMemberReader(NpzMemberReader const &) = delete;
+    NpzMemberReader &operator=(NpzMemberReader const &) = delete;
+
+    // Read the next n inflated bytes to out.
+    void read(void *out, size_t n) {
+        if (!inflating_) {
+            if (n > remaining_ || !file_.read(static_cast<char*>(out), n)) fail();
+            remaining_ -= n;
+            return;
+        }
+        unsigned char *dest = static_cast<unsigned char*>(out);
+        while (n > 0) {
+            if (stream_.avail_in == 0) {
+                size_t chunk = std::min<uint64_t>(input_.size(), remaining_);
+                if (chunk == 0 || !file_.read(reinterpret_cast<char*>(input_.data()), chunk)) fail();
+                remaining_ -= chunk;
+                stream_.next_in = input_.data();
+                stream_.avail_in = chunk;
+            }
+            // avail_out is 32-bit
+            uInt step = std::min<size_t>(n, 1u << 30);
+            stream_.next_out = dest;
+            stream_.avail_out = step;
+            int status = inflate(&stream_, Z_NO_FLUSH);
+            size_t produced = step - stream_.avail_out;
+            dest += produced;
+            n -= produced;
+            if ((status == Z_STREAM_END && n > 0) || (status != Z_OK && status != Z_STREAM_END)) fail();
+        }
+    }
+
+private:
+    [[noreturn]] void fail() {
+        throw std::runtime_error(path_ + ": " + member_.name + " is truncated or corrupt");
+    }
+
+    std::string path_;
+    NpzMember member_;
+    std::ifstream file_;
+    uint64_t remaining_;
+    bool inflating_ = false;
+    z_stream stream_;
+    std::vector<unsigned char> input_;
+};
+
+
+// The header of a npy array: its element type and number of elements.
+struct NpyHeader {
+    /*! \brief The numpy kind, 'f' (float), 'i' (signed) or 'u' (unsigned) integer */
+    char kind;
+    /*! \brief The bytes per element */
+    size_t word_size;
+    /*! \brief The number of elements, the product of the shape */
+    uint64_t num_vals;
+};
+
+
+// Read the header at the start of a npy member. Only little-endian, C-order arrays are supported.
+inline NpyHeader read_npy_header(NpzMemberReader &reader, std::string const &name) {
+    unsigned char preamble[12];
+    reader.read(preamble, 10);
+    if (std::memcmp(preamble, "\x93NUMPY", 6) != 0) {
+        throw std::runtime_error(name + " is not a npy array");
+    }
+    size_t header_len = read_le(preamble + 8, 2);
+    if (preamble[6] >= 2) {
+        reader.read(preamble + 10, 2);
+        header_len = read_le(preamble + 8, 4);
+    }
+    std::string header(header_len, '\0');
+    reader.read(&header[0], header_len);
+    auto value_of = [&](std::string const &key) {
+        size_t pos = header.find("'" + key + "'");
+        if (pos == std::string::npos) {
+            throw std::runtime_error(name + ": npy header without " + key);
+        }
+        return header.substr(header.find(':', pos) + 1);
+    };
+    NpyHeader npy;
+    std::string descr = value_of("descr");
+    descr = descr.substr(descr.find('\'') + 1);
+    std::string order = value_of("fortran_order");
+    if ((descr[0] != '<' && descr[0] != '|') || order.compare(order.find_first_not_of(' '), 4, "True") == 0) {
+        throw std::runtime_error(name + ": only little-endian C-order npy arrays are supported");
+    }
+    npy.kind = descr[1];
+    npy.word_size = std::stoul(descr.substr(2));
+    std::string shape = value_of("shape");
+    shape = shape.substr(shape.find('(') + 1, shape.find(')') - shape.find('(') - 1);
+    npy.num_vals = 1;
+    for (size_t pos = 0; pos < shape.size(); ) {
+        size_t digit = shape.find_first_of("0123456789", pos);
+        if (digit == std::string::npos) break;
+        size_t end = shape.find_first_not_of("0123456789", digit);
+        npy.num_vals *= std::stoull(shape.substr(digit, end - digit));
+        pos = end;
+    }
+    return npy;
+}
+
+
+// Read the npy array of a member into out, converted to out_type. Integers are read as
+// non-negative and throw if they do not fit in out_type, instead of wrapping around. An integer
+// out_type (e.g., indices) only accepts integer arrays. An array stored as out_type is inflated
+// straight into out.
+template<typename out_type>
+void read_npy_array(NpzMemberReader &reader, std::string const &name, std::vector<out_type> &out) {
+    NpyHeader npy = read_npy_header(reader, name);
+    if (std::is_integral<out_type>::value && npy.kind != 'i' && npy.kind != 'u') {
+        throw std::runtime_error("npz array " + name + " has type " + std::string(1, npy.kind)
+                                 + std::to_string(npy.word_size) + ", an integer array is expected");
+    }
+    out.resize(npy.num_vals);
+    bool same_type = npy.word_size == sizeof(out_type)
+                     && (std::is_floating_point<out_type>::value ? npy.kind == 'f' : npy.kind != 'f');
+    if (same_type) {
+        reader.read(out.data(), npy.num_vals * sizeof(out_type));
+        // a negative signed integer read as unsigned has its top bit set
+        if (!std::is_floating_point<out_type>::value && npy.kind == 'i' && !out.empty()) {
+            bool negative = std::is_signed<out_type>::value
+                            ? *std::min_element(out.begin(), out.end()) < 0
+                            : *std::max_element(out.begin(), out.end()) > std::numeric_limits<out_type>::max() / 2;
+            if (negative) {
+                throw std::runtime_error("npz array " + name + " holds negative values");
+            }
+        }
+        return;
+    }
+    // convert through a staging buffer
+    auto convert = [&](auto type_tag) {
+        using in_type = decltype(type_tag);
+        std::vector<in_type> staging(std::min<uint64_t>(npy.num_vals, 1 << 20));
+        for (uint64_t done = 0; done < npy.num_vals; done += staging.size()) {
+            size_t n = std::min<uint64_t>(staging.size(), npy.num_vals - done);
+            reader.read(staging.data(), n * sizeof(in_type));
+            for (size_t i = 0; i < n; i++) {
+                if constexpr (std::is_integral_v<in_type> && std::is_integral_v<out_type>) {
+                    bool negative = false;
+                    if constexpr (std::is_signed_v<in_type>) negative = staging[i] < 0;
+                    if (negative || uint64_t(staging[i]) > uint64_t(std::numeric_limits<out_type>::max())) {
+                        throw std::runtime_error("npz array " + name + " holds " + std::to_string(staging[i])
+                                                 + ", outside the " + std::to_string(8 * sizeof(out_type))
+                                                 + "-bit index type");
+                    }
+                }
+                out[done + i] = staging[i];
+            }
+        }
+    };
+    if (npy.kind == 'f' && npy.word_size == 4) convert(float());
+    else if (npy.kind == 'f' && npy.word_size == 8) convert(double());
+    else if (npy.kind == 'i' && npy.word_size == 4) convert(int32_t());
+    else if (npy.kind == 'i' && npy.word_size == 8) convert(int64_t());
+    else if (npy.kind == 'u' && npy.word_size == 4) convert(uint32_t());
+    else if (npy.kind == 'u' && npy.word_size == 8) convert(uint64_t());
+    else {
+        throw std::runtime_error("npz array " + name + " has unsupported type " + std::string(1, npy.kind)
+                                 + std::to_string(npy.word_size));
+    }
+}
+
+
+// Load arrays of a npz file in parallel, one thread per array: load(i, reader) reads the array of
+// members[i] with reader. The first error of any thread is rethrown.
+template<typename LoadFn>
+void load_npz_members(std::string const &path, std::vector<std::string> const &names, LoadFn load,
+                      NpzLoadStats *stats = nullptr) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<NpzMember> members = list_npz_members(path);
+    std::vector<NpzMember> wanted;
+    for (std::string const &name : names) {
+        auto it = std::find_if(members.begin(), members.end(),
+                               [&](NpzMember const &m) { return m.name == name + ".npy"; });
+        if (it == members.end()) {
+            throw std::runtime_error(path + " has no array " + name);
+        }
+        wanted.push_back(*it);
+    }
+    std::vector<std::exception_ptr> errors(wanted.size());
+    parallel_run(wanted.size(), [&](unsigned i) {
+        try {
+            NpzMemberReader reader(path, wanted[i]);
+            load(i, reader);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    });
+    for (auto &error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+    if (stats) {
+        for (NpzMember const &m : wanted) {
+            stats->compressed_bytes += m.compressed_size;
+            stats->uncompressed_bytes += m.size;
+        }
+        stats->seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+
+// Print the decompression throughput of a load. The stream keeps its formatting.
+inline void print_npz_load_report(std::ostream &os, NpzLoadStats const &stats) {
+    double seconds = std::max(stats.seconds, 1e-9);
+    std::ostringstream line;
+    line << "INFO : npz load " << std::fixed << std::setprecision(1) << stats.compressed_bytes / 1e6 << " MB -> "
+         << stats.uncompressed_bytes / 1e6 << " MB in " << std::setprecision(3) << stats.seconds << " s, "
+         << std::setprecision(1) << stats.uncompressed_bytes / 1e6 / seconds << " MB/s inflated";
+    os << line.str() << std::endl;
+}
+
+#endif  // NPZ_READER_HPP
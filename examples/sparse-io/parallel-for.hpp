@@ -0,0 +1,49 @@
+#ifndef PARALLEL_FOR_HPP
+#define PARALLEL_FOR_HPP
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// The number of worker threads used when the caller does not pick one.
+inline unsigned default_num_threads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return (n == 0) ? 1 : n;
+}
+
+
+// Run fn(thread_id) on num_threads threads and wait for all of them.
+// Thread 0 runs on the calling thread.
+template<typename Fn>
+void parallel_run(unsigned num_threads, Fn fn) {
+    if (num_threads <= 1) {
+        fn(0u);
+        return;
+    }
+    std::vector<std::thread> workers;
+    workers.reserve(num_threads - 1);
+    for (unsigned t = 1; t < num_threads; t++) {
+        workers.emplace_back(fn, t);
+    }
+    fn(0u);
+    for (auto &w : workers) {
+        w.join();
+    }
+}
+
+
+// Split [begin, end) into num_threads contiguous chunks and run fn(chunk_begin, chunk_end, thread_id)
+// on each chunk in parallel. Small ranges run on fewer threads.
+template<typename Fn>
+void parallel_for(size_t begin, size_t end, unsigned num_threads, Fn fn, size_t min_chunk = 4096) {
+    size_t n = (end > begin) ? end - begin : 0;
+    size_t max_threads = (n + min_chunk - 1) / min_chunk;
+    if (max_threads < num_threads) num_threads = (max_threads == 0) ? 1 : max_threads;
+    parallel_run(num_threads, [&](unsigned t) {
+        size_t chunk_begin = begin + n * t / num_threads;
+        size_t chunk_end = begin + n * (t + 1) / num_threads;
+        fn(chunk_begin, chunk_end, t);
+    });
+}
+
+#endif  // PARALLEL_FOR_HPP
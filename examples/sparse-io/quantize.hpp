@@ -0,0 +1,436 @@
+#ifndef QUANTIZE_HPP
+#define QUANTIZE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "sparse-io.hpp"
+#include "parallel-for.hpp"
+#include "spmv-cpu.hpp"
+
+//--------------------------------------------------
+// Reduced-precision values
+//--------------------------------------------------
+
+// The values of a csr matrix are stored in a smaller format, the indices are unchanged. A format
+// maps a float to its storage type and back: decode(encode(v / scale)) * scale ~ v. Scaled formats
+// (int8) keep one scale per row, or per block of scale_block consecutive non-zeros. The SpMV below
+// reads the compressed values directly, so a value array of 1/2 or 1/4 of the float size is also
+// 1/2 or 1/4 of the memory traffic of the values.
+
+inline uint32_t float_bits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+inline float bits_float(uint32_t u) {
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+
+// IEEE half precision, round to nearest even (hardware conversions with F16C).
+struct FP16Format {
+    using storage_type = uint16_t;
+    static constexpr bool scaled = false;
+    static const char *name() { return "fp16"; }
+
+    static uint16_t encode(float value) {
+        const uint32_t f32_infinity = 255u << 23;
+        const uint32_t f16_max = (127u + 16) << 23;
+        const float denorm_magic = bits_float(((127u - 15) + (23 - 10) + 1) << 23);
+        uint32_t f = float_bits(value);
+        uint32_t sign = f & 0x80000000u;
+        f ^= sign;
+        uint16_t h;
+        if (f >= f16_max) {
+            h = (f > f32_infinity) ? 0x7e00 : 0x7c00; // NaN stays NaN, overflow goes to infinity
+        } else if (f < (113u << 23)) {
+            // subnormal half: let the float adder round the mantissa
+            h = float_bits(bits_float(f) + denorm_magic) - float_bits(denorm_magic);
+        } else {
+            uint32_t mantissa_odd = (f >> 13) & 1;
+            f += ((15u - 127) << 23) + 0xfff + mantissa_odd;
+            h = f >> 13;
+        }
+        return h | (sign >> 16);
+    }
+
+    static float decode(uint16_t h) {
+        const float magic = bits_float(113u << 23);
+        const uint32_t shifted_exp = 0x7c00u << 13;
+        uint32_t f = (h & 0x7fffu) << 13;
+        uint32_t exp = shifted_exp & f;
+        f += (127u - 15) << 23;
+        if (exp == shifted_exp) {
+            f += (128u - 16) << 23; // infinity or NaN
+        } else if (exp == 0) {
+            f = float_bits(bits_float(f + (1u << 23)) - magic); // subnormal
+        }
+        return bits_float(f | ((h & 0x8000u) << 16));
+    }
+
+#if defined(__AVX2__) && defined(__F16C__)
+    static constexpr bool has_vector = true;
+    static __m256 decode8(const uint16_t *h) {
+        return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)h));
+    }
+    static void encode8(const float *f, uint16_t *h) {
+        _mm_storeu_si128((__m128i*)h, _mm256_cvtps_ph(_mm256_loadu_ps(f), _MM_FROUND_TO_NEAREST_INT));
+    }
+#else
+    static constexpr bool has_vector = false;
+#endif
+};
+
+
+// bfloat16: the upper half of a float, round to nearest even. Same range as float, 8-bit mantissa.
+struct BF16Format {
+    using storage_type = uint16_t;
+    static constexpr bool scaled = false;
+    static const char *name() { return "bf16"; }
+
+    static uint16_t encode(float value) {
+        uint32_t f = float_bits(value);
+        if ((f & 0x7fffffffu) > 0x7f800000u) {
+            return (f >> 16) | 0x40; // keep NaN quiet
+        }
+        return (f + 0x7fff + ((f >> 16) & 1)) >> 16;
+    }
+
+    static float decode(uint16_t b) { return bits_float((uint32_t)b << 16); }
+
+#if defined(__AVX2__)
+    static constexpr bool has_vector = true;
+    static __m256 decode8(const uint16_t *b) {
+        __m256i wide = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)b));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(wide, 16));
+    }
+    static void encode8(const float *f, uint16_t *b) {
+        __m256i u = _mm256_castps_si256(_mm256_loadu_ps(f));
+        __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(u, 16), _mm256_set1_epi32(1));
+        __m256i rounded = _mm256_srli_epi32(_mm256_add_epi32(_mm256_add_epi32(u, _mm256_set1_epi32(0x7fff)), lsb), 16);
+        __m256i nan = _mm256_cmpgt_epi32(_mm256_and_si256(u, _mm256_set1_epi32(0x7fffffff)),
+                                         _mm256_set1_epi32(0x7f800000));
+        __m256i quiet = _mm256_or_si256(_mm256_srli_epi32(u, 16), _mm256_set1_epi32(0x40));
+        __m256i res = _mm256_blendv_epi8(rounded, quiet, nan);
+        _mm_storeu_si128((__m128i*)b, _mm_packus_epi32(_mm256_castsi256_si128(res), _mm256_extracti128_si256(res, 1)));
+    }
+#else
+    static constexpr bool has_vector = false;
+#endif
+};
+
+
+// Symmetric int8 in [-127, 127], scaled by max |value| / 127 of its row or block.
+struct Int8Format {
+    using storage_type = int8_t;
+    static constexpr bool scaled = true;
+    static const char *name() { return "int8"; }
+
+    static int8_t encode(float value) {
+        return (int8_t)std::max(-127.0f, std::min(127.0f, std::nearbyint(value)));
+    }
+
+    static float decode(int8_t q) { return q; }
+
+    // the scale of values whose largest magnitude is max_abs
+    static float scale_for(float max_abs) { return max_abs / 127.0f; }
+
+#if defined(__AVX2__)
+    static constexpr bool has_vector = true;
+    static __m256 decode8(const int8_t *q) {
+        return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i*)q)));
+    }
+    static void encode8(const float *f, int8_t *q) {
+        __m256 v = _mm256_round_ps(_mm256_loadu_ps(f), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        // min before max and NaN in the first operand, as the scalar encode: NaN goes to 127
+        v = _mm256_max_ps(_mm256_min_ps(v, _mm256_set1_ps(127.0f)), _mm256_set1_ps(-127.0f));
+        __m256i i32 = _mm256_cvtps_epi32(v);
+        __m128i i16 = _mm_packs_epi32(_mm256_castsi256_si128(i32), _mm256_extracti128_si256(i32, 1));
+        _mm_storel_epi64((__m128i*)q, _mm_packs_epi16(i16, i16));
+    }
+#else
+    static constexpr bool has_vector = false;
+#endif
+};
+
+
+// Signed 32-bit fixed point with frac_bits fractional bits, saturating, e.g., FixedFormat<24> is
+// the ap_fixed<32, 8> of the deprecated kernels.
+template<int frac_bits>
+struct FixedFormat {
+    using storage_type = int32_t;
+    static constexpr bool scaled = false;
+    static const char *name() { return "fixed"; }
+
+    static int32_t encode(float value) {
+        double q = std::nearbyint((double)value * (double)(1ll << frac_bits));
+        return (int32_t)std::max<double>(INT32_MIN, std::min<double>(INT32_MAX, q));
+    }
+
+    static float decode(int32_t q) { return (float)q * (1.0f / (float)(1ll << frac_bits)); }
+
+#if defined(__AVX2__)
+    static constexpr bool has_vector = true;
+    static __m256 decode8(const int32_t *q) {
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)q)),
+                             _mm256_set1_ps(1.0f / (float)(1ll << frac_bits)));
+    }
+    static void encode8(const float *f, int32_t *q) {
+        // in double, as the scalar encode, so the saturation bounds are exact
+        const __m256d unit = _mm256_set1_pd((double)(1ll << frac_bits));
+        for (int h = 0; h < 2; h++) {
+            __m256d d = _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(f + 4 * h)), unit);
+            d = _mm256_round_pd(d, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            d = _mm256_max_pd(_mm256_min_pd(d, _mm256_set1_pd(INT32_MAX)), _mm256_set1_pd(INT32_MIN));
+            _mm_storeu_si128((__m128i*)(q + 4 * h), _mm256_cvtpd_epi32(d));
+        }
+    }
+#else
+    static constexpr bool has_vector = false;
+#endif
+};
+
+
+// Data structure for a csr matrix with reduced-precision values.
+template<typename format>
+struct QuantizedCSRMatrix {
+    /*! \brief The matrix with values in the storage type of the format */
+    CSRMatrix<typename format::storage_type> matrix;
+    /*! \brief The scales of a scaled format, one per row or per block, empty otherwise */
+    std::vector<float> scales;
+    /*! \brief The number of consecutive non-zeros sharing a scale, 0 for one scale per row */
+    uint32_t scale_block;
+
+    // the scale of non-zero i of row
+    float scale(uint32_t row, size_t i) const {
+        if (!format::scaled) return 1.0f;
+        return this->scale_block ? this->scales[i / this->scale_block] : this->scales[row];
+    }
+};
+
+
+// Quantize the values of a float csr matrix on num_threads threads (0 means all cores).
+// scale_block only applies to scaled formats: 0 gives one scale per row, otherwise one scale per
+// block of scale_block consecutive non-zeros.
+template<typename format>
+QuantizedCSRMatrix<format> quantize_csr_matrix(CSRMatrix<float> const &in, uint32_t scale_block = 0,
+                                               unsigned num_threads = 0) {
+    using storage_type = typename format::storage_type;
+    if (num_threads == 0) num_threads = default_num_threads();
+    QuantizedCSRMatrix<format> out;
+    out.matrix.num_rows = in.num_rows;
+    out.matrix.num_cols = in.num_cols;
+    out.matrix.adj_indices = in.adj_indices;
+    out.matrix.adj_indptr = in.adj_indptr;
+    out.scale_block = format::scaled ? scale_block : 0;
+    size_t nnz = in.adj_data.size();
+    out.matrix.adj_data.resize(nnz);
+    const float *src = in.adj_data.data();
+    storage_type *dst = out.matrix.adj_data.data();
+
+    if constexpr (!format::scaled) {
+        parallel_for(0, nnz, num_threads, [&](size_t begin, size_t end, unsigned) {
+            size_t i = begin;
+            if constexpr (format::has_vector) {
+                for (; i + 8 <= end; i += 8) format::encode8(src + i, dst + i);
+            }
+            for (; i < end; i++) dst[i] = format::encode(src[i]);
+        }, 1 << 16);
+    } else {
+        // a group is a row, or a block of non-zeros, sharing one scale
+        size_t num_groups = out.scale_block ? (nnz + out.scale_block - 1) / out.scale_block : in.num_rows;
+        out.scales.resize(num_groups);
+        auto group_range = [&](size_t g) {
+            if (out.scale_block) return std::make_pair(g * out.scale_block, std::min(nnz, (g + 1) * out.scale_block));
+            return std::make_pair((size_t)in.adj_indptr[g], (size_t)in.adj_indptr[g + 1]);
+        };
+        parallel_for(0, num_groups, num_threads, [&](size_t begin, size_t end, unsigned) {
+            for (size_t g = begin; g < end; g++) {
+                auto range = group_range(g);
+                float max_abs = 0;
+                for (size_t i = range.first; i < range.second; i++) max_abs = std::max(max_abs, std::fabs(src[i]));
+                float scale = format::scale_for(max_abs);
+                float inv = (scale > 0) ? 1.0f / scale : 0.0f;
+                out.scales[g] = scale;
+                size_t i = range.first;
+                if constexpr (format::has_vector) {
+                    float scaled[8];
+                    for (; i + 8 <= range.second; i += 8) {
+                        for (int k = 0; k < 8; k++) scaled[k] = src[i + k] * inv;
+                        format::encode8(scaled, dst + i);
+                    }
+                }
+                for (; i < range.second; i++) dst[i] = format::encode(src[i] * inv);
+            }
+        }, 256);
+    }
+    return out;
+}
+
+
+// Decode the values back to float, e.g., to measure the error or to feed a float kernel.
+template<typename format>
+std::vector<float> dequantize_values(QuantizedCSRMatrix<format> const &q, unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    CSRMatrix<typename format::storage_type> const &m = q.matrix;
+    std::vector<float> out(m.adj_data.size());
+    parallel_for(0, m.num_rows, num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t r = begin; r < end; r++) {
+            for (uint32_t i = m.adj_indptr[r]; i < m.adj_indptr[r + 1]; i++) {
+                out[i] = format::decode(m.adj_data[i]) * q.scale(r, i);
+            }
+        }
+    }, 256);
+    return out;
+}
+
+
+// The storage saving and the error of a quantized matrix against the float matrix.
+struct QuantizationReport {
+    /*! \brief The name of the format */
+    const char *format;
+    /*! \brief The bytes of the float values */
+    size_t float_bytes;
+    /*! \brief The bytes of the quantized values and their scales */
+    size_t quantized_bytes;
+    /*! \brief The largest absolute error of a value */
+    double max_abs_error;
+    /*! \brief The mean absolute error of the values */
+    double mean_abs_error;
+    /*! \brief The root mean square error of the values */
+    double rms_error;
+    /*! \brief The largest error relative to the magnitude of the value, over non-zero values */
+    double max_rel_error;
+};
+
+
+template<typename format>
+QuantizationReport quantization_report(CSRMatrix<float> const &in, QuantizedCSRMatrix<format> const &q,
+                                       unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    std::vector<float> decoded = dequantize_values(q, num_threads);
+    size_t nnz = decoded.size();
+    struct Partial { double max_abs = 0, sum_abs = 0, sum_sq = 0, max_rel = 0; };
+    std::vector<Partial> partials(num_threads);
+    parallel_for(0, nnz, num_threads, [&](size_t begin, size_t end, unsigned t) {
+        Partial p;
+        for (size_t i = begin; i < end; i++) {
+            double err = std::fabs((double)decoded[i] - in.adj_data[i]);
+            p.max_abs = std::max(p.max_abs, err);
+            p.sum_abs += err;
+            p.sum_sq += err * err;
+            if (in.adj_data[i] != 0) p.max_rel = std::max(p.max_rel, err / std::fabs(in.adj_data[i]));
+        }
+        partials[t] = p;
+    }, 1 << 16);
+    QuantizationReport report = {format::name(), nnz * sizeof(float),
+                                 nnz * sizeof(typename format::storage_type) + q.scales.size() * sizeof(float),
+                                 0, 0, 0, 0};
+    double sum_abs = 0, sum_sq = 0;
+    for (Partial const &p : partials) {
+        report.max_abs_error = std::max(report.max_abs_error, p.max_abs);
+        report.max_rel_error = std::max(report.max_rel_error, p.max_rel);
+        sum_abs += p.sum_abs;
+        sum_sq += p.sum_sq;
+    }
+    report.mean_abs_error = nnz ? sum_abs / nnz : 0;
+    report.rms_error = nnz ? std::sqrt(sum_sq / nnz) : 0;
+    return report;
+}
+
+
+inline void print_quantization_report(std::ostream &stream, QuantizationReport const &report) {
+    stream << report.format << ": " << report.quantized_bytes << " bytes for " << report.float_bytes
+           << " float bytes (" << (double)report.quantized_bytes / std::max<size_t>(report.float_bytes, 1) * 100
+           << "%), max abs error " << report.max_abs_error << ", mean abs error " << report.mean_abs_error
+           << ", rms error " << report.rms_error << ", max rel error " << report.max_rel_error << std::endl;
+}
+
+
+//--------------------------------------------------
+// CPU SpMV on quantized values
+//--------------------------------------------------
+
+// Dot product of a row of decoded values with vector, using AVX2 decodes and gathers if available.
+template<typename format>
+inline float quantized_row_dot(const typename format::storage_type *values, const uint32_t *indices,
+                               uint32_t len, const float *vector) {
+    uint32_t i = 0;
+    float res = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+    if constexpr (format::has_vector) {
+        __m256 acc = _mm256_setzero_ps();
+        for (; i + 8 <= len; i += 8) {
+            __m256i idx = _mm256_loadu_si256((const __m256i*)(indices + i));
+            acc = _mm256_fmadd_ps(format::decode8(values + i), _mm256_i32gather_ps(vector, idx, 4), acc);
+        }
+        __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+        sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+        res = _mm_cvtss_f32(sum4);
+    }
+#endif
+    for (; i < len; i++) {
+        res += format::decode(values[i]) * vector[indices[i]];
+    }
+    return res;
+}
+
+
+// Compute vector_out[r] = (q * vector_in)[r] for rows in [row_begin, row_end) on the calling thread.
+// A row scale multiplies the dot product once, block scales are applied per block.
+template<typename format>
+void spmv_quantized_rows(QuantizedCSRMatrix<format> const &q, const float *vector_in, float *vector_out,
+                         uint32_t row_begin, uint32_t row_end) {
+    CSRMatrix<typename format::storage_type> const &m = q.matrix;
+    const typename format::storage_type *values = m.adj_data.data();
+    const uint32_t *indices = m.adj_indices.data();
+    for (uint32_t r = row_begin; r < row_end; r++) {
+        uint32_t start = m.adj_indptr[r];
+        uint32_t end = m.adj_indptr[r + 1];
+        if (!format::scaled || q.scale_block == 0) {
+            float dot = quantized_row_dot<format>(values + start, indices + start, end - start, vector_in);
+            vector_out[r] = format::scaled ? dot * q.scales[r] : dot;
+            continue;
+        }
+        // split the row at block boundaries, one scale per piece
+        float res = 0;
+        for (uint32_t i = start; i < end;) {
+            uint32_t next = std::min<uint64_t>(end, ((uint64_t)i / q.scale_block + 1) * q.scale_block);
+            res += q.scales[i / q.scale_block]
+                 * quantized_row_dot<format>(values + i, indices + i, next - i, vector_in);
+            i = next;
+        }
+        vector_out[r] = res;
+    }
+}
+
+
+// Compute q * vector_in on num_threads threads (0 means all cores), balancing the threads by non-zeros.
+template<typename format>
+void spmv_quantized_parallel(QuantizedCSRMatrix<format> const &q, const float *vector_in, float *vector_out,
+                             unsigned num_threads = 0) {
+    CSRMatrix<typename format::storage_type> const &m = q.matrix;
+    if (m.num_rows == 0) return;
+    if (num_threads == 0) num_threads = default_num_threads();
+    size_t work = m.adj_indptr[m.num_rows];
+    num_threads = std::max<size_t>(1, std::min<size_t>({num_threads, m.num_rows, (work + 4095) / 4096}));
+    std::vector<uint32_t> bounds = partition_rows_by_nnz(m, num_threads);
+    parallel_run(num_threads, [&](unsigned t) {
+        spmv_quantized_rows<format>(q, vector_in, vector_out, bounds[t], bounds[t + 1]);
+    });
+}
+
+#endif  // QUANTIZE_HPP
@@ -0,0 +1,471 @@
+#ifndef REORDER_HPP
+#define REORDER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sparse-io.hpp"
+#include "parallel-for.hpp"
+
+//--------------------------------------------------
+// Vertex orders
+//--------------------------------------------------
+
+// An order lists the rows (and, for a square matrix, the columns) in their new order: order[i] is
+// the old index of the new row i. Its inverse, the rank, maps an old index to the new one. The
+// SpMV gathers vector_in[col] in the order of the columns, so an order that keeps the columns of
+// each row close to each other turns scattered reads into cache line and HBM burst hits.
+
+// The rank of every old index, rank[order[i]] = i.
+template<typename index_type>
+std::vector<index_type> invert_order(std::vector<index_type> const &order, unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    std::vector<index_type> rank(order.size());
+    parallel_for(0, order.size(), num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t i = begin; i < end; i++) {
+            rank[order[i]] = i;
+        }
+    });
+    return rank;
+}
+
+
+// Stable sort: each thread sorts a chunk, then the chunks are merged pairwise in parallel rounds.
+template<typename T, typename Compare>
+void parallel_stable_sort(std::vector<T> &v, Compare comp, unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    num_threads = std::max<size_t>(1, std::min<size_t>(num_threads, v.size() / 4096));
+    std::vector<size_t> bounds(num_threads + 1);
+    for (unsigned t = 0; t <= num_threads; t++) {
+        bounds[t] = v.size() * t / num_threads;
+    }
+    parallel_run(num_threads, [&](unsigned t) {
+        std::stable_sort(v.begin() + bounds[t], v.begin() + bounds[t + 1], comp);
+    });
+    for (size_t width = 1; width < num_threads; width *= 2) {
+        unsigned num_merges = (num_threads + 2 * width - 1) / (2 * width);
+        parallel_run(num_merges, [&](unsigned m) {
+            size_t mid = std::min<size_t>(2 * width * m + width, num_threads);
+            size_t last = std::min<size_t>(2 * width * (m + 1), num_threads);
+            std::inplace_merge(v.begin() + bounds[2 * width * m], v.begin() + bounds[mid],
+                               v.begin() + bounds[last], comp);
+        });
+    }
+}
+
+
+// Reorder a vector in place to the new order, x[i] becomes x[order[i]]. The cycles of the order are
+// followed with one bit per entry, instead of a second copy of the vector.
+template<typename T, typename index_type>
+void permute_vector(T *x, std::vector<index_type> const &order) {
+    std::vector<bool> done(order.size(), false);
+    for (size_t i = 0; i < order.size(); i++) {
+        if (done[i]) continue;
+        T first = std::move(x[i]);
+        size_t j = i;
+        while (order[j] != i) {
+            x[j] = std::move(x[order[j]]);
+            done[j] = true;
+            j = order[j];
+        }
+        x[j] = std::move(first);
+        done[j] = true;
+    }
+}
+
+
+// Bring a vector in the new order back to the old one in place, x[order[i]] becomes x[i], e.g., the
+// result of an SpMV on the reordered matrix.
+template<typename T, typename index_type>
+void unpermute_vector(T *x, std::vector<index_type> const &order) {
+    std::vector<bool> done(order.size(), false);
+    for (size_t i = 0; i < order.size(); i++) {
+        if (done[i]) continue;
+        T carry = std::move(x[i]);
+        size_t j = i;
+        do {
+            j = order[j];
+            std::swap(carry, x[j]);
+            done[j] = true;
+        } while (j != i);
+    }
+}
+
+
+// The matrix with row i taken from row row_order[i] and column j from column col_order[j], i.e.,
+// P * A * Q^T. An empty col_order keeps the columns. The rows are written once, straight into the
+// result, with their columns sorted.
+template<typename data_type, typename index_type, typename offset_type>
+CSRMatrix<data_type, index_type, offset_type>
+permute_csr(CSRMatrix<data_type, index_type, offset_type> const &csr, std::vector<index_type> const &row_order,
+            std::vector<index_type> const &col_order = {}, unsigned num_threads = 0) {
+    if (row_order.size() != csr.num_rows || (!col_order.empty() && col_order.size() != csr.num_cols)) {
+        throw std::runtime_error("The order does not match the size of the matrix");
+    }
+    if (num_threads == 0) num_threads = default_num_threads();
+    std::vector<index_type> col_rank;
+    if (!col_order.empty()) {
+        col_rank = invert_order(col_order, num_threads);
+    }
+    CSRMatrix<data_type, index_type, offset_type> out;
+    out.num_rows = csr.num_rows;
+    out.num_cols = csr.num_cols;
+    out.adj_indptr.resize(size_t(csr.num_rows) + 1);
+    out.adj_indptr[0] = 0;
+    for (size_t i = 0; i < row_order.size(); i++) {
+        index_type r = row_order[i];
+        out.adj_indptr[i + 1] = out.adj_indptr[i] + (csr.adj_indptr[r + 1] - csr.adj_indptr[r]);
+    }
+    out.adj_data.resize(csr.adj_data.size());
+    out.adj_indices.resize(csr.adj_indices.size());
+    parallel_for(0, row_order.size(), num_threads, [&](size_t begin, size_t end, unsigned) {
+        std::vector<std::pair<index_type, data_type>> row;
+        for (size_t i = begin; i < end; i++) {
+            index_type r = row_order[i];
+            row.clear();
+            for (offset_type k = csr.adj_indptr[r]; k < csr.adj_indptr[r + 1]; k++) {
+                index_type c = csr.adj_indices[k];
+                row.push_back({col_rank.empty() ? c : col_rank[c], csr.adj_data[k]});
+            }
+            std::sort(row.begin(), row.end(), [](auto const &a, auto const &b) { return a.first < b.first; });
+            offset_type dest = out.adj_indptr[i];
+            for (auto const &e : row) {
+                out.adj_indices[dest] = e.first;
+                out.adj_data[dest++] = e.second;
+            }
+        }
+    }, 1024);
+    return out;
+}
+
+
+// Renumber the rows and columns of a square matrix alike, P * A * P^T.
+template<typename data_type, typename index_type, typename offset_type>
+CSRMatrix<data_type, index_type, offset_type>
+permute_symmetric(CSRMatrix<data_type, index_type, offset_type> const &csr, std::vector<index_type> const &order,
+                  unsigned num_threads = 0) {
+    if (csr.num_rows != csr.num_cols) {
+        throw std::runtime_error("A symmetric permutation needs a square matrix");
+    }
+    return permute_csr(csr, order, order, num_threads);
+}
+
+
+//--------------------------------------------------
+// Reordering algorithms
+//--------------------------------------------------
+
+// The pattern of A + A^T without the diagonal, sorted and without duplicates: the undirected
+// graph of a square matrix, which RCM and the community order work on.
+template<typename index_type, typename offset_type>
+struct GraphPattern {
+    /*! \brief The index pointers of the neighbour lists */
+    std::vector<offset_type> indptr;
+    /*! \brief The neighbours of each vertex */
+    std::vector<index_type> indices;
+
+    index_type num_vertices() const { return indptr.size() - 1; }
+    offset_type degree(index_type v) const { return indptr[v + 1] - indptr[v]; }
+};
+
+
+template<typename data_type, typename index_type, typename offset_type>
+GraphPattern<index_type, offset_type>
+symmetric_pattern(CSRMatrix<data_type, index_type, offset_type> const &csr, unsigned num_threads = 0) {
+    if (csr.num_rows != csr.num_cols) {
+        throw std::runtime_error("Reordering needs a square matrix");
+    }
+    if (num_threads == 0) num_threads = default_num_threads();
+    CSCMatrix<data_type, index_type, offset_type> csc = csr2csc(csr);
+    size_t n = csr.num_rows;
+    GraphPattern<index_type, offset_type> g;
+    g.indptr.assign(n + 1, 0);
+    // the union of row v and column v, minus v; counted first, then written
+    auto merge = [&](size_t v, std::vector<index_type> &scratch) {
+        scratch.assign(csr.adj_indices.begin() + csr.adj_indptr[v], csr.adj_indices.begin() + csr.adj_indptr[v + 1]);
+        scratch.insert(scratch.end(), csc.adj_indices.begin() + csc.adj_indptr[v],
+                       csc.adj_indices.begin() + csc.adj_indptr[v + 1]);
+        std::sort(scratch.begin(), scratch.end());
+        scratch.erase(std::unique(scratch.begin(), scratch.end()), scratch.end());
+        scratch.erase(std::remove(scratch.begin(), scratch.end(), index_type(v)), scratch.end());
+    };
+    parallel_for(0, n, num_threads, [&](size_t begin, size_t end, unsigned) {
+        std::vector<index_type> scratch;
+        for (size_t v = begin; v < end; v++) {
+            merge(v, scratch);
+            g.indptr[v + 1] = scratch.size();
+        }
+    }, 1024);
+    for (size_t v = 0; v < n; v++) {
+        g.indptr[v + 1] += g.indptr[v];
+    }
+    g.indices.resize(g.indptr[n]);
+    parallel_for(0, n, num_threads, [&](size_t begin, size_t end, unsigned) {
+        std::vector<index_type> scratch;
+        for (size_t v = begin; v < end; v++) {
+            merge(v, scratch);
+            std::copy(scratch.begin(), scratch.end(), g.indices.begin() + g.indptr[v]);
+        }
+    }, 1024);
+    return g;
+}
+
+
+// Order the rows by decreasing number of non-zeros (increasing if ascending), ties in the old
+// order. As a symmetric order it puts the hubs, the most gathered entries of vector_in, together.
+template<typename data_type, typename index_type, typename offset_type>
+std::vector<index_type> degree_order(CSRMatrix<data_type, index_type, offset_type> const &csr,
+                                     bool ascending = false, unsigned num_threads = 0) {
+    std::vector<index_type> order(csr.num_rows);
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    auto degree = [&](index_type r) { return csr.adj_indptr[r + 1] - csr.adj_indptr[r]; };
+    parallel_stable_sort(order, [&](index_type a, index_type b) {
+        return ascending ? degree(a) < degree(b) : degree(a) > degree(b);
+    }, num_threads);
+    return order;
+}
+
+
+// One level of a Cuthill-McKee traversal: append to queue the unvisited neighbours of the vertices
+// queue[begin, end), the neighbours of each vertex by increasing degree (then index), and a
+// vertex listed by several of them after the first. The level is expanded in parallel: each new
+// vertex is claimed by its first parent, then every parent appends what it claimed. The result
+// is the serial Cuthill-McKee order. claim must be all max on entry, and is left so.
+template<typename index_type, typename offset_type>
+void _cuthill_mckee_level(GraphPattern<index_type, offset_type> const &g, std::vector<index_type> &queue,
+                          size_t begin, size_t end, std::vector<uint8_t> &visited,
+                          std::vector<std::atomic<uint64_t>> &claim, unsigned num_threads) {
+    parallel_for(begin, end, num_threads, [&](size_t b, size_t e, unsigned) {
+        for (size_t i = b; i < e; i++) {
+            index_type u = queue[i];
+            for (offset_type k = g.indptr[u]; k < g.indptr[u + 1]; k++) {
+                index_type v = g.indices[k];
+                if (visited[v]) continue;
+                uint64_t current = claim[v].load(std::memory_order_relaxed);
+                while (i < current && !claim[v].compare_exchange_weak(current, i, std::memory_order_relaxed)) {
+                }
+            }
+        }
+    }, 256);
+    std::vector<std::vector<index_type>> children(num_threads);
+    parallel_for(begin, end, num_threads, [&](size_t b, size_t e, unsigned t) {
+        std::vector<index_type> &out = children[t];
+        for (size_t i = b; i < e; i++) {
+            index_type u = queue[i];
+            size_t first = out.size();
+            for (offset_type k = g.indptr[u]; k < g.indptr[u + 1]; k++) {
+                index_type v = g.indices[k];
+                if (!visited[v] && claim[v].load(std::memory_order_relaxed) == i) {
+                    out.push_back(v);
+                }
+            }
+            std::sort(out.begin() + first, out.end(), [&](index_type a, index_type b) {
+                return (g.degree(a) != g.degree(b)) ? g.degree(a) < g.degree(b) : a < b;
+            });
+        }
+    }, 256);
+    for (auto const &out : children) {
+        for (index_type v : out) {
+            visited[v] = 1;
+            claim[v].store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+            queue.push_back(v);
+        }
+    }
+}
+
+
+// Breadth-first levels from start, appended to queue; returns the offsets in queue of the levels.
+template<typename index_type, typename offset_type>
+std::vector<size_t> _cuthill_mckee_levels(GraphPattern<index_type, offset_type> const &g, index_type start,
+                                          std::vector<index_type> &queue, std::vector<uint8_t> &visited,
+                                          std::vector<std::atomic<uint64_t>> &claim, unsigned num_threads) {
+    std::vector<size_t> levels = {queue.size()};
+    visited[start] = 1;
+    queue.push_back(start);
+    while (queue.size() > levels.back()) {
+        levels.push_back(queue.size());
+        _cuthill_mckee_level(g, queue, levels[levels.size() - 2], levels.back(), visited, claim, num_threads);
+    }
+    return levels;
+}
+
+
+// Reverse Cuthill-McKee order of a square matrix, on the pattern of A + A^T. Each connected
+// component starts from a pseudo-peripheral vertex (George-Liu), found from its vertex of lowest
+// degree, and the components come by increasing lowest degree. RCM narrows the band around the
+// diagonal, so the columns gathered by neighbouring rows overlap.
+template<typename data_type, typename index_type, typename offset_type>
+std::vector<index_type> rcm_order(CSRMatrix<data_type, index_type, offset_type> const &csr,
+                                  unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    GraphPattern<index_type, offset_type> g = symmetric_pattern(csr, num_threads);
+    size_t n = g.num_vertices();
+    std::vector<index_type> by_degree(n);
+    for (size_t v = 0; v < n; v++) {
+        by_degree[v] = v;
+    }
+    parallel_stable_sort(by_degree, [&](index_type a, index_type b) { return g.degree(a) < g.degree(b); },
+                         num_threads);
+    std::vector<std::atomic<uint64_t>> claim(n);
+    parallel_for(0, n, num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t v = begin; v < end; v++) {
+            claim[v].store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+        }
+    });
+    std::vector<uint8_t> visited(n, 0);
+    std::vector<uint8_t> seen(n, 0);
+    std::vector<index_type> order;
+    order.reserve(n);
+    std::vector<index_type> search;
+    for (index_type s : by_degree) {
+        if (visited[s]) continue;
+        // pseudo-peripheral vertex: restart from the lowest degree vertex of the last level while
+        // the number of levels grows
+        index_type start = s;
+        size_t depth = 0;
+        for (int round = 0; round < 8; round++) {
+            search.clear();
+            std::vector<size_t> levels = _cuthill_mckee_levels(g, start, search, seen, claim, num_threads);
+            for (index_type v : search) {
+                seen[v] = 0;
+            }
+            if (round > 0 && levels.size() <= depth) break;
+            depth = levels.size();
+            index_type next = search[levels[levels.size() - 2]];
+            for (size_t i = levels[levels.size() - 2]; i < search.size(); i++) {
+                if (g.degree(search[i]) < g.degree(next)) next = search[i];
+            }
+            if (next == start) break;
+            start = next;
+        }
+        _cuthill_mckee_levels(g, start, order, visited, claim, num_threads);
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+
+// Community order, a lighter take on Rabbit Order: communities are found by label propagation on
+// the pattern of A + A^T, then laid out one after the other, ordered by their first vertex, with
+// the old order kept inside a community. Most non-zeros then fall in diagonal blocks whose part of
+// vector_in stays in cache. The propagation is synchronous, so the order does not depend on
+// num_threads; a vertex only moves to a label more frequent than its own among its neighbours.
+template<typename data_type, typename index_type, typename offset_type>
+std::vector<index_type> community_order(CSRMatrix<data_type, index_type, offset_type> const &csr,
+                                        unsigned max_iterations = 10, unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    GraphPattern<index_type, offset_type> g = symmetric_pattern(csr, num_threads);
+    size_t n = g.num_vertices();
+    std::vector<index_type> label(n), next(n);
+    for (size_t v = 0; v < n; v++) {
+        label[v] = v;
+    }
+    std::vector<size_t> changed(num_threads);
+    for (unsigned iter = 0; iter < max_iterations; iter++) {
+        std::fill(changed.begin(), changed.end(), 0);
+        parallel_for(0, n, num_threads, [&](size_t begin, size_t end, unsigned t) {
+            std::vector<index_type> labels;
+            for (size_t v = begin; v < end; v++) {
+                labels.clear();
+                for (offset_type k = g.indptr[v]; k < g.indptr[v + 1]; k++) {
+                    labels.push_back(label[g.indices[k]]);
+                }
+                std::sort(labels.begin(), labels.end());
+                // the most frequent label, the smallest on ties, and the count of the current one
+                index_type best = label[v];
+                size_t best_count = 0, own_count = 0;
+                for (size_t i = 0; i < labels.size();) {
+                    size_t j = i;
+                    while (j < labels.size() && labels[j] == labels[i]) j++;
+                    if (labels[i] == label[v]) own_count = j - i;
+                    if (j - i > best_count) {
+                        best = labels[i];
+                        best_count = j - i;
+                    }
+                    i = j;
+                }
+                next[v] = (best_count > own_count) ? best : label[v];
+                changed[t] += next[v] != label[v];
+            }
+        }, 1024);
+        label.swap(next);
+        size_t total = 0;
+        for (size_t c : changed) total += c;
+        if (total <= n / 1000) break;
+    }
+    // the first vertex of every community is its key
+    std::vector<index_type> first(n, std::numeric_limits<index_type>::max());
+    for (size_t v = 0; v < n; v++) {
+        first[label[v]] = std::min<index_type>(first[label[v]], v);
+    }
+    std::vector<index_type> order(n);
+    for (size_t v = 0; v < n; v++) {
+        order[v] = v;
+    }
+    parallel_stable_sort(order, [&](index_type a, index_type b) { return first[label[a]] < first[label[b]]; },
+                         num_threads);
+    return order;
+}
+
+
+//--------------------------------------------------
+// Locality report
+//--------------------------------------------------
+
+// How far the non-zeros of a matrix lie from the diagonal, i.e., how far apart the SpMV gathers.
+struct MatrixLocality {
+    /*! \brief The largest |row - column| over the non-zeros */
+    uint64_t bandwidth;
+    /*! \brief The sum over the rows of the distance to their first column left of the diagonal */
+    uint64_t profile;
+    /*! \brief The mean |row - column| over the non-zeros */
+    double mean_distance;
+};
+
+
+template<typename data_type, typename index_type, typename offset_type>
+MatrixLocality matrix_locality(CSRMatrix<data_type, index_type, offset_type> const &csr, unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    std::vector<MatrixLocality> partial(num_threads, {0, 0, 0});
+    parallel_for(0, csr.num_rows, num_threads, [&](size_t begin, size_t end, unsigned t) {
+        MatrixLocality &p = partial[t];
+        for (size_t r = begin; r < end; r++) {
+            uint64_t farthest_left = 0;
+            for (offset_type k = csr.adj_indptr[r]; k < csr.adj_indptr[r + 1]; k++) {
+                uint64_t c = csr.adj_indices[k];
+                uint64_t distance = (c > r) ? c - r : r - c;
+                p.bandwidth = std::max(p.bandwidth, distance);
+                p.mean_distance += distance;
+                if (c < r) farthest_left = std::max(farthest_left, distance);
+            }
+            p.profile += farthest_left;
+        }
+    }, 1024);
+    MatrixLocality total = {0, 0, 0};
+    for (auto const &p : partial) {
+        total.bandwidth = std::max(total.bandwidth, p.bandwidth);
+        total.profile += p.profile;
+        total.mean_distance += p.mean_distance;
+    }
+    total.mean_distance /= std::max<size_t>(csr.adj_indices.size(), 1);
+    return total;
+}
+
+
+inline void print_reorder_report(std::ostream &stream, std::string const &name, MatrixLocality const &before,
+                                 MatrixLocality const &after) {
+    stream << name << ": bandwidth " << before.bandwidth << " -> " << after.bandwidth << ", profile "
+           << before.profile << " -> " << after.profile << ", mean distance " << before.mean_distance
+           << " -> " << after.mean_distance << std::endl;
+}
+
+#endif  // REORDER_HPP
@@ -0,0 +1,111 @@
+#ifndef ROW_SPLIT_HPP
+#define ROW_SPLIT_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "sparse-io.hpp"
+#include "parallel-for.hpp"
+#include "semiring.hpp"
+#include "spmv-cpu.hpp"
+
+//--------------------------------------------------
+// Heavy-row splitting
+//--------------------------------------------------
+
+// A row-based SpMV runs a row on one loop of one compute unit, so a hub row of a power-law graph
+// bounds the runtime however the rows are balanced. Here the rows longer than a threshold are cut
+// into segments of at most that many non-zeros. Every segment is a row of an ordinary csr matrix,
+// which any row-based kernel runs and any row partition spreads, and the partial result of the
+// segments of a row is reduced afterwards (merge_split_results).
+template<typename data_type>
+struct SplitCSRMatrix {
+    /*! \brief The number of rows of the original matrix */
+    uint32_t num_rows;
+    /*! \brief One row per segment, the segments of a row being consecutive */
+    CSRMatrix<data_type> segments;
+    /*! \brief The segments [row_segments[r], row_segments[r + 1]) of row r */
+    std::vector<uint32_t> row_segments;
+    /*! \brief The number of rows that were split */
+    uint32_t num_split_rows;
+
+    uint32_t num_segments() const { return segments.num_rows; }
+};
+
+
+// A threshold for spreading a matrix over num_parts compute units: a row holding more than an
+// eighth of the non-zeros of a part is split, but not below min_segment non-zeros.
+template<typename data_type>
+uint32_t default_split_threshold(CSRMatrix<data_type> const &csr, size_t num_parts, uint32_t min_segment = 1024) {
+    uint64_t nnz = csr.adj_indices.size();
+    return std::max<uint64_t>(min_segment, (nnz + 8 * num_parts - 1) / (8 * num_parts));
+}
+
+
+// Split the rows above max_segment non-zeros into segments of about the same size. The non-zeros
+// are moved, not copied, into the segment matrix: pass the matrix with std::move if it is not
+// needed afterwards. Only the index pointers are rebuilt.
+template<typename data_type>
+SplitCSRMatrix<data_type> split_heavy_rows(CSRMatrix<data_type> csr, uint32_t max_segment) {
+    max_segment = std::max<uint32_t>(max_segment, 1);
+    SplitCSRMatrix<data_type> split;
+    split.num_rows = csr.num_rows;
+    split.num_split_rows = 0;
+    split.row_segments.resize(size_t(csr.num_rows) + 1);
+    split.row_segments[0] = 0;
+    for (uint32_t r = 0; r < csr.num_rows; r++) {
+        uint32_t len = csr.adj_indptr[r + 1] - csr.adj_indptr[r];
+        uint32_t pieces = std::max<uint32_t>(1, (len + max_segment - 1) / max_segment);
+        split.num_split_rows += pieces > 1;
+        split.row_segments[r + 1] = split.row_segments[r] + pieces;
+    }
+    CSRMatrix<data_type> &segments = split.segments;
+    segments.num_rows = split.row_segments[csr.num_rows];
+    segments.num_cols = csr.num_cols;
+    segments.adj_indptr.resize(size_t(segments.num_rows) + 1);
+    for (uint32_t r = 0; r < csr.num_rows; r++) {
+        uint32_t start = csr.adj_indptr[r];
+        uint32_t len = csr.adj_indptr[r + 1] - start;
+        uint32_t pieces = split.row_segments[r + 1] - split.row_segments[r];
+        for (uint32_t s = 0; s < pieces; s++) {
+            segments.adj_indptr[split.row_segments[r] + s] = start + uint64_t(len) * s / pieces;
+        }
+    }
+    segments.adj_indptr[segments.num_rows] = csr.adj_indptr[csr.num_rows];
+    segments.adj_data = std::move(csr.adj_data);
+    segments.adj_indices = std::move(csr.adj_indices);
+    return split;
+}
+
+
+// vector_out[r] = the semiring sum of the partial results of the segments of row r. partial has
+// one entry per segment.
+template<typename data_type, typename semiring = PlusTimes<data_type>>
+void merge_split_results(SplitCSRMatrix<data_type> const &split, const data_type *partial, data_type *vector_out,
+                         unsigned num_threads = 0) {
+    if (num_threads == 0) num_threads = default_num_threads();
+    parallel_for(0, split.num_rows, num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t r = begin; r < end; r++) {
+            uint32_t s = split.row_segments[r];
+            data_type acc = partial[s];
+            for (s++; s < split.row_segments[r + 1]; s++) {
+                acc = semiring::add(acc, partial[s]);
+            }
+            vector_out[r] = acc;
+        }
+    });
+}
+
+
+// CPU reference: the segments are balanced over the threads like any rows, so a hub row is shared
+// by several threads, then merged. partial is scratch of num_segments() entries.
+template<typename data_type, typename semiring = PlusTimes<data_type>>
+void spmv_cpu_split(SplitCSRMatrix<data_type> const &split, const data_type *vector_in, data_type *partial,
+                    data_type *vector_out, unsigned num_threads = 0) {
+    spmv_cpu_parallel<data_type, semiring>(split.segments, vector_in, partial, 0, split.num_segments(), num_threads);
+    merge_split_results<data_type, semiring>(split, partial, vector_out, num_threads);
+}
+
+#endif  // ROW_SPLIT_HPP
@@ -0,0 +1,293 @@
+#ifndef SELL_HPP
+#define SELL_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "sparse-io.hpp"
+#include "parallel-for.hpp"
+#include "semiring.hpp"
+
+//--------------------------------------------------
+// SELL-C-sigma (sliced ELLPACK) format support
+//--------------------------------------------------
+
+// Rows are sorted by decreasing length within windows of sigma rows, then cut into chunks of C
+// rows. A chunk is padded to its longest row and stored column-major, so entry j of the C rows is
+// a contiguous run of C values and C column indices: one SIMD lane (or one kernel PE) per row,
+// without the end-of-row markers of irregular csr rows. Sorting within a window keeps rows of
+// similar length in a chunk, which bounds the padding while staying local to the input order.
+// C should match the vector width (8 floats for AVX2, 16 for AVX-512) or the kernel pack size.
+// Padding entries hold semiring::zero() and repeat the last column of their row (0 for empty rows).
+
+// Data structure for sell matrix.
+template<typename data_type>
+struct SELLMatrix {
+    /*! \brief The number of rows of the sparse matrix */
+    uint32_t num_rows;
+    /*! \brief The number of columns of the sparse matrix */
+    uint32_t num_cols;
+    /*! \brief The number of rows of a chunk (C) */
+    uint32_t chunk_size;
+    /*! \brief The number of rows of a sorting window (sigma) */
+    uint32_t sigma;
+    /*! \brief The original row of each sorted row, num_chunks * C entries, num_rows for padding rows */
+    std::vector<uint32_t> row_perm;
+    /*! \brief The offset of each chunk in adj_data and adj_indices, num_chunks + 1 entries */
+    std::vector<uint32_t> chunk_ptr;
+    /*! \brief The entries, column-major within each chunk */
+    std::vector<data_type> adj_data;
+    /*! \brief The column indices of the entries */
+    std::vector<uint32_t> adj_indices;
+
+    uint32_t num_chunks() const { return this->chunk_ptr.size() - 1; }
+    uint32_t chunk_width(uint32_t chunk) const {
+        return (this->chunk_ptr[chunk + 1] - this->chunk_ptr[chunk]) / this->chunk_size;
+    }
+};
+
+
+// The rows of a window [begin, end) by decreasing length, ties in input order.
+template<typename data_type>
+void sell_sort_window(CSRMatrix<data_type> const &csr, uint32_t begin, uint32_t end, uint32_t *perm) {
+    std::iota(perm, perm + (end - begin), begin);
+    auto length = [&](uint32_t r) { return csr.adj_indptr[r + 1] - csr.adj_indptr[r]; };
+    std::stable_sort(perm, perm + (end - begin), [&](uint32_t a, uint32_t b) { return length(a) > length(b); });
+}
+
+
+// Convert csr to sell on num_threads threads (0 means all cores). sigma must be a multiple of
+// chunk_size, or 1 to keep the input row order.
+template<typename data_type, typename semiring = PlusTimes<data_type>>
+SELLMatrix<data_type> csr2sell(CSRMatrix<data_type> const &csr, uint32_t chunk_size, uint32_t sigma,
+                               unsigned num_threads = 0) {
+    if (sigma != 1 && sigma % chunk_size != 0) {
+        throw std::runtime_error("SELL sigma must be 1 or a multiple of the chunk size");
+    }
+    if (num_threads == 0) num_threads = default_num_threads();
+    SELLMatrix<data_type> sell;
+    sell.num_rows = csr.num_rows;
+    sell.num_cols = csr.num_cols;
+    sell.chunk_size = chunk_size;
+    sell.sigma = sigma;
+    uint32_t num_chunks = (csr.num_rows + chunk_size - 1) / chunk_size;
+    sell.row_perm.assign((size_t)num_chunks * chunk_size, csr.num_rows);
+
+    // sort the windows, sigma = 1 keeps the identity
+    uint32_t window = std::max(sigma, chunk_size);
+    uint32_t num_windows = (csr.num_rows + window - 1) / window;
+    parallel_for(0, num_windows, num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t w = begin; w < end; w++) {
+            uint32_t first = w * window;
+            uint32_t last = std::min<uint64_t>(csr.num_rows, (uint64_t)first + window);
+            if (sigma == 1) {
+                std::iota(sell.row_perm.begin() + first, sell.row_perm.begin() + last, first);
+            } else {
+                sell_sort_window(csr, first, last, sell.row_perm.data() + first);
+            }
+        }
+    }, 16);
+
+    // chunk widths, then offsets
+    auto length = [&](uint32_t r) { return r < csr.num_rows ? csr.adj_indptr[r + 1] - csr.adj_indptr[r] : 0; };
+    std::vector<uint32_t> width(num_chunks);
+    parallel_for(0, num_chunks, num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t c = begin; c < end; c++) {
+            uint32_t w = 0;
+            for (uint32_t l = 0; l < chunk_size; l++) {
+                w = std::max(w, length(sell.row_perm[c * chunk_size + l]));
+            }
+            width[c] = w;
+        }
+    });
+    sell.chunk_ptr.resize(num_chunks + 1);
+    uint64_t total = 0;
+    sell.chunk_ptr[0] = 0;
+    for (uint32_t c = 0; c < num_chunks; c++) {
+        total += (uint64_t)width[c] * chunk_size;
+        if (total > UINT32_MAX) {
+            throw std::runtime_error("SELL entries exceed 32-bit indices");
+        }
+        sell.chunk_ptr[c + 1] = total;
+    }
+    sell.adj_data.resize(total);
+    sell.adj_indices.resize(total);
+
+    // fill the chunks column-major, padding each row with its last column
+    parallel_for(0, num_chunks, num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (size_t c = begin; c < end; c++) {
+            for (uint32_t l = 0; l < chunk_size; l++) {
+                uint32_t r = sell.row_perm[c * chunk_size + l];
+                uint32_t start = r < csr.num_rows ? csr.adj_indptr[r] : 0;
+                uint32_t len = length(r);
+                uint32_t pad_col = len ? csr.adj_indices[start + len - 1] : 0;
+                for (uint32_t j = 0; j < width[c]; j++) {
+                    size_t pos = sell.chunk_ptr[c] + (size_t)j * chunk_size + l;
+                    sell.adj_data[pos] = j < len ? csr.adj_data[start + j] : semiring::zero();
+                    sell.adj_indices[pos] = j < len ? csr.adj_indices[start + j] : pad_col;
+                }
+            }
+        }
+    }, 256);
+    return sell;
+}
+
+
+// The storage overhead of SELL-C-sigma for a csr matrix, computed from the row lengths only, so
+// that chunk sizes and sigmas can be compared without converting.
+struct SELLPaddingReport {
+    /*! \brief The chunk size (C) */
+    uint32_t chunk_size;
+    /*! \brief The sorting window (sigma) */
+    uint32_t sigma;
+    /*! \brief The number of non-zeros of the matrix */
+    uint64_t nnz;
+    /*! \brief The number of stored entries, padding included */
+    uint64_t stored;
+    /*! \brief The number of chunks */
+    uint32_t num_chunks;
+    /*! \brief The width of the widest chunk */
+    uint32_t max_chunk_width;
+
+    // padding entries per non-zero, e.g., 0.1 means 10% more values and indices than csr
+    double overhead() const { return this->nnz ? (double)(this->stored - this->nnz) / this->nnz : 0.0; }
+};
+
+
+template<typename data_type>
+SELLPaddingReport sell_padding_report(CSRMatrix<data_type> const &csr, uint32_t chunk_size, uint32_t sigma) {
+    SELLPaddingReport report = {chunk_size, sigma, csr.adj_indices.size(), 0, 0, 0};
+    uint32_t window = std::max(sigma, chunk_size);
+    std::vector<uint32_t> lengths;
+    for (uint32_t first = 0; first < csr.num_rows; first += window) {
+        uint32_t last = std::min<uint64_t>(csr.num_rows, (uint64_t)first + window);
+        lengths.resize(last - first);
+        for (uint32_t r = first; r < last; r++) {
+            lengths[r - first] = csr.adj_indptr[r + 1] - csr.adj_indptr[r];
+        }
+        if (sigma != 1) {
+            std::sort(lengths.begin(), lengths.end(), std::greater<uint32_t>());
+        }
+        for (size_t c = 0; c < lengths.size(); c += chunk_size) {
+            uint32_t width = *std::max_element(lengths.begin() + c,
+                                               lengths.begin() + std::min<size_t>(lengths.size(), c + chunk_size));
+            report.stored += (uint64_t)width * chunk_size;
+            report.max_chunk_width = std::max(report.max_chunk_width, width);
+            report.num_chunks++;
+        }
+    }
+    return report;
+}
+
+
+inline void print_sell_padding_report(std::ostream &stream, SELLPaddingReport const &report) {
+    stream << "SELL-" << report.chunk_size << "-" << report.sigma << ": " << report.num_chunks << " chunks, "
+           << report.stored << " entries for " << report.nnz << " non-zeros, padding overhead "
+           << report.overhead() * 100 << "%, widest chunk " << report.max_chunk_width << std::endl;
+}
+
+
+//--------------------------------------------------
+// CPU SELL SpMV
+//--------------------------------------------------
+
+// Chunk boundaries splitting the chunks into num_parts ranges of about the same number of entries.
+template<typename data_type>
+std::vector<uint32_t> partition_sell_chunks(SELLMatrix<data_type> const &sell, size_t num_parts) {
+    std::vector<uint32_t> bounds(num_parts + 1);
+    uint32_t num_chunks = sell.num_chunks();
+    uint64_t total = (uint64_t)sell.chunk_ptr[num_chunks] + num_chunks;
+    for (size_t p = 0; p < num_parts; p++) {
+        uint64_t target = total * p / num_parts;
+        uint32_t lo = p ? bounds[p - 1] : 0, hi = num_chunks;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if ((uint64_t)sell.chunk_ptr[mid] + mid < target) lo = mid + 1;
+            else hi = mid;
+        }
+        bounds[p] = lo;
+    }
+    bounds[num_parts] = num_chunks;
+    return bounds;
+}
+
+
+// Compute the rows of chunks [chunk_begin, chunk_end) of mat * vector_in on the calling thread.
+// Float chunks of 8 (AVX2) or 16 (AVX-512) rows take one gather and one FMA per column of the
+// chunk when built with -march=native.
+template<typename data_type, typename semiring = PlusTimes<data_type>>
+void spmv_sell_rows(SELLMatrix<data_type> const &sell, const data_type *vector_in, data_type *vector_out,
+                    uint32_t chunk_begin, uint32_t chunk_end) {
+    const uint32_t C = sell.chunk_size;
+    std::vector<data_type> res(C);
+    for (uint32_t c = chunk_begin; c < chunk_end; c++) {
+        const data_type *values = sell.adj_data.data() + sell.chunk_ptr[c];
+        const uint32_t *indices = sell.adj_indices.data() + sell.chunk_ptr[c];
+        uint32_t width = sell.chunk_width(c);
+        bool done = false;
+        if constexpr (std::is_same<data_type, float>::value && std::is_same<semiring, PlusTimes<float>>::value) {
+#if defined(__AVX512F__)
+            if (C == 16) {
+                __m512 acc = _mm512_setzero_ps();
+                for (uint32_t j = 0; j < width; j++) {
+                    __m512i idx = _mm512_loadu_si512((const void*)(indices + j * 16));
+                    acc = _mm512_fmadd_ps(_mm512_loadu_ps(values + j * 16), _mm512_i32gather_ps(idx, vector_in, 4), acc);
+                }
+                _mm512_storeu_ps(res.data(), acc);
+                done = true;
+            }
+#endif
+#if defined(__AVX2__) && defined(__FMA__)
+            if (C == 8) {
+                __m256 acc = _mm256_setzero_ps();
+                for (uint32_t j = 0; j < width; j++) {
+                    __m256i idx = _mm256_loadu_si256((const __m256i*)(indices + j * 8));
+                    acc = _mm256_fmadd_ps(_mm256_loadu_ps(values + j * 8), _mm256_i32gather_ps(vector_in, idx, 4), acc);
+                }
+                _mm256_storeu_ps(res.data(), acc);
+                done = true;
+            }
+#endif
+        }
+        if (!done) {
+            std::fill(res.begin(), res.end(), semiring::zero());
+            for (uint32_t j = 0; j < width; j++) {
+                for (uint32_t l = 0; l < C; l++) {
+                    res[l] = semiring::add(res[l], semiring::mul(values[j * C + l], vector_in[indices[j * C + l]]));
+                }
+            }
+        }
+        for (uint32_t l = 0; l < C; l++) {
+            uint32_t r = sell.row_perm[c * C + l];
+            if (r < sell.num_rows) vector_out[r] = res[l];
+        }
+    }
+}
+
+
+// Compute mat * vector_in on num_threads threads (0 means all cores), balancing the threads by entries.
+template<typename data_type, typename semiring = PlusTimes<data_type>>
+void spmv_sell_parallel(SELLMatrix<data_type> const &sell, const data_type *vector_in, data_type *vector_out,
+                        unsigned num_threads = 0) {
+    uint32_t num_chunks = sell.num_chunks();
+    if (num_chunks == 0) return;
+    if (num_threads == 0) num_threads = default_num_threads();
+    size_t work = sell.chunk_ptr[num_chunks];
+    num_threads = std::max<size_t>(1, std::min<size_t>({num_threads, num_chunks, (work + 4095) / 4096}));
+    std::vector<uint32_t> bounds = partition_sell_chunks(sell, num_threads);
+    parallel_run(num_threads, [&](unsigned t) {
+        spmv_sell_rows<data_type, semiring>(sell, vector_in, vector_out, bounds[t], bounds[t + 1]);
+    });
+}
+
+#endif  // SELL_HPP
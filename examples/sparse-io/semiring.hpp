@@ -0,0 +1,43 @@
+#ifndef SEMIRING_HPP
+#define SEMIRING_HPP
+
+#include <limits>
+
+//--------------------------------------------------
+// Semirings for SpMV
+//--------------------------------------------------
+
+// A semiring replaces the multiply-accumulate of SpMV: y[r] = add over i of mul(values[i], x[col[i]]),
+// starting from zero(). The operations are static, so every SpMV instantiation is specialized by
+// the compiler. The header only uses <limits>, so HLS kernel sources can include it too.
+
+// Arithmetic semiring, the usual SpMV (e.g., PageRank).
+template<typename data_type>
+struct PlusTimes {
+    static data_type zero() { return 0; }
+    static data_type add(data_type a, data_type b) { return a + b; }
+    static data_type mul(data_type a, data_type b) { return a * b; }
+};
+
+
+// Tropical semiring, one relaxation of every edge (e.g., SSSP with edge weights in values).
+template<typename data_type>
+struct MinPlus {
+    static data_type zero() {
+        return std::numeric_limits<data_type>::has_infinity ? std::numeric_limits<data_type>::infinity()
+                                                            : std::numeric_limits<data_type>::max();
+    }
+    static data_type add(data_type a, data_type b) { return a < b ? a : b; }
+    static data_type mul(data_type a, data_type b) { return a + b; }
+};
+
+
+// Boolean semiring, non-zero is true (e.g., one BFS level or reachability).
+template<typename data_type>
+struct OrAnd {
+    static data_type zero() { return 0; }
+    static data_type add(data_type a, data_type b) { return (a != 0 || b != 0) ? 1 : 0; }
+    static data_type mul(data_type a, data_type b) { return (a != 0 && b != 0) ? 1 : 0; }
+};
+
+#endif  // SEMIRING_HPP
@@ -1,39 +1,48 @@
 #ifndef SPARSE_IO_HPP
 #define SPARSE_IO_HPP
 
+#include <algorithm>
+#include <cassert>
 #include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 
-#include "cnpy.h"
+#include "npz-reader.hpp"
 
 //--------------------------------------------------
 // Compressed Sparse Row (CSR) format support
 //--------------------------------------------------
 
-// Data structure for csr matrix.
-template<typename data_type>
+// Data structure for csr matrix. index_type holds the dimensions and the column indices, offset_type
+// the index pointers, i.e., it bounds the number of non-zeros. Matrices above 2^32 non-zeros need
+// a 64-bit offset_type, e.g., CSRMatrix<float, uint32_t, uint64_t>; see partition_csr_rows to
+// narrow them back to 32-bit partitions for the devices.
+template<typename data_type, typename index_type = uint32_t, typename offset_type = index_type>
 struct CSRMatrix {
     /*! \brief The number of rows of the sparse matrix */
-    uint32_t num_rows;
+    index_type num_rows;
     /*! \brief The number of columns of the sparse matrix */
-    uint32_t num_cols;
+    index_type num_cols;
     /*! \brief The non-zero data of the sparse matrix */
     std::vector<data_type> adj_data;
     /*! \brief The column indices of the sparse matrix */
-    std::vector<uint32_t> adj_indices;
+    std::vector<index_type> adj_indices;
     /*! \brief The index pointers of the sparse matrix */
-    std::vector<uint32_t> adj_indptr;
+    std::vector<offset_type> adj_indptr;
 };
 
 
 // Create a csr matrix from raw input.
-template<typename data_type>
-CSRMatrix<data_type> create_csr_matrix(uint32_t num_rows,
-                                       uint32_t num_cols,
-                                       std::vector<data_type> const &adj_data,
-                                       std::vector<uint32_t> const &adj_indices,
-                                       std::vector<uint32_t> const &adj_indptr) {
-    CSRMatrix<data_type> csr_matrix;
+template<typename data_type, typename index_type = uint32_t, typename offset_type = index_type>
+CSRMatrix<data_type, index_type, offset_type> create_csr_matrix(index_type num_rows,
+                                                                index_type num_cols,
+                                                                std::vector<data_type> const &adj_data,
+                                                                std::vector<index_type> const &adj_indices,
+                                                                std::vector<offset_type> const &adj_indptr) {
+    CSRMatrix<data_type, index_type, offset_type> csr_matrix;
     csr_matrix.num_rows = num_rows;
     csr_matrix.num_cols = num_cols;
     csr_matrix.adj_data = adj_data;
@@ -43,75 +52,121 @@ CSRMatrix<data_type> create_csr_matrix(uint32_t num_rows,
 }
 
 
-// Load a csr matrix from a scipy sparse npz file. The sparse matrix should have float data type.
-CSRMatrix<float> load_csr_matrix_from_float_npz(std::string csr_float_npz_path) {
-    CSRMatrix<float> csr_matrix;
-    cnpy::npz_t npz = cnpy::npz_load(csr_float_npz_path);
-    cnpy::NpyArray npy_shape = npz["shape"];
-    uint32_t num_rows = npy_shape.data<uint32_t>()[0];
-    uint32_t num_cols = npy_shape.data<uint32_t>()[2];
-    csr_matrix.num_rows = num_rows;
-    csr_matrix.num_cols = num_cols;
-    cnpy::NpyArray npy_data = npz["data"];
-    uint32_t nnz = npy_data.shape[0];
-    cnpy::NpyArray npy_indices = npz["indices"];
-    cnpy::NpyArray npy_indptr = npz["indptr"];
-    csr_matrix.adj_data.insert(csr_matrix.adj_data.begin(), &npy_data.data<float>()[0],
-        &npy_data.data<float>()[nnz]);
-    csr_matrix.adj_indices.insert(csr_matrix.adj_indices.begin(), &npy_indices.data<uint32_t>()[0],
-        &npy_indices.data<uint32_t>()[nnz]);
-    csr_matrix.adj_indptr.insert(csr_matrix.adj_indptr.begin(), &npy_indptr.data<uint32_t>()[0],
-        &npy_indptr.data<uint32_t>()[num_rows + 1]);
+// Load a csr matrix from a scipy sparse npz file, compressed or not. The data is read as float.
+// scipy stores the indices as 32 or 64-bit integers, both are read. The default 32-bit widths
+// throw on matrices above 2^32 non-zeros; load those with a 64-bit offset_type. The arrays are
+// inflated in parallel (see npz-reader.hpp); stats, if given, gets the bytes and time of the load.
+template<typename index_type = uint32_t, typename offset_type = index_type>
+CSRMatrix<float, index_type, offset_type> load_csr_matrix_from_float_npz(std::string csr_float_npz_path,
+                                                                         NpzLoadStats *stats = nullptr) {
+    CSRMatrix<float, index_type, offset_type> csr_matrix;
+    std::vector<index_type> shape;
+    load_npz_members(csr_float_npz_path, {"shape", "data", "indices", "indptr"},
+                     [&](unsigned i, NpzMemberReader &reader) {
+        switch (i) {
+            case 0: read_npy_array(reader, "shape", shape); break;
+            case 1: read_npy_array(reader, "data", csr_matrix.adj_data); break;
+            case 2: read_npy_array(reader, "indices", csr_matrix.adj_indices); break;
+            default: read_npy_array(reader, "indptr", csr_matrix.adj_indptr); break;
+        }
+    }, stats);
+    if (shape.size() != 2 || csr_matrix.adj_indptr.size() != size_t(shape[0]) + 1
+        || csr_matrix.adj_indices.size() != csr_matrix.adj_data.size()
+        || csr_matrix.adj_indptr.back() != csr_matrix.adj_data.size()) {
+        throw std::runtime_error(csr_float_npz_path + " is not a consistent csr matrix");
+    }
+    csr_matrix.num_rows = shape[0];
+    csr_matrix.num_cols = shape[1];
     return csr_matrix;
 }
 
 
-// Convert a float csr matrix to another data type.
-// TODO: does ap_int make formatting slower than float?
-template<typename data_type>
-CSRMatrix<data_type> csr_matrix_convert_from_float(CSRMatrix<float> const &in) {
-    CSRMatrix<data_type> out;
+// Convert a float csr matrix to another data type with a plain cast (see quantize.hpp for scaled
+// and rounded reduced-precision formats).
+template<typename data_type, typename index_type = uint32_t, typename offset_type = index_type>
+CSRMatrix<data_type, index_type, offset_type>
+csr_matrix_convert_from_float(CSRMatrix<float, index_type, offset_type> const &in) {
+    CSRMatrix<data_type, index_type, offset_type> out;
     out.num_rows = in.num_rows;
     out.num_cols = in.num_cols;
-    std::copy(in.adj_data.begin(), in.adj_data.end(), std::back_inserter(out.adj_data));
+    out.adj_data.assign(in.adj_data.begin(), in.adj_data.end());
     out.adj_indices = in.adj_indices;
     out.adj_indptr = in.adj_indptr;
     return out;
 }
 
 
+// Convert a csr matrix to other index widths, e.g., to narrow a partition to 32-bit indices.
+// Throws if the matrix does not fit the new widths.
+template<typename out_index_type, typename out_offset_type = out_index_type, typename data_type,
+         typename index_type, typename offset_type>
+CSRMatrix<data_type, out_index_type, out_offset_type>
+csr_matrix_convert_indices(CSRMatrix<data_type, index_type, offset_type> const &in) {
+    if (uint64_t(in.num_rows) > std::numeric_limits<out_index_type>::max()
+        || uint64_t(in.num_cols) > std::numeric_limits<out_index_type>::max()) {
+        throw std::runtime_error("Matrix of " + std::to_string(in.num_rows) + " x " + std::to_string(in.num_cols)
+                                 + " exceeds " + std::to_string(8 * sizeof(out_index_type)) + "-bit indices");
+    }
+    if (uint64_t(in.adj_indices.size()) > std::numeric_limits<out_offset_type>::max()) {
+        throw std::runtime_error("Matrix of " + std::to_string(in.adj_indices.size()) + " non-zeros exceeds "
+                                 + std::to_string(8 * sizeof(out_offset_type)) + "-bit offsets");
+    }
+    CSRMatrix<data_type, out_index_type, out_offset_type> out;
+    out.num_rows = in.num_rows;
+    out.num_cols = in.num_cols;
+    out.adj_data = in.adj_data;
+    out.adj_indices.assign(in.adj_indices.begin(), in.adj_indices.end());
+    out.adj_indptr.assign(in.adj_indptr.begin(), in.adj_indptr.end());
+    return out;
+}
+
+
+// Normalize each non-zero by the number of non-zeros in its column. With row i listing the
+// in-neighbours of vertex i, this divides every edge by the out-degree of its source vertex.
+template<typename data_type, typename index_type, typename offset_type>
+void normalize_csr_matrix_by_outdegree(CSRMatrix<data_type, index_type, offset_type> &csr_matrix) {
+    std::vector<offset_type> nnz_each_col(csr_matrix.num_cols, 0);
+    for (auto col_idx : csr_matrix.adj_indices) {
+        nnz_each_col[col_idx]++;
+    }
+    for (size_t i = 0; i < csr_matrix.adj_indices.size(); i++) {
+        csr_matrix.adj_data[i] = 1.0 / nnz_each_col[csr_matrix.adj_indices[i]];
+    }
+}
+
+
 //--------------------------------------------------
 // Compressed Sparse Colunm (CSC) format support
 //--------------------------------------------------
 
-// Data structure for csc matrix.
-template<typename data_type>
+// Data structure for csc matrix, with the index widths of CSRMatrix.
+template<typename data_type, typename index_type = uint32_t, typename offset_type = index_type>
 struct CSCMatrix {
     /*! \brief The number of rows of the sparse matrix */
-    uint32_t num_rows;
+    index_type num_rows;
     /*! \brief The number of columns of the sparse matrix */
-    uint32_t num_cols;
+    index_type num_cols;
     /*! \brief The non-zero data of the sparse matrix */
     std::vector<data_type> adj_data;
     /*! \brief The row indices of the sparse matrix */
-    std::vector<uint32_t> adj_indices;
+    std::vector<index_type> adj_indices;
     /*! \brief The index pointers of the sparse matrix */
-    std::vector<uint32_t> adj_indptr;
+    std::vector<offset_type> adj_indptr;
 };
 
 
 // Convert csr to csc.
-template<typename data_type>
-CSCMatrix<data_type> csr2csc(CSRMatrix<data_type> const &csr_matrix) {
-    CSCMatrix<data_type> csc_matrix;
+template<typename data_type, typename index_type, typename offset_type>
+CSCMatrix<data_type, index_type, offset_type> csr2csc(CSRMatrix<data_type, index_type, offset_type> const &csr_matrix) {
+    CSCMatrix<data_type, index_type, offset_type> csc_matrix;
     csc_matrix.num_rows = csr_matrix.num_rows;
     csc_matrix.num_cols = csr_matrix.num_cols;
     csc_matrix.adj_data = std::vector<data_type>(csr_matrix.adj_data.size());
-    csc_matrix.adj_indices = std::vector<uint32_t>(csr_matrix.adj_indices.size());
-    csc_matrix.adj_indptr = std::vector<uint32_t>(csc_matrix.num_cols + 1);
+    csc_matrix.adj_indices = std::vector<index_type>(csr_matrix.adj_indices.size());
+    csc_matrix.adj_indptr = std::vector<offset_type>(size_t(csc_matrix.num_cols) + 1);
     // Convert adj_indptr
-    uint32_t nnz = csr_matrix.adj_indptr[csr_matrix.num_rows];
-    std::vector<uint32_t> nnz_each_col(csc_matrix.num_cols);
+    offset_type nnz = csr_matrix.adj_indptr[csr_matrix.num_rows];
+    std::vector<offset_type> nnz_each_col(csc_matrix.num_cols);
     std::fill(nnz_each_col.begin(), nnz_each_col.end(), 0);
     for (size_t n = 0; n < nnz; n++) {
         nnz_each_col[csr_matrix.adj_indices[n]]++;
@@ -122,12 +177,12 @@ CSCMatrix<data_type> csr2csc(CSRMatrix<data_type> const &csr_matrix) {
     }
     assert(csc_matrix.adj_indptr[csc_matrix.num_cols] == nnz);
     // Convert adj_data and adj_indices
-    std::vector<uint32_t> nnz_consumed_each_col(csc_matrix.num_cols);
+    std::vector<offset_type> nnz_consumed_each_col(csc_matrix.num_cols);
     std::fill(nnz_consumed_each_col.begin(), nnz_consumed_each_col.end(), 0);
     for (size_t row_idx = 0; row_idx < csr_matrix.num_rows; row_idx++){
         for (size_t i = csr_matrix.adj_indptr[row_idx]; i < csr_matrix.adj_indptr[row_idx + 1]; i++){
-            uint32_t col_idx = csr_matrix.adj_indices[i];
-            uint32_t dest = csc_matrix.adj_indptr[col_idx] + nnz_consumed_each_col[col_idx];
+            index_type col_idx = csr_matrix.adj_indices[i];
+            offset_type dest = csc_matrix.adj_indptr[col_idx] + nnz_consumed_each_col[col_idx];
             csc_matrix.adj_indices[dest] = row_idx;
             csc_matrix.adj_data[dest] = csr_matrix.adj_data[i];
             nnz_consumed_each_col[col_idx]++;
@@ -141,15 +196,141 @@ CSCMatrix<data_type> csr2csc(CSRMatrix<data_type> const &csr_matrix) {
 
 
 // Convert a float csc matrix to another data type.
-template<typename data_type>
-CSCMatrix<data_type> csc_matrix_convert_from_float(CSCMatrix<float> const &in) {
-    CSCMatrix<data_type> out;
+template<typename data_type, typename index_type = uint32_t, typename offset_type = index_type>
+CSCMatrix<data_type, index_type, offset_type>
+csc_matrix_convert_from_float(CSCMatrix<float, index_type, offset_type> const &in) {
+    CSCMatrix<data_type, index_type, offset_type> out;
     out.num_rows = in.num_rows;
     out.num_cols = in.num_cols;
-    std::copy(in.adj_data.begin(), in.adj_data.end(), std::back_inserter(out.adj_data));
+    out.adj_data.assign(in.adj_data.begin(), in.adj_data.end());
     out.adj_indices = in.adj_indices;
     out.adj_indptr = in.adj_indptr;
     return out;
 }
 
+
+//--------------------------------------------------
+// Symmetric CSR (upper triangle) format support
+//--------------------------------------------------
+
+// Data structure for a symmetric matrix, e.g., an undirected graph. Only the entries (i, j) with
+// j >= i are stored, (j, i) is implied. This halves the memory and the uploads of the matrix.
+template<typename data_type>
+struct SymmetricCSRMatrix {
+    /*! \brief The upper triangle, diagonal included, of the square matrix */
+    CSRMatrix<data_type> upper;
+};
+
+
+// Check that a csr matrix is square and equal to its transpose, values included.
+template<typename data_type>
+bool is_symmetric(CSRMatrix<data_type> const &csr_matrix) {
+    if (csr_matrix.num_rows != csr_matrix.num_cols) {
+        return false;
+    }
+    // row r of the transpose is column r, listed in increasing row order by csr2csc
+    CSCMatrix<data_type> csc_matrix = csr2csc(csr_matrix);
+    std::vector<std::pair<uint32_t, data_type>> row;
+    for (uint32_t r = 0; r < csr_matrix.num_rows; r++) {
+        uint32_t start = csr_matrix.adj_indptr[r];
+        uint32_t end = csr_matrix.adj_indptr[r + 1];
+        if (end - start != csc_matrix.adj_indptr[r + 1] - csc_matrix.adj_indptr[r]) {
+            return false;
+        }
+        row.clear();
+        for (uint32_t i = start; i < end; i++) {
+            row.push_back({csr_matrix.adj_indices[i], csr_matrix.adj_data[i]});
+        }
+        std::sort(row.begin(), row.end(), [](auto const &a, auto const &b) { return a.first < b.first; });
+        for (uint32_t i = 0; i < end - start; i++) {
+            uint32_t k = csc_matrix.adj_indptr[r] + i;
+            if (row[i].first != csc_matrix.adj_indices[k] || row[i].second != csc_matrix.adj_data[k]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+// Keep the upper triangle of a square csr matrix. The lower triangle is dropped without a check,
+// use is_symmetric first if the matrix may not be symmetric.
+template<typename data_type>
+SymmetricCSRMatrix<data_type> csr_to_symmetric(CSRMatrix<data_type> const &csr_matrix) {
+    assert(csr_matrix.num_rows == csr_matrix.num_cols);
+    SymmetricCSRMatrix<data_type> sym;
+    CSRMatrix<data_type> &upper = sym.upper;
+    upper.num_rows = csr_matrix.num_rows;
+    upper.num_cols = csr_matrix.num_cols;
+    upper.adj_indptr.reserve(csr_matrix.num_rows + 1);
+    upper.adj_indptr.push_back(0);
+    for (uint32_t r = 0; r < csr_matrix.num_rows; r++) {
+        for (uint32_t i = csr_matrix.adj_indptr[r]; i < csr_matrix.adj_indptr[r + 1]; i++) {
+            if (csr_matrix.adj_indices[i] >= r) {
+                upper.adj_indices.push_back(csr_matrix.adj_indices[i]);
+                upper.adj_data.push_back(csr_matrix.adj_data[i]);
+            }
+        }
+        upper.adj_indptr.push_back(upper.adj_indices.size());
+    }
+    return sym;
+}
+
+
+// Expand a symmetric matrix to a full csr matrix, e.g., for a kernel that only reads rows. Row r
+// lists the mirrored entries (columns < r) first, so sorted upper rows give sorted full rows.
+template<typename data_type>
+CSRMatrix<data_type> symmetric_to_csr(SymmetricCSRMatrix<data_type> const &sym) {
+    CSRMatrix<data_type> const &upper = sym.upper;
+    uint32_t n = upper.num_rows;
+    CSRMatrix<data_type> csr_matrix;
+    csr_matrix.num_rows = n;
+    csr_matrix.num_cols = n;
+    std::vector<uint32_t> nnz_each_row(n, 0);
+    for (uint32_t r = 0; r < n; r++) {
+        nnz_each_row[r] += upper.adj_indptr[r + 1] - upper.adj_indptr[r];
+        for (uint32_t i = upper.adj_indptr[r]; i < upper.adj_indptr[r + 1]; i++) {
+            if (upper.adj_indices[i] != r) {
+                nnz_each_row[upper.adj_indices[i]]++;
+            }
+        }
+    }
+    csr_matrix.adj_indptr.resize(n + 1);
+    csr_matrix.adj_indptr[0] = 0;
+    for (uint32_t r = 0; r < n; r++) {
+        csr_matrix.adj_indptr[r + 1] = csr_matrix.adj_indptr[r] + nnz_each_row[r];
+    }
+    csr_matrix.adj_data.resize(csr_matrix.adj_indptr[n]);
+    csr_matrix.adj_indices.resize(csr_matrix.adj_indptr[n]);
+    // next free slot of every row; the mirrored entries of row c come from rows r < c, in order
+    std::vector<uint32_t> next(csr_matrix.adj_indptr.begin(), csr_matrix.adj_indptr.end() - 1);
+    for (uint32_t r = 0; r < n; r++) {
+        for (uint32_t i = upper.adj_indptr[r]; i < upper.adj_indptr[r + 1]; i++) {
+            uint32_t c = upper.adj_indices[i];
+            if (c != r) {
+                csr_matrix.adj_indices[next[c]] = r;
+                csr_matrix.adj_data[next[c]++] = upper.adj_data[i];
+            }
+            csr_matrix.adj_indices[next[r]] = c;
+            csr_matrix.adj_data[next[r]++] = upper.adj_data[i];
+        }
+    }
+    return csr_matrix;
+}
+
+
+// Load a float matrix from a scipy sparse npz file and detect whether it is symmetric. A symmetric
+// matrix is returned as its upper triangle in sym (csr is left empty), any other matrix in csr.
+// Returns whether the matrix is symmetric.
+inline bool load_float_npz_detect_symmetry(std::string csr_float_npz_path, CSRMatrix<float> &csr,
+                                           SymmetricCSRMatrix<float> &sym) {
+    CSRMatrix<float> loaded = load_csr_matrix_from_float_npz(csr_float_npz_path);
+    if (!is_symmetric(loaded)) {
+        csr = std::move(loaded);
+        return false;
+    }
+    sym = csr_to_symmetric(loaded);
+    return true;
+}
+
 #endif  // SPARSE_IO_HPP
@@ -1,2 +1,8 @@
 SPARSE_IO_CXXFLAGS = -I$(EXAMPLES_DIR)/sparse-io
-SPARSE_IO_LDFLAGS = -L$(EXAMPLES_DIR)/sparse-io -lcnpy
+# the CPU paths use AVX2 (gathers, FMA, F16C), there is no runtime dispatch. The default runs on
+# any AVX2 host. SPARSE_IO_ARCH=-march=native also enables AVX-512 on a host that has it, but the
+# binary may then not run on other hosts.
+SPARSE_IO_ARCH ?= -mavx2 -mfma -mf16c
+SPARSE_IO_CXXFLAGS += $(SPARSE_IO_ARCH) -pthread
+# the npz reader inflates with zlib
+SPARSE_IO_LDFLAGS = -lz
@@ -0,0 +1,127 @@
+#ifndef SPMM_CPU_HPP
+#define SPMM_CPU_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "sparse-io.hpp"
+#include "parallel-for.hpp"
+#include "semiring.hpp"
+#include "spmv-cpu.hpp"
+
+//--------------------------------------------------
+// Batched SpMV (SpMM) with interleaved vectors
+//--------------------------------------------------
+
+// K vectors are stored vector-major: entry c of vector k is at [c * K + k]. A non-zero then
+// updates K contiguous outputs from K contiguous inputs, and one pass over the matrix produces K
+// results.
+
+// Interleave vectors[first, first + k) into out (length * k entries).
+template<typename vector_type, typename data_type>
+void interleave_vectors(std::vector<vector_type> const &vectors, size_t first, uint32_t k,
+                        size_t length, data_type *out) {
+    for (uint32_t v = 0; v < k; v++) {
+        const auto &vec = vectors[first + v];
+        for (size_t c = 0; c < length; c++) {
+            out[c * k + v] = vec[c];
+        }
+    }
+}
+
+
+// Split k interleaved vectors (length * k entries) back into vectors[first, first + k).
+template<typename vector_type, typename data_type>
+void deinterleave_vectors(const data_type *in, uint32_t k, size_t length,
+                          std::vector<vector_type> &vectors, size_t first) {
+    for (uint32_t v = 0; v < k; v++) {
+        auto &vec = vectors[first + v];
+        for (size_t c = 0; c < length; c++) {
+            vec[c] = in[c * k + v];
+        }
+    }
+}
+
+
+// Pick the batch size: as many vectors as fit in max_bytes per interleaved buffer, at most
+// max_batch, then spread evenly over the batches so the last one is not mostly empty.
+inline uint32_t pick_batch_size(size_t num_vectors, uint32_t num_rows, uint32_t num_cols,
+                                size_t elem_size, size_t max_bytes, uint32_t max_batch) {
+    size_t longest = std::max<size_t>(1, std::max(num_rows, num_cols)) * elem_size;
+    size_t k = std::min<size_t>({max_batch, max_bytes / longest, std::max<size_t>(1, num_vectors)});
+    if (k == 0) return 0;
+    size_t batches = (num_vectors + k - 1) / k;
+    return (uint32_t)((num_vectors + batches - 1) / std::max<size_t>(1, batches));
+}
+
+
+// Accumulate one non-zero into k interleaved outputs: out[v] = add(out[v], mul(value, in[v])).
+template<typename data_type, typename semiring = PlusTimes<data_type>>
+inline void spmm_axpy(data_type value, const data_type *in, data_type *out, uint32_t k) {
+    for (uint32_t v = 0; v < k; v++) {
+        out[v] = semiring::add(out[v], semiring::mul(value, in[v]));
+    }
+}
+
+
+template<>
+inline void spmm_axpy<float, PlusTimes<float>>(float value, const float *in, float *out, uint32_t k) {
+    uint32_t v = 0;
+#if defined(__AVX512F__)
+    __m512 a16 = _mm512_set1_ps(value);
+    for (; v + 16 <= k; v += 16) {
+        _mm512_storeu_ps(out + v, _mm512_fmadd_ps(a16, _mm512_loadu_ps(in + v), _mm512_loadu_ps(out + v)));
+    }
+#endif
+#if defined(__AVX2__)
+    __m256 a8 = _mm256_set1_ps(value);
+    for (; v + 8 <= k; v += 8) {
+#if defined(__FMA__)
+        _mm256_storeu_ps(out + v, _mm256_fmadd_ps(a8, _mm256_loadu_ps(in + v), _mm256_loadu_ps(out + v)));
+#else
+        _mm256_storeu_ps(out + v, _mm256_add_ps(_mm256_loadu_ps(out + v), _mm256_mul_ps(a8, _mm256_loadu_ps(in + v))));
+#endif
+    }
+#endif
+    for (; v < k; v++) {
+        out[v] += value * in[v];
+    }
+}
+
+
+// Compute rows [row_begin, row_end) of mat * X for k interleaved vectors on the calling thread.
+template<typename data_type, typename semiring = PlusTimes<data_type>>
+void spmm_cpu_rows(CSRMatrix<data_type> const &mat, const data_type *vectors_in, data_type *vectors_out,
+                   uint32_t k, uint32_t row_begin, uint32_t row_end) {
+    for (uint32_t row_idx = row_begin; row_idx < row_end; row_idx++) {
+        data_type *out = vectors_out + (size_t)row_idx * k;
+        std::fill(out, out + k, semiring::zero());
+        for (uint32_t i = mat.adj_indptr[row_idx]; i < mat.adj_indptr[row_idx + 1]; i++) {
+            spmm_axpy<data_type, semiring>(mat.adj_data[i], vectors_in + (size_t)mat.adj_indices[i] * k,
+                                           out, k);
+        }
+    }
+}
+
+
+// Compute mat * X for k interleaved vectors on num_threads threads (0 means all cores), balancing
+// the threads by non-zeros.
+template<typename data_type, typename semiring = PlusTimes<data_type>>
+void spmm_cpu_parallel(CSRMatrix<data_type> const &mat, const data_type *vectors_in,
+                       data_type *vectors_out, uint32_t k, unsigned num_threads = 0) {
+    if (mat.num_rows == 0 || k == 0) return;
+    if (num_threads == 0) num_threads = default_num_threads();
+    size_t work = (size_t)mat.adj_indptr[mat.num_rows] * k;
+    num_threads = std::max<size_t>(1, std::min<size_t>({num_threads, mat.num_rows, (work + 4095) / 4096}));
+    std::vector<uint32_t> bounds = partition_rows_by_nnz(mat, num_threads);
+    parallel_run(num_threads, [&](unsigned t) {
+        spmm_cpu_rows<data_type, semiring>(mat, vectors_in, vectors_out, k, bounds[t], bounds[t + 1]);
+    });
+}
+
+#endif  // SPMM_CPU_HPP
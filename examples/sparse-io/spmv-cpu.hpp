@@ -0,0 +1,274 @@
+#ifndef SPMV_CPU_HPP
+#define SPMV_CPU_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "sparse-io.hpp"
+#include "parallel-for.hpp"
+#include "semiring.hpp"
+
+//--------------------------------------------------
+// Multithreaded CPU SpMV
+//--------------------------------------------------
+
+// Split the rows [row_begin, row_end) of a csr matrix into num_parts ranges of about the same
+// cost, where the cost of a row is its number of non-zeros plus one. Returns num_parts + 1 row
+// boundaries. row_end = 0 means all rows.
+template<typename data_type, typename index_type, typename offset_type>
+std::vector<index_type> partition_rows_by_nnz(CSRMatrix<data_type, index_type, offset_type> const &mat,
+                                              size_t num_parts, uint64_t row_begin = 0, uint64_t row_end = 0) {
+    if (row_end == 0) row_end = mat.num_rows;
+    std::vector<index_type> bounds(num_parts + 1);
+    auto cost = [&](index_type row) { return (uint64_t)mat.adj_indptr[row] + row; };
+    uint64_t first = cost(row_begin);
+    uint64_t total = cost(row_end) - first;
+    bounds[0] = row_begin;
+    for (size_t p = 1; p < num_parts; p++) {
+        uint64_t target = first + total * p / num_parts;
+        // first row whose prefix cost reaches the target
+        index_type lo = bounds[p - 1], hi = row_end;
+        while (lo < hi) {
+            index_type mid = lo + (hi - lo) / 2;
+            if (cost(mid) < target) lo = mid + 1;
+            else hi = mid;
+        }
+        bounds[p] = lo;
+    }
+    bounds[num_parts] = row_end;
+    return bounds;
+}
+
+
+// Dot product of one sparse row with a dense vector over a semiring (see semiring.hpp).
+template<typename data_type, typename semiring = PlusTimes<data_type>, typename index_type = uint32_t>
+inline data_type spmv_row(const data_type *values, const index_type *indices, size_t len,
+                          const data_type *vector) {
+    data_type res = semiring::zero();
+    for (size_t i = 0; i < len; i++) {
+        res = semiring::add(res, semiring::mul(values[i], vector[indices[i]]));
+    }
+    return res;
+}
+
+
+// Float rows use gathers when built with AVX2/AVX-512 (e.g., -march=native).
+// Column indices are gathered as signed 32-bit, so num_cols must be below 2^31.
+template<>
+inline float spmv_row<float, PlusTimes<float>>(const float *values, const uint32_t *indices,
+                                               size_t len, const float *vector) {
+    size_t i = 0;
+    float res = 0;
+#if defined(__AVX512F__)
+    __m512 acc = _mm512_setzero_ps();
+    for (; i + 16 <= len; i += 16) {
+        __m512i idx = _mm512_loadu_si512((const void*)(indices + i));
+        __m512 x = _mm512_i32gather_ps(idx, vector, 4);
+        acc = _mm512_fmadd_ps(_mm512_loadu_ps(values + i), x, acc);
+    }
+    res = _mm512_reduce_add_ps(acc);
+#elif defined(__AVX2__)
+    __m256 acc = _mm256_setzero_ps();
+    for (; i + 8 <= len; i += 8) {
+        __m256i idx = _mm256_loadu_si256((const __m256i*)(indices + i));
+        __m256 x = _mm256_i32gather_ps(vector, idx, 4);
+#if defined(__FMA__)
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(values + i), x, acc);
+#else
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(values + i), x));
+#endif
+    }
+    __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sum4 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+    sum4 = _mm_add_ss(sum4, _mm_shuffle_ps(sum4, sum4, 1));
+    res = _mm_cvtss_f32(sum4);
+#endif
+    for (; i < len; i++) {
+        res += values[i] * vector[indices[i]];
+    }
+    return res;
+}
+
+
+template<>
+inline float spmv_row<float, MinPlus<float>>(const float *values, const uint32_t *indices,
+                                             size_t len, const float *vector) {
+    size_t i = 0;
+    float res = MinPlus<float>::zero();
+#if defined(__AVX512F__)
+    __m512 acc = _mm512_set1_ps(res);
+    for (; i + 16 <= len; i += 16) {
+        __m512i idx = _mm512_loadu_si512((const void*)(indices + i));
+        __m512 x = _mm512_i32gather_ps(idx, vector, 4);
+        acc = _mm512_min_ps(acc, _mm512_add_ps(_mm512_loadu_ps(values + i), x));
+    }
+    res = _mm512_reduce_min_ps(acc);
+#elif defined(__AVX2__)
+    __m256 acc = _mm256_set1_ps(res);
+    for (; i + 8 <= len; i += 8) {
+        __m256i idx = _mm256_loadu_si256((const __m256i*)(indices + i));
+        __m256 x = _mm256_i32gather_ps(vector, idx, 4);
+        acc = _mm256_min_ps(acc, _mm256_add_ps(_mm256_loadu_ps(values + i), x));
+    }
+    __m128 min4 = _mm_min_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    min4 = _mm_min_ps(min4, _mm_movehl_ps(min4, min4));
+    min4 = _mm_min_ss(min4, _mm_shuffle_ps(min4, min4, 1));
+    res = _mm_cvtss_f32(min4);
+#endif
+    for (; i < len; i++) {
+        res = MinPlus<float>::add(res, values[i] + vector[indices[i]]);
+    }
+    return res;
+}
+
+
+// A boolean row is true as soon as one term is, so stop there.
+template<>
+inline float spmv_row<float, OrAnd<float>>(const float *values, const uint32_t *indices,
+                                           size_t len, const float *vector) {
+    for (size_t i = 0; i < len; i++) {
+        if (values[i] != 0 && vector[indices[i]] != 0) return 1;
+    }
+    return 0;
+}
+
+
+// Compute vector_out[r] = (mat * vector_in)[r] for rows in [row_begin, row_end) on the calling thread.
+template<typename data_type, typename semiring = PlusTimes<data_type>, typename index_type = uint32_t,
+         typename offset_type = index_type>
+void spmv_cpu_rows(CSRMatrix<data_type, index_type, offset_type> const &mat, const data_type *vector_in,
+                   data_type *vector_out, uint64_t row_begin, uint64_t row_end) {
+    const data_type *values = mat.adj_data.data();
+    const index_type *indices = mat.adj_indices.data();
+    const offset_type *indptr = mat.adj_indptr.data();
+    for (uint64_t row_idx = row_begin; row_idx < row_end; row_idx++) {
+        offset_type start = indptr[row_idx];
+        vector_out[row_idx] = spmv_row<data_type, semiring>(values + start, indices + start,
+                                                            indptr[row_idx + 1] - start, vector_in);
+    }
+}
+
+
+// Compute rows [row_begin, row_end) of mat * vector_in on num_threads threads (0 means all cores),
+// balancing the threads by non-zeros.
+template<typename data_type, typename semiring = PlusTimes<data_type>, typename index_type = uint32_t,
+         typename offset_type = index_type>
+void spmv_cpu_parallel(CSRMatrix<data_type, index_type, offset_type> const &mat, const data_type *vector_in,
+                       data_type *vector_out, uint64_t row_begin, uint64_t row_end,
+                       unsigned num_threads = 0) {
+    if (row_begin >= row_end) return;
+    if (num_threads == 0) num_threads = default_num_threads();
+    size_t work = (size_t)mat.adj_indptr[row_end] - mat.adj_indptr[row_begin];
+    num_threads = std::max<size_t>(1, std::min<size_t>({num_threads, row_end - row_begin, (work + 4095) / 4096}));
+    std::vector<index_type> bounds = partition_rows_by_nnz(mat, num_threads, row_begin, row_end);
+    parallel_run(num_threads, [&](unsigned t) {
+        spmv_cpu_rows<data_type, semiring>(mat, vector_in, vector_out, bounds[t], bounds[t + 1]);
+    });
+}
+
+
+// Compute vector_out = A * vector_in for a symmetric A stored as its upper triangle, on num_threads
+// threads (0 means all cores). A stored entry (r, c) is used twice: in the dot product of row r and,
+// if c > r, scattered into row c. Each thread owns a range of rows and scatters into a private
+// buffer covering only the rows its entries reach, from its first row to its largest column, and
+// the reduction only visits these ranges. A banded or reordered matrix then needs about one
+// bandwidth of scratch per thread instead of num_rows.
+template<typename data_type, typename semiring = PlusTimes<data_type>>
+void spmv_cpu_symmetric(SymmetricCSRMatrix<data_type> const &sym, const data_type *vector_in,
+                        data_type *vector_out, unsigned num_threads = 0) {
+    CSRMatrix<data_type> const &upper = sym.upper;
+    uint32_t n = upper.num_rows;
+    if (n == 0) return;
+    if (num_threads == 0) num_threads = default_num_threads();
+    size_t work = upper.adj_indptr[n];
+    num_threads = std::max<size_t>(1, std::min<size_t>({num_threads, n, (work + 4095) / 4096}));
+    std::vector<uint32_t> bounds = partition_rows_by_nnz(upper, num_threads);
+    std::vector<std::vector<data_type>> scattered(num_threads);
+    std::vector<uint32_t> reach(num_threads); // one past the last row a thread scatters into
+    const data_type *values = upper.adj_data.data();
+    const uint32_t *indices = upper.adj_indices.data();
+    const uint32_t *indptr = upper.adj_indptr.data();
+    parallel_run(num_threads, [&](unsigned t) {
+        uint32_t first = bounds[t];
+        uint32_t last_col = first;
+        for (uint32_t i = indptr[first]; i < indptr[bounds[t + 1]]; i++) {
+            last_col = std::max(last_col, indices[i]);
+        }
+        reach[t] = std::min(n, last_col + 1);
+        std::vector<data_type> &acc = scattered[t];
+        acc.assign(reach[t] - first, semiring::zero());
+        for (uint32_t r = first; r < bounds[t + 1]; r++) {
+            uint32_t start = indptr[r];
+            uint32_t len = indptr[r + 1] - start;
+            vector_out[r] = spmv_row<data_type, semiring>(values + start, indices + start, len, vector_in);
+            data_type x = vector_in[r];
+            for (uint32_t i = start; i < start + len; i++) {
+                uint32_t c = indices[i];
+                if (c != r) acc[c - first] = semiring::add(acc[c - first], semiring::mul(values[i], x));
+            }
+        }
+    });
+    // row r collects the scatter of every thread whose range [first row, reach) holds r
+    parallel_for(0, n, num_threads, [&](size_t begin, size_t end, unsigned) {
+        for (unsigned t = 0; t < num_threads; t++) {
+            for (size_t r = std::max<size_t>(begin, bounds[t]); r < std::min<size_t>(end, reach[t]); r++) {
+                vector_out[r] = semiring::add(vector_out[r], scattered[t][r - bounds[t]]);
+            }
+        }
+    });
+}
+
+
+// CPU SpMV engine. The row partition is computed once per matrix, so repeated products (e.g., power
+// iterations) only pay for the threads. The engine keeps a reference to the matrix. The semiring
+// is a template parameter, e.g., CPUSpMVEngine<float, MinPlus<float>> for SSSP relaxations, and so
+// are the index widths of the matrix.
+template<typename data_type, typename semiring = PlusTimes<data_type>, typename index_type = uint32_t,
+         typename offset_type = index_type>
+class CPUSpMVEngine {
+public:
+    CPUSpMVEngine(CSRMatrix<data_type, index_type, offset_type> const &mat, unsigned num_threads = 0)
+        : mat_(mat), num_threads_(num_threads == 0 ? default_num_threads() : num_threads) {
+        // fewer threads than rows, and at least ~4K non-zeros per thread to amortize the spawn
+        size_t max_threads = std::max<size_t>(1, std::min<size_t>(
+            mat.num_rows, ((size_t)mat.adj_indptr[mat.num_rows] + 4095) / 4096));
+        num_threads_ = std::min<size_t>(num_threads_, max_threads);
+        bounds_ = partition_rows_by_nnz(mat, num_threads_);
+    }
+
+    // vector_out = mat * vector_in. vector_in has num_cols entries and vector_out num_rows entries.
+    void spmv(const data_type *vector_in, data_type *vector_out) const {
+        parallel_run(num_threads_, [&](unsigned t) {
+            spmv_cpu_rows<data_type, semiring>(mat_, vector_in, vector_out, bounds_[t], bounds_[t + 1]);
+        });
+    }
+
+    // Apply the (square) matrix `iterations` times starting from vector, ping-ponging between
+    // vector and scratch without allocating. Returns whichever of the two holds the result.
+    data_type *iterate(data_type *vector, data_type *scratch, size_t iterations) const {
+        assert(mat_.num_rows == mat_.num_cols);
+        for (size_t i = 0; i < iterations; i++) {
+            spmv(vector, scratch);
+            std::swap(vector, scratch);
+        }
+        return vector;
+    }
+
+    unsigned num_threads() const { return num_threads_; }
+
+    // Row boundaries of each thread, num_threads() + 1 entries.
+    std::vector<index_type> const &row_partition() const { return bounds_; }
+
+private:
+    CSRMatrix<data_type, index_type, offset_type> const &mat_;
+    unsigned num_threads_;
+    std::vector<index_type> bounds_;
+};
+
+#endif  // SPMV_CPU_HPP
@@ -0,0 +1,176 @@
+#ifndef VALIDATE_HPP
+#define VALIDATE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "parallel-for.hpp"
+
+//--------------------------------------------------
+// Result validation
+//--------------------------------------------------
+
+// Error statistics of a result against its reference.
+struct ValidationReport {
+    /*! \brief Whether the two inputs have the same length (nothing else is checked if not) */
+    bool size_match = true;
+    /*! \brief The number of compared elements */
+    size_t count = 0;
+    /*! \brief The number of elements outside the tolerance, NaNs included */
+    size_t mismatches = 0;
+    /*! \brief The largest |actual - expected| */
+    double max_abs_error = 0;
+    /*! \brief The largest |actual - expected| / |expected| */
+    double max_rel_error = 0;
+    /*! \brief The largest distance in units in the last place, NaNs excluded, exact below 2^31 */
+    uint64_t max_ulp_distance = 0;
+    /*! \brief The indices of the first mismatches, in increasing order */
+    std::vector<size_t> first_mismatches;
+
+    bool passed() const { return size_match && mismatches == 0; }
+};
+
+
+// Map the bits of a float to an integer that grows with the float value.
+inline int32_t ordered_float_bits(float f) {
+    int32_t i;
+    std::memcpy(&i, &f, sizeof(i));
+    return i ^ ((i >> 31) & 0x7fffffff);
+}
+
+
+// Compare [begin, end) into report, recording at most max_reported mismatch indices.
+inline void validate_range(const float *actual, const float *expected, size_t begin, size_t end,
+                           float abs_tol, float rel_tol, size_t max_reported,
+                           ValidationReport &report) {
+    size_t i = begin;
+    auto record = [&](size_t idx) {
+        report.mismatches++;
+        if (report.first_mismatches.size() < max_reported) report.first_mismatches.push_back(idx);
+    };
+#if defined(__AVX2__)
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 v_abs_tol = _mm256_set1_ps(abs_tol);
+    const __m256 v_rel_tol = _mm256_set1_ps(rel_tol);
+    const __m256i low_bits = _mm256_set1_epi32(0x7fffffff);
+    __m256 max_abs = _mm256_setzero_ps();
+    __m256 max_rel = _mm256_setzero_ps();
+    __m256i max_ulp = _mm256_setzero_si256();
+    for (; i + 8 <= end; i += 8) {
+        __m256 a = _mm256_loadu_ps(actual + i);
+        __m256 e = _mm256_loadu_ps(expected + i);
+        __m256 diff = _mm256_and_ps(_mm256_sub_ps(a, e), abs_mask);
+        __m256 e_abs = _mm256_and_ps(e, abs_mask);
+        // NaN operands are placed second so that they never replace the running max
+        max_abs = _mm256_max_ps(diff, max_abs);
+        max_rel = _mm256_max_ps(_mm256_div_ps(diff, e_abs), max_rel);
+        __m256 tol = _mm256_add_ps(v_abs_tol, _mm256_mul_ps(v_rel_tol, e_abs));
+        // equal values match even if infinite (e.g., unreachable vertices of a min-plus product)
+        int mask = _mm256_movemask_ps(_mm256_and_ps(
+            _mm256_cmp_ps(diff, tol, _CMP_NLE_UQ), _mm256_cmp_ps(a, e, _CMP_NEQ_UQ)));
+
+        __m256i ia = _mm256_castps_si256(a), ie = _mm256_castps_si256(e);
+        ia = _mm256_xor_si256(ia, _mm256_and_si256(_mm256_srai_epi32(ia, 31), low_bits));
+        ie = _mm256_xor_si256(ie, _mm256_and_si256(_mm256_srai_epi32(ie, 31), low_bits));
+        __m256i ulp = _mm256_min_epu32(_mm256_sub_epi32(ia, ie), _mm256_sub_epi32(ie, ia));
+        ulp = _mm256_and_si256(ulp, _mm256_castps_si256(_mm256_cmp_ps(a, e, _CMP_ORD_Q)));
+        max_ulp = _mm256_max_epu32(max_ulp, ulp);
+
+        while (mask) {
+            int bit = __builtin_ctz(mask);
+            record(i + bit);
+            mask &= mask - 1;
+        }
+    }
+    float lanes[8];
+    uint32_t ulp_lanes[8];
+    _mm256_storeu_ps(lanes, max_abs);
+    for (float v : lanes) report.max_abs_error = std::max<double>(report.max_abs_error, v);
+    _mm256_storeu_ps(lanes, max_rel);
+    for (float v : lanes) report.max_rel_error = std::max<double>(report.max_rel_error, v);
+    _mm256_storeu_si256((__m256i*)ulp_lanes, max_ulp);
+    for (uint32_t v : ulp_lanes) report.max_ulp_distance = std::max<uint64_t>(report.max_ulp_distance, v);
+#endif
+    for (; i < end; i++) {
+        float diff = std::fabs(actual[i] - expected[i]);
+        float e_abs = std::fabs(expected[i]);
+        if (!std::isnan(diff)) {
+            report.max_abs_error = std::max<double>(report.max_abs_error, diff);
+            float rel = diff / e_abs;
+            if (!std::isnan(rel)) report.max_rel_error = std::max<double>(report.max_rel_error, rel);
+            int64_t ulp = (int64_t)ordered_float_bits(actual[i]) - ordered_float_bits(expected[i]);
+            report.max_ulp_distance = std::max<uint64_t>(report.max_ulp_distance, ulp < 0 ? -ulp : ulp);
+        }
+        if (actual[i] != expected[i] && !(diff <= abs_tol + rel_tol * e_abs)) record(i);
+    }
+}
+
+
+// Compare actual against expected in parallel without stopping at the first mismatch. An element
+// mismatches if it differs from expected by more than abs_tol + rel_tol * |expected|, or if either
+// value is NaN. Equal infinities match.
+inline ValidationReport validate_results(const float *actual, size_t actual_size,
+                                         const float *expected, size_t expected_size,
+                                         float abs_tol = 1e-3, float rel_tol = 0,
+                                         size_t max_reported = 10, unsigned num_threads = 0) {
+    ValidationReport report;
+    if (actual_size != expected_size) {
+        report.size_match = false;
+        return report;
+    }
+    report.count = actual_size;
+    if (num_threads == 0) num_threads = default_num_threads();
+    std::vector<ValidationReport> partial(num_threads);
+    parallel_for(0, actual_size, num_threads, [&](size_t begin, size_t end, unsigned t) {
+        validate_range(actual, expected, begin, end, abs_tol, rel_tol, max_reported, partial[t]);
+    }, 1 << 16);
+    // chunks are in increasing order, so the first indices come from the first chunks
+    for (auto &p : partial) {
+        report.mismatches += p.mismatches;
+        report.max_abs_error = std::max(report.max_abs_error, p.max_abs_error);
+        report.max_rel_error = std::max(report.max_rel_error, p.max_rel_error);
+        report.max_ulp_distance = std::max(report.max_ulp_distance, p.max_ulp_distance);
+        for (size_t idx : p.first_mismatches) {
+            if (report.first_mismatches.size() < max_reported) report.first_mismatches.push_back(idx);
+        }
+    }
+    return report;
+}
+
+
+// Same as above for any containers of floats (std::vector, xhl::aligned_vector, ...), without copying.
+template<typename actual_container, typename expected_container>
+ValidationReport validate_results(actual_container const &actual, expected_container const &expected,
+                                  float abs_tol = 1e-3, float rel_tol = 0,
+                                  size_t max_reported = 10, unsigned num_threads = 0) {
+    return validate_results(actual.data(), actual.size(), expected.data(), expected.size(),
+                            abs_tol, rel_tol, max_reported, num_threads);
+}
+
+
+// Print a report, including the first mismatching values.
+inline void print_validation_report(std::ostream &stream, ValidationReport const &report,
+                                    const float *actual, const float *expected) {
+    if (!report.size_match) {
+        stream << "[ERROR]: Size mismatch!" << std::endl;
+        return;
+    }
+    stream << "Compared " << report.count << " values: " << report.mismatches << " mismatches, "
+           << "max abs error " << report.max_abs_error << ", max rel error " << report.max_rel_error
+           << ", max ULP distance " << report.max_ulp_distance << std::endl;
+    for (size_t idx : report.first_mismatches) {
+        stream << "[ERROR]: Value mismatch at i = " << idx << ", expected " << expected[idx]
+               << ", actual " << actual[idx] << std::endl;
+    }
+}
+
+#endif  // VALIDATE_HPP
@@ -0,0 +1,130 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <cstdlib>   // For rand() function
+
+#include "xocl-host-lib.hpp"
+#include "device.hpp"
+#include "compute_unit.hpp"
+#include "sparse-io.hpp"
+#include "spmv-cpu.hpp"
+#include "spmm-cpu.hpp"
+#include "validate.hpp"
+#include "module_spmm.hpp"
+
+#include "profiling-infra.h"
+
+#include "xcl2.hpp"
+
+// the semiring of the kernel, set by SEMIRING in the Makefile
+#ifndef SPMV_SEMIRING
+#define SPMV_SEMIRING PlusTimes
+#endif
+
+//----------------------------------------------------------------------------
+// Testbench
+//----------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    // parse arguments
+    if(argc < 3) {
+        std::cout << "Usage : " << argv[0] << " <xclbin path> <dataset path> [number of vectors]" << std::endl;
+        std::cout << "Aborting..." << std::endl;
+        return 1;
+    }
+    size_t num_vectors = (argc > 3) ? std::stoul(argv[3]) : 32;
+
+    //--------------------------------------------------------------------
+    // loading matrix data
+    //--------------------------------------------------------------------
+    std::cout << "INFO : Loading Dataset" << std::endl;
+    CSRMatrix<float> mat = load_csr_matrix_from_float_npz(argv[2]);
+
+    //--------------------------------------------------------------------
+    // generate input vectors
+    //--------------------------------------------------------------------
+    std::vector<xhl::aligned_vector<float>> vectors_in(num_vectors, xhl::aligned_vector<float>(mat.num_cols));
+    std::vector<xhl::aligned_vector<float>> vectors_out;
+    for (auto &v : vectors_in) {
+        std::generate(v.begin(), v.end(), [&](){return (float)rand() / (float)(RAND_MAX/10);});
+    }
+
+    //--------------------------------------------------------------------
+    // compute reference
+    //--------------------------------------------------------------------
+    CPUSpMVEngine<float, SPMV_SEMIRING<float>> engine(mat);
+    std::vector<std::vector<float>> ref_results(num_vectors, std::vector<float>(mat.num_rows));
+    for (size_t v = 0; v < num_vectors; v++) {
+        engine.spmv(vectors_in[v].data(), ref_results[v].data());
+    }
+    std::cout << "INFO : Compute reference complete!" << std::endl;
+
+    //--------------------------------------------------------------------
+    // Profiling Setup
+    //--------------------------------------------------------------------
+    TIMER_INIT(time);
+    Measure compute_time;
+
+    //--------------------------------------------------------------------
+    // Module Setup
+    //--------------------------------------------------------------------
+    std::cout << "INFO : SpMM Test with " << num_vectors << " vectors" << std::endl;
+    std::vector<xhl::Device> devices = xhl::find_devices(
+        xhl::boards::alveo::u280::identifier
+    );
+    devices[0].program_device(argv[1]);
+
+    xhl::Module_spmm<SPMV_SEMIRING<float>> module;
+    module.initialize(devices);
+    module.load_matrix(mat);
+
+    TIME_IT(time) {
+        module.run(vectors_in, vectors_out);
+    }
+    compute_time.addSample(time);
+    std::cout << "INFO : Batches of " << module.batch_size() << " vectors" << std::endl;
+
+    //--------------------------------------------------------------------
+    // CPU SpMM on the interleaved batches of the module, checked against
+    // the SpMV of every vector
+    //--------------------------------------------------------------------
+    uint32_t k_max = module.batch_size();
+    std::vector<float> batch_in((size_t)mat.num_cols * k_max);
+    std::vector<float> batch_out((size_t)mat.num_rows * k_max);
+    std::vector<std::vector<float>> spmm_results(num_vectors, std::vector<float>(mat.num_rows));
+    for (size_t first = 0; first < num_vectors; first += k_max) {
+        uint32_t k = std::min<size_t>(k_max, num_vectors - first);
+        interleave_vectors(vectors_in, first, k, mat.num_cols, batch_in.data());
+        spmm_cpu_parallel<float, SPMV_SEMIRING<float>>(mat, batch_in.data(), batch_out.data(), k);
+        deinterleave_vectors(batch_out.data(), k, mat.num_rows, spmm_results, first);
+    }
+
+    //--------------------------------------------------------------------
+    // compare result
+    //--------------------------------------------------------------------
+    bool pass = true;
+    for (size_t v = 0; v < num_vectors; v++) {
+        // the two references sum in a different order, allow for the rounding of large sums
+        ValidationReport spmm_report = validate_results(spmm_results[v], ref_results[v], 1e-3, 1e-5);
+        if (!spmm_report.passed()) {
+            std::cout << "[ERROR]: CPU SpMM, vector " << v << std::endl;
+            print_validation_report(std::cout, spmm_report, spmm_results[v].data(), ref_results[v].data());
+            pass = false;
+        }
+        ValidationReport report = validate_results(vectors_out[v], spmm_results[v]);
+        if (!report.passed()) {
+            std::cout << "[ERROR]: Vector " << v << std::endl;
+            print_validation_report(std::cout, report, vectors_out[v].data(), spmm_results[v].data());
+            pass = false;
+        }
+    }
+    std::cout << (pass ? "[INFO]: Test Passed !" : "[ERROR]: Test Failed!") << std::endl;
+    std::cout << "\t\tTotal\t\tAvg\t\tMin\t\tMax" << std::endl;
+    std::cout << "Compute:\t" << compute_time << std::endl;
+
+    std::cout << "INFO : SpMM module complete!" << std::endl;
+
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "xocl-host-lib.hpp"
+#include "device.hpp"
+#include "compute_unit.hpp"
+#include "placement.hpp"
+#include "spmm-cpu.hpp"
+#include "module_spmm.hpp"
+
+namespace xhl{
+
+template<typename semiring>
+Module_spmm<semiring>::Module_spmm(uint32_t max_batch)
+    : spmm_cu(nullptr), _max_batch(std::min(std::max(max_batch, 1u), SPMM_MAX_BATCH)),
+      _batch_size(0), _mat(nullptr) {}
+
+template<typename semiring>
+void Module_spmm<semiring>::initialize(std::vector<Device>& devices) {
+    this->spmm_cu = devices[0].find(this->spmm);
+}
+
+template<typename semiring>
+void Module_spmm<semiring>::free_cu(){
+    delete this->spmm_cu;
+    this->spmm_cu = nullptr;
+}
+
+template<typename semiring>
+Module_spmm<semiring>::~Module_spmm(){
+    this->free_cu();
+}
+
+template<typename semiring>
+void Module_spmm<semiring>::load_matrix(const CSRMatrix<float> &mat) {
+    auto device_1 = this->spmm_cu->cu_device;
+    device_1->finish_all_tasks();
+    this->_mat = &mat;
+    this->_batch_size = 0;
+
+    const size_t nnz = mat.adj_data.size();
+    const std::vector<int> spmm_banks = {0, 1, 2, 3, 4, 5, 6, 7};
+    PlacementPlanner planner(boards::alveo::u280::HBM, 32, boards::alveo::u280::HBM_CHANNEL_SIZE);
+    planner.add_buffer({"values", nnz * sizeof(float), (double)nnz, spmm_banks});
+    planner.add_buffer({"col_idx", nnz * sizeof(unsigned), (double)nnz, spmm_banks});
+    planner.add_buffer({"row_ptr", (mat.num_rows + 1) * sizeof(unsigned), (double)mat.num_rows, spmm_banks});
+    // the vector buffers are planned at their largest batch, up to a whole channel
+    const size_t channel = boards::alveo::u280::HBM_CHANNEL_SIZE;
+    size_t in_size = std::min(channel, (size_t)mat.num_cols * this->_max_batch * sizeof(float));
+    size_t out_size = std::min(channel, (size_t)mat.num_rows * this->_max_batch * sizeof(float));
+    planner.add_buffer({"vectors_in", in_size, (double)nnz * this->_max_batch, spmm_banks});
+    planner.add_buffer({"vectors_out", out_size, (double)mat.num_rows * this->_max_batch, spmm_banks});
+    this->_placement = planner.plan();
+
+    for (const char *name : {"values", "col_idx", "row_ptr", "vectors_in", "vectors_out"}) {
+        if (device_1->contains_buffer(name)) device_1->release_buffer(name);
+    }
+    create_placed_buffer(device_1, this->_placement["values"],
+        const_cast<float*>(mat.adj_data.data()), BufferType::ReadOnly);
+    create_placed_buffer(device_1, this->_placement["col_idx"],
+        const_cast<uint32_t*>(mat.adj_indices.data()), BufferType::ReadOnly);
+    create_placed_buffer(device_1, this->_placement["row_ptr"],
+        const_cast<uint32_t*>(mat.adj_indptr.data()), BufferType::ReadOnly);
+    nb_sync_data_htod(device_1, "values");
+    nb_sync_data_htod(device_1, "col_idx");
+    nb_sync_data_htod(device_1, "row_ptr");
+}
+
+template<typename semiring>
+void Module_spmm<semiring>::_bind_batches(uint32_t batch_size) {
+    if (batch_size == this->_batch_size) return;
+    auto device_1 = this->spmm_cu->cu_device;
+    const CSRMatrix<float> &mat = *this->_mat;
+    this->_batch_in.assign((size_t)mat.num_cols * batch_size, 0);
+    this->_batch_out.assign((size_t)mat.num_rows * batch_size, 0);
+    // the segments of the planned placement give the banks, the sizes follow the batch
+    BufferPlacement in = this->_placement["vectors_in"];
+    BufferPlacement out = this->_placement["vectors_out"];
+    in.segments[0].size = this->_batch_in.size() * sizeof(float);
+    out.segments[0].size = this->_batch_out.size() * sizeof(float);
+    for (const char *name : {"vectors_in", "vectors_out"}) {
+        if (device_1->contains_buffer(name)) device_1->release_buffer(name);
+    }
+    create_placed_buffer(device_1, in, this->_batch_in.data(), BufferType::ReadOnly);
+    create_placed_buffer(device_1, out, this->_batch_out.data(), BufferType::WriteOnly);
+    this->_batch_size = batch_size;
+}
+
+template<typename semiring>
+void Module_spmm<semiring>::run(
+    const std::vector<aligned_vector<float>> &vectors_in,
+    std::vector<aligned_vector<float>> &vectors_out
+) {
+    if (this->_mat == nullptr) {
+        throw std::runtime_error("No matrix loaded, call load_matrix first");
+    }
+    const CSRMatrix<float> &mat = *this->_mat;
+    for (auto &v : vectors_in) {
+        if (v.size() != mat.num_cols) {
+            throw std::runtime_error(
+                "Input vector has " + std::to_string(v.size()) + " entries, expected "
+                + std::to_string(mat.num_cols)
+            );
+        }
+    }
+    vectors_out.resize(vectors_in.size());
+    for (auto &v : vectors_out) v.resize(mat.num_rows);
+    if (vectors_in.empty()) return;
+
+    auto device_1 = this->spmm_cu->cu_device;
+    uint32_t batch_size = pick_batch_size(
+        vectors_in.size(), mat.num_rows, mat.num_cols, sizeof(float),
+        boards::alveo::u280::HBM_CHANNEL_SIZE, this->_max_batch
+    );
+    if (batch_size == 0) {
+        throw std::runtime_error("One interleaved vector does not fit in an HBM channel");
+    }
+    this->_bind_batches(batch_size);
+
+    for (size_t first = 0; first < vectors_in.size(); first += batch_size) {
+        uint32_t k = std::min<size_t>(batch_size, vectors_in.size() - first);
+        interleave_vectors(vectors_in, first, k, mat.num_cols, this->_batch_in.data());
+        nb_sync_data_htod(device_1, "vectors_in");
+        this->spmm_cu->launch(
+            device_1->get_buffer("values"),
+            device_1->get_buffer("col_idx"),
+            device_1->get_buffer("row_ptr"),
+            device_1->get_buffer("vectors_in"),
+            device_1->get_buffer("vectors_out"),
+            mat.num_rows,
+            mat.num_cols,
+            k
+        );
+        sync_data_dtoh(device_1, "vectors_out");
+        deinterleave_vectors(this->_batch_out.data(), k, mat.num_rows, vectors_out, first);
+    }
+}
+
+template<typename semiring>
+uint32_t Module_spmm<semiring>::batch_size() const {
+    return this->_batch_size;
+}
+
+// the semirings of semiring.hpp
+template class Module_spmm<PlusTimes<float>>;
+template class Module_spmm<MinPlus<float>>;
+template class Module_spmm<OrAnd<float>>;
+
+} // namespace xhl
@@ -0,0 +1,97 @@
+#ifndef MODULE_SPMM_HPP
+#define MODULE_SPMM_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+
+#include "xocl-host-lib.hpp"
+#include "compute_unit.hpp"
+#include "module.hpp"
+#include "device.hpp"
+#include "placement.hpp"
+#include "sparse-io.hpp"
+#include "semiring.hpp"
+
+namespace xhl{
+
+// the largest batch the spmm kernel accumulates at once (MAX_BATCH in spmm.cpp)
+const uint32_t SPMM_MAX_BATCH = 16;
+
+/**
+ * @brief batched SpMV: many vectors times one resident matrix. The vectors
+ * are interleaved into batches of K, and every pass of the kernel over the
+ * matrix produces K results, so the matrix is streamed once per K vectors.
+ *
+ * @tparam semiring the semiring of the product (see semiring.hpp), it must
+ * match the one the spmm kernel was built with
+ */
+template<typename semiring = PlusTimes<float>>
+class Module_spmm : public xhl::Module {
+    public:
+    ComputeUnit* spmm_cu;
+
+    const KernelSignature spmm = {
+        "spmm", {
+            {"values", "float*"},
+            {"col_idx", "unsigned*"},
+            {"row_ptr", "unsigned*"},
+            {"vectors_in", "float*"},
+            {"vectors_out", "float*"},
+            {"num_rows", "unsigned"},
+            {"num_cols", "unsigned"},
+            {"num_vectors", "unsigned"}
+        }
+    };
+
+    /**
+     * @brief constructor
+     *
+     * @param max_batch the largest batch, at most SPMM_MAX_BATCH
+     */
+    Module_spmm(uint32_t max_batch = SPMM_MAX_BATCH);
+
+    void initialize(std::vector<Device>& devices) override;
+
+    void free_cu() override;
+
+    ~Module_spmm();
+
+    /**
+     * @brief upload the matrix, it stays resident on the device for all runs
+     *
+     * @param mat the matrix, must outlive the module
+     */
+    void load_matrix(const CSRMatrix<float> &mat);
+
+    /**
+     * @brief vectors_out[v] = mat * vectors_in[v] for all v
+     *
+     * @param vectors_in the input vectors, num_cols entries each
+     * @param vectors_out resized to the number of inputs, num_rows entries each
+     *
+     * @exception std::runtime_error if an input does not have num_cols entries
+     */
+    void run(
+        const std::vector<aligned_vector<float>> &vectors_in,
+        std::vector<aligned_vector<float>> &vectors_out
+    );
+
+    /**
+     * @brief get the batch size K of the last run
+     */
+    uint32_t batch_size() const;
+
+    private:
+    uint32_t _max_batch;
+    uint32_t _batch_size;
+    const CSRMatrix<float> *_mat;
+    std::map<std::string, BufferPlacement> _placement;
+    aligned_vector<float> _batch_in; // num_cols * K interleaved entries
+    aligned_vector<float> _batch_out; // num_rows * K interleaved entries
+
+    void _bind_batches(uint32_t batch_size);
+};
+} // namespace xhl
+#endif // MODULE_SPMM_HPP
@@ -0,0 +1,2 @@
+module_spmm_CXXFLAGS += -I$(XOCL_HOST_LIB)/examples/spmm-xhl-module/module_spmm
+module_spmm_SRCS += $(XOCL_HOST_LIB)/examples/spmm-xhl-module/module_spmm/module_spmm.cpp
@@ -0,0 +1,70 @@
+#include "semiring.hpp"
+
+// the semiring is picked at build time, e.g., -DSPMV_SEMIRING=MinPlus
+#ifndef SPMV_SEMIRING
+#define SPMV_SEMIRING PlusTimes
+#endif
+
+const unsigned FPADD_LATENCY = 8;
+// the largest batch, one accumulator per vector
+const unsigned MAX_BATCH = 16;
+
+// vectors_out = mat * vectors_in for num_vectors interleaved vectors: entry c of vector k is at
+// [c * num_vectors + k]. Each non-zero is read once for all vectors.
+template<typename semiring>
+void spmm_rows(
+    const float* values,
+    const unsigned* col_idx,
+    const unsigned* row_ptr,
+    const float* vectors_in,
+    float* vectors_out,
+    const unsigned num_rows,
+    const unsigned num_vectors
+) {
+    for (unsigned row_idx = 0; row_idx < num_rows; row_idx++) {
+        #pragma HLS pipeline off
+        unsigned start = row_ptr[row_idx];
+        unsigned end = row_ptr[row_idx + 1];
+
+        float res[MAX_BATCH];
+        #pragma HLS array_partition variable=res complete
+        for (unsigned k = 0; k < MAX_BATCH; k++) {
+            #pragma HLS unroll
+            res[k] = semiring::zero();
+        }
+        for (unsigned i = start; i < end; i++) {
+            #pragma HLS pipeline II=FPADD_LATENCY style=flp
+            float value = values[i];
+            const float* x = vectors_in + col_idx[i] * num_vectors;
+            for (unsigned k = 0; k < MAX_BATCH; k++) {
+                #pragma HLS unroll
+                if (k < num_vectors) res[k] = semiring::add(res[k], semiring::mul(value, x[k]));
+            }
+        }
+
+        for (unsigned k = 0; k < num_vectors; k++) {
+            #pragma HLS pipeline II=1
+            vectors_out[row_idx * num_vectors + k] = res[k];
+        }
+    }
+}
+
+extern "C"  void spmm (
+    const float* values,
+    const unsigned* col_idx,
+    const unsigned* row_ptr,
+    const float* vectors_in,
+    float* vectors_out,
+
+    const unsigned num_rows,
+    const unsigned num_cols,
+    const unsigned num_vectors
+) {
+    #pragma HLS interface m_axi port=values         offset=slave bundle=gmem_mat1
+    #pragma HLS interface m_axi port=col_idx        offset=slave bundle=gmem_mat2
+    #pragma HLS interface m_axi port=row_ptr        offset=slave bundle=gmem_mat3
+    #pragma HLS interface m_axi port=vectors_in     offset=slave bundle=gmem_vec1
+    #pragma HLS interface m_axi port=vectors_out    offset=slave bundle=gmem_vec2
+
+    spmm_rows<SPMV_SEMIRING<float>>(values, col_idx, row_ptr, vectors_in, vectors_out, num_rows, num_vectors);
+}
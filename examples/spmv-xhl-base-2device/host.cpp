@@ -12,114 +12,43 @@
 #include "compute_unit.hpp"
 #include "link.hpp"
 #include "sparse-io.hpp"
+#include "csr-partition.hpp"
+#include "spmv-cpu.hpp"
+#include "validate.hpp"
 #include "host_memory_link.h"
 
 #include "profiling-infra.h"
 
 #include "xcl2.hpp"
 
-std::pair<std::vector<CSRMatrix<float>>,std::vector<uint32_t>> partitionMatrixIn2(
-    CSRMatrix<float> matrix,
+// The whole matrix takes 64-bit index pointers, so that it may hold more than 2^32 non-zeros. Each
+// device gets a row partition narrowed to 32-bit local indices (see csr-partition.hpp).
+typedef CSRMatrix<float, uint32_t, uint64_t> HostMatrix;
+
+std::vector<CSRRowPartition<float>> partitionMatrixIn2(
+    HostMatrix const &matrix,
     bool balance_workload = false
 ) {
-    std::vector<CSRMatrix<float>> partitions;
-    uint32_t row_partition[2] = {matrix.num_rows / 2, matrix.num_rows - matrix.num_rows / 2};
     if (balance_workload) {
-        size_t half = matrix.adj_indices.size() / 2;
-        size_t ind;
-        for (ind = 0; ind < matrix.adj_indptr.size(); ind++)
-            if (matrix.adj_indptr[ind] > half)
-                break;
-        if (ind != 0 && half-matrix.adj_indptr[ind-1] < matrix.adj_indptr[ind] - half)
-            --ind;
-        row_partition[0] = ind;
-        row_partition[1] = matrix.num_rows - ind;
-    }
-    uint32_t start = 0;
-    for (int p = 0; p < 2; p++) {
-        CSRMatrix<float> part;
-        part.num_cols = matrix.num_cols;
-        part.num_rows = matrix.num_rows;
-        uint32_t end = start + row_partition[p];
-        for (uint32_t i = 0; i < start + 1; i++)
-            part.adj_indptr.push_back(0);
-        for(uint32_t i = start; i < end; i++) {
-            for (uint32_t j = matrix.adj_indptr[i]; j < matrix.adj_indptr[i+1]; j++) {
-                part.adj_indices.push_back(matrix.adj_indices[j]);
-                part.adj_data.push_back(matrix.adj_data[j]);
-            }
-            part.adj_indptr.push_back(part.adj_data.size());
-        }
-        for (uint32_t i = end; i < matrix.num_rows; i++)
-            part.adj_indptr.push_back(part.adj_data.size());
-        partitions.push_back(part);
-        start += row_partition[p];
-    }
-    std::vector<uint32_t> rows;
-    rows.push_back(row_partition[0]);
-    rows.push_back(row_partition[1]);
-    return std::make_pair(partitions, rows);
-}
-// check buffer
-bool check_results(
-    xhl::aligned_vector<float> v,
-    std::vector<float> ref,
-    bool stop_on_mismatch = true,
-    float tolerance = 1e-3
-) {
-    // check length
-    if (v.size() != ref.size()) {
-        std::cout << "[ERROR]: Size mismatch!" << std::endl;
-        std::cout << "         Expected: " << ref.size() << std::endl;
-        std::cout << "         Actual  : " << v.size() << std::endl;
-        return false;
-    }
-
-    // check items
-    bool match = true;
-    for (size_t i = 0; i < v.size(); i++) {
-        if (std::abs(v[i] - ref[i]) > tolerance) {
-            std::cout << "[ERROR]: Value mismatch!" << std::endl;
-            std::cout << "         at i = " << i << std::endl;
-            printf("         Expected: %0.8f\n", ref[i]);
-            printf("         Actual  : %0.8f\n", v[i]);
-            if (stop_on_mismatch) return false;
-            match = false;
-        }
+        return partition_csr_rows_by_nnz(matrix, 2);
     }
-    return match;
+    return partition_csr_rows(matrix, {0, matrix.num_rows / 2, matrix.num_rows});
 }
 
 //-----------------------------------------------------------------------------
 // ground true data
 //-----------------------------------------------------------------------------
 void compute_ref(
-    CSRMatrix<float> &mat,
-    std::vector<float> &vector,
-    std::vector<float> &ref_result
-) {
-    ref_result.resize(mat.num_rows);
-    std::fill(ref_result.begin(), ref_result.end(), 0);
-    for (size_t row_idx = 0; row_idx < mat.num_rows; row_idx++) {
-        uint32_t start = mat.adj_indptr[row_idx];
-        uint32_t end = mat.adj_indptr[row_idx + 1];
-        for (size_t i = start; i < end; i++) {
-            uint32_t idx = mat.adj_indices[i];
-            ref_result[row_idx] += mat.adj_data[i] * vector[idx];
-        }
-    }
-}
-void compute_ref(
-    CSRMatrix<float> &mat,
+    HostMatrix &mat,
     xhl::aligned_vector<float> &vector,
     std::vector<float> &ref_result,
     size_t iterations
 ) {
-    ref_result.resize(mat.num_rows);
-    std::vector<float> vec0(vector.begin(), vector.end()), vec1(vector.size());
-    for (size_t i = 0; i < iterations; i++)
-        compute_ref(mat, i%2==0 ? vec0 : vec1, i%2==0 ? vec1 : vec0);
-    std::copy((iterations%2==0 ? vec0 : vec1).begin(), (iterations%2==0 ? vec0 : vec1).end(), ref_result.begin());
+    CPUSpMVEngine<float, PlusTimes<float>, uint32_t, uint64_t> engine(mat);
+    ref_result.assign(vector.begin(), vector.end());
+    std::vector<float> scratch(mat.num_rows);
+    float *result = engine.iterate(ref_result.data(), scratch.data(), iterations);
+    if (result != ref_result.data()) ref_result.swap(scratch);
 }
 
 //----------------------------------------------------------------------------
@@ -143,11 +72,15 @@ int main(int argc, char** argv) {
     // loading matrix data
     //--------------------------------------------------------------------
     std::cout << "INFO : Loading Dataset" << std::endl;
-    CSRMatrix<float> mat_f =
-        load_csr_matrix_from_float_npz(argv[2]);
-    std::pair<std::vector<CSRMatrix<float>>,std::vector<uint32_t>> pair = partitionMatrixIn2(mat_f, balance_workload);
-    std::vector<CSRMatrix<float>> pmat = pair.first;
-    std::vector<uint32_t> prow = pair.second;
+    HostMatrix mat_f =
+        load_csr_matrix_from_float_npz<uint32_t, uint64_t>(argv[2]);
+    std::vector<CSRRowPartition<float>> parts = partitionMatrixIn2(mat_f, balance_workload);
+    std::vector<CSRMatrix<float>> pmat;
+    std::vector<uint32_t> prow;
+    for (auto &part : parts) {
+        prow.push_back(part.local.num_rows);
+        pmat.push_back(std::move(part.local));
+    }
 
     //--------------------------------------------------------------------
     // data setup and generate input vector
@@ -158,8 +91,9 @@ int main(int argc, char** argv) {
     std::vector<xhl::aligned_vector<unsigned>> adj_indices_vec;
     std::vector<xhl::aligned_vector<unsigned>> adj_indptr_vec;
     for (int i = 0; i < 2; i++) {
-        vector_in_vec.push_back(xhl::aligned_vector<float>(pmat[i].num_cols));
-        vector_out_vec.push_back(xhl::aligned_vector<float>(pmat[i].num_rows));
+        // both vectors cover the whole matrix, a device writes its rows and receives the others
+        vector_in_vec.push_back(xhl::aligned_vector<float>(mat_f.num_cols));
+        vector_out_vec.push_back(xhl::aligned_vector<float>(mat_f.num_rows));
         adj_data_vec.push_back(xhl::aligned_vector<float>(pmat[i].adj_data.size()));
         adj_indices_vec.push_back(xhl::aligned_vector<unsigned>(pmat[i].adj_indices.size()));
         adj_indptr_vec.push_back(xhl::aligned_vector<unsigned>(pmat[i].adj_indptr.size()));
@@ -199,7 +133,8 @@ int main(int argc, char** argv) {
             {"vector_in", "float*"},
             {"vector_out", "float*"},
             {"num_rows", "unsigned"},
-            {"num_cols", "unsigned"}
+            {"num_cols", "unsigned"},
+            {"row_offset", "unsigned"}
         }
     };
     std::vector<xhl::Device> devices = xhl::find_devices(
@@ -230,11 +165,11 @@ int main(int argc, char** argv) {
             xhl::BufferType::ReadOnly, xhl::boards::alveo::u280::HBM[1]
         );
         device.create_buffer(
-            "vector_in", (pmat[i].num_cols) * sizeof(float), vector_in_vec[i].data(),
+            "vector_in", (mat_f.num_cols) * sizeof(float), vector_in_vec[i].data(),
             xhl::BufferType::ReadOnly, xhl::boards::alveo::u280::HBM[2]
         );
         device.create_buffer(
-            "vector_out", (pmat[i].num_rows) * sizeof(float), vector_out_vec[i].data(),
+            "vector_out", (mat_f.num_rows) * sizeof(float), vector_out_vec[i].data(),
             xhl::BufferType::WriteOnly, xhl::boards::alveo::u280::HBM[2]
         );
 
@@ -264,7 +199,8 @@ int main(int argc, char** argv) {
                     (i % 2) ? devices[j].get_buffer("vector_out") : devices[j].get_buffer("vector_in"),
                     (i % 2) ? devices[j].get_buffer("vector_in") : devices[j].get_buffer("vector_out"),
                     pmat[j].num_rows,
-                    pmat[j].num_cols
+                    pmat[j].num_cols,
+                    (unsigned)parts[j].row_begin
                 );
             }
             for (int j = 0; j < 2; j++)
@@ -287,7 +223,9 @@ int main(int argc, char** argv) {
     //--------------------------------------------------------------------
     // compare result
     //--------------------------------------------------------------------
-    bool pass = check_results(vector_out_vec[0], ref_result);
+    ValidationReport report = validate_results(vector_out_vec[0], ref_result);
+    print_validation_report(std::cout, report, vector_out_vec[0].data(), ref_result.data());
+    bool pass = report.passed();
     std::cout << (pass ? "[INFO]: Test Passed !" : "[ERROR]: Test Failed!") << std::endl;
     std::cout << "\t\tTotal\t\tAvg\t\tMin\t\tMax" << std::endl;
     std::cout << "Compute:\t" << compute_time << std::endl;
@@ -8,7 +8,8 @@ extern "C"  void spmv (
     float* vector_out,
 
     const unsigned num_rows,
-    const unsigned num_cols
+    const unsigned num_cols,
+    const unsigned row_offset
 ) {
     #pragma HLS interface m_axi port=values         offset=slave bundle=gmem_mat1
     #pragma HLS interface m_axi port=col_idx        offset=slave bundle=gmem_mat2
@@ -28,6 +29,7 @@ extern "C"  void spmv (
             res += values[i] * vector_in[idx];
         }
 
-        vector_out[row_idx] = res;
+        // the rows of this partition start at row_offset of the whole vector
+        vector_out[row_offset + row_idx] = res;
     }
 }
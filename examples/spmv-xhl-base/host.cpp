@@ -4,82 +4,85 @@
 #include <chrono>
 #include <string>
 #include <algorithm>
+#include <map>
 #include <cstdlib>   // For rand() function
 #include <ctime>     // For srand() function
 
 #include "xocl-host-lib.hpp"
 #include "device.hpp"
 #include "compute_unit.hpp"
+#include "placement.hpp"
 #include "sparse-io.hpp"
+#include "spmv-cpu.hpp"
+#include "generators.hpp"
+#include "reorder.hpp"
+#include "quantize.hpp"
+#include "validate.hpp"
 
 #include "profiling-infra.h"
 
 #include "xcl2.hpp"
-// check buffer
-bool check_results(
-    xhl::aligned_vector<float> v,
-    std::vector<float> ref,
-    bool stop_on_mismatch = true,
-    float tolerance = 1e-3
-) {
-    // check length
-    if (v.size() != ref.size()) {
-        std::cout << "[ERROR]: Size mismatch!" << std::endl;
-        std::cout << "         Expected: " << ref.size() << std::endl;
-        std::cout << "         Actual  : " << v.size() << std::endl;
-        return false;
-    }
 
-    // check items
-    bool match = true;
-    for (size_t i = 0; i < v.size(); i++) {
-        if (std::abs(v[i] - ref[i]) > tolerance) {
-            std::cout << "[ERROR]: Value mismatch!" << std::endl;
-            std::cout << "         at i = " << i << std::endl;
-            printf("         Expected: %0.8f\n", ref[i]);
-            printf("         Actual  : %0.8f\n", v[i]);
-            if (stop_on_mismatch) return false;
-            match = false;
-        }
-    }
-    return match;
-}
+// the semiring of the kernel, set by SEMIRING in the Makefile
+#ifndef SPMV_SEMIRING
+#define SPMV_SEMIRING PlusTimes
+#endif
 
 //-----------------------------------------------------------------------------
 // ground true data
 //-----------------------------------------------------------------------------
-void compute_ref(
-    CSRMatrix<float> &mat,
-    std::vector<float> &vector,
-    std::vector<float> &ref_result
-) {
-    ref_result.resize(mat.num_rows);
-    std::fill(ref_result.begin(), ref_result.end(), 0);
-    for (size_t row_idx = 0; row_idx < mat.num_rows; row_idx++) {
-        uint32_t start = mat.adj_indptr[row_idx];
-        uint32_t end = mat.adj_indptr[row_idx + 1];
-        for (size_t i = start; i < end; i++) {
-            uint32_t idx = mat.adj_indices[i];
-            ref_result[row_idx] += mat.adj_data[i] * vector[idx];
-        }
-    }
-}
 void compute_ref(
     CSRMatrix<float> &mat,
     xhl::aligned_vector<float> &vector,
     std::vector<float> &ref_result,
     size_t iterations
 ) {
-    ref_result.resize(mat.num_rows);
-    std::vector<float> vec0(vector.begin(), vector.end());
-    std::vector<float> vec1(vector.size());
-    for (size_t i = 0; i < iterations; i++)
-        compute_ref(mat, i%2==0 ? vec0 : vec1, i%2==0 ? vec1 : vec0);
-    std::copy(
-        (iterations%2==0 ? vec0 : vec1).begin(),
-        (iterations%2==0 ? vec0 : vec1).end(),
-        ref_result.begin()
-    );
+    CPUSpMVEngine<float, SPMV_SEMIRING<float>> engine(mat);
+    ref_result.assign(vector.begin(), vector.end());
+    std::vector<float> scratch(mat.num_rows);
+    float *result = engine.iterate(ref_result.data(), scratch.data(), iterations);
+    if (result != ref_result.data()) ref_result.swap(scratch);
+}
+
+//-----------------------------------------------------------------------------
+// reduced-precision values on the host: the vector encoders must match the
+// scalar ones, and the SpMV on the compressed values the float SpMV of the
+// decoded values
+//-----------------------------------------------------------------------------
+template<typename format>
+bool check_quantized(CSRMatrix<float> const &mat, const float *vector_in) {
+    QuantizedCSRMatrix<format> q = quantize_csr_matrix<format>(mat);
+    print_quantization_report(std::cout, quantization_report(mat, q));
+
+    size_t encode_mismatches = 0;
+    if constexpr (format::has_vector) {
+        typename format::storage_type encoded[8];
+        for (size_t i = 0; i + 8 <= mat.adj_data.size(); i += 8) {
+            format::encode8(mat.adj_data.data() + i, encoded);
+            for (size_t k = 0; k < 8; k++) {
+                encode_mismatches += encoded[k] != format::encode(mat.adj_data[i + k]);
+            }
+        }
+        std::cout << "INFO : " << format::name() << " vector encoder: " << encode_mismatches
+                  << " mismatches against the scalar encoder" << std::endl;
+    }
+
+    CSRMatrix<float> decoded = mat;
+    decoded.adj_data = dequantize_values(q);
+    std::vector<float> expected(mat.num_rows);
+    std::vector<float> actual(mat.num_rows);
+    spmv_cpu_parallel(decoded, vector_in, expected.data(), 0, mat.num_rows);
+    spmv_quantized_parallel(q, vector_in, actual.data());
+    ValidationReport report = validate_results(actual, expected, 1e-3, 1e-4);
+    print_validation_report(std::cout, report, actual.data(), expected.data());
+    return encode_mismatches == 0 && report.passed();
+}
+
+bool check_quantized(std::string const &format, CSRMatrix<float> const &mat, const float *vector_in) {
+    if (format == "fp16") return check_quantized<FP16Format>(mat, vector_in);
+    if (format == "bf16") return check_quantized<BF16Format>(mat, vector_in);
+    if (format == "int8") return check_quantized<Int8Format>(mat, vector_in);
+    return check_quantized<FixedFormat<24>>(mat, vector_in);
 }
 
 //----------------------------------------------------------------------------
@@ -89,16 +92,28 @@ int main(int argc, char** argv) {
     const int N = 3;
     // parse arguments
     if(argc < 3) {
-        std::cout << "Usage : " << argv[0] << " <xclbin path> <dataset path>" << std::endl;
+        std::cout << "Usage : " << argv[0] << " <xclbin path> <dataset path> [none|rcm|degree|community]"
+                  << " [none|fp16|bf16|int8|fixed]" << std::endl;
         std::cout << "Aborting..." << std::endl;
         return 1;
     }
+    std::string reorder = (argc > 3) ? argv[3] : "none";
+    std::string quantize = (argc > 4) ? argv[4] : "none";
+    if (quantize != "none" && quantize != "fp16" && quantize != "bf16" && quantize != "int8" && quantize != "fixed") {
+        std::cout << "[ERROR]: unknown value format " << quantize << std::endl;
+        return 1;
+    }
 
     //--------------------------------------------------------------------
     // loading matrix data
     //--------------------------------------------------------------------
     std::cout << "INFO : Loading Dataset" << std::endl;
-    CSRMatrix<float> mat = load_csr_matrix_from_float_npz(argv[2]);
+    // npz, Matrix Market (.mtx), binary (.bin) or text edge list, or a generator, e.g., rmat:16:16
+    NpzLoadStats load_stats;
+    CSRMatrix<float> mat = load_or_generate_float_csr_matrix(argv[2], &load_stats);
+    if (load_stats.compressed_bytes > 0) {
+        print_npz_load_report(std::cout, load_stats);
+    }
 
     //--------------------------------------------------------------------
     // generate input vector
@@ -117,6 +132,34 @@ int main(int argc, char** argv) {
     compute_ref(mat, vector_in, ref_result, N);
     std::cout << "INFO : Compute reference complete!" << std::endl;
 
+    bool quantized_pass = true;
+    if (quantize != "none") {
+        std::cout << "INFO : Checking " << quantize << " values on the host" << std::endl;
+        quantized_pass = check_quantized(quantize, mat, vector_in.data());
+    }
+
+    //--------------------------------------------------------------------
+    // reordering: the device runs on P * A * P^T and P * vector_in, the
+    // result is brought back to the original order before the comparison
+    //--------------------------------------------------------------------
+    std::vector<uint32_t> order;
+    if (reorder != "none") {
+        if (reorder == "rcm") {
+            order = rcm_order(mat);
+        } else if (reorder == "degree") {
+            order = degree_order(mat);
+        } else if (reorder == "community") {
+            order = community_order(mat);
+        } else {
+            std::cout << "[ERROR]: unknown reordering " << reorder << std::endl;
+            return 1;
+        }
+        MatrixLocality before = matrix_locality(mat);
+        mat = permute_symmetric(mat, order);
+        print_reorder_report(std::cout, "INFO : " + reorder, before, matrix_locality(mat));
+        permute_vector(vector_in.data(), order);
+    }
+
     //--------------------------------------------------------------------
     // data setup
     //--------------------------------------------------------------------
@@ -157,26 +200,31 @@ int main(int argc, char** argv) {
 
     xhl::ComputeUnit* spmv_cu = device.find(spmv);
 
-    device.create_buffer(
-        "values", (adj_data.size()) * sizeof(float), adj_data.data(),
-        xhl::BufferType::ReadOnly, xhl::boards::alveo::u280::HBM[0]
-    );
-    device.create_buffer(
-        "col_idx", (adj_indices.size()) * sizeof(unsigned), adj_indices.data(),
-        xhl::BufferType::ReadOnly, xhl::boards::alveo::u280::HBM[1]
-    );
-    device.create_buffer(
-        "row_ptr", (adj_indptr.size()) * sizeof(unsigned), adj_indptr.data(),
-        xhl::BufferType::ReadOnly, xhl::boards::alveo::u280::HBM[1]
-    );
-    device.create_buffer(
-        "vector_in", (vector_in.size()) * sizeof(float), vector_in.data(),
-        xhl::BufferType::ReadWrite, xhl::boards::alveo::u280::HBM[2]
-    );
-    device.create_buffer(
-        "vector_out", (vector_out.size()) * sizeof(float), vector_out.data(),
-        xhl::BufferType::ReadWrite, xhl::boards::alveo::u280::HBM[2]
+    // place the matrix and vectors so that concurrent streams use separate banks
+    const size_t nnz = adj_data.size();
+    const std::vector<int> spmv_banks = {0, 1, 2, 3, 4, 5, 6, 7};
+    xhl::PlacementPlanner planner(
+        xhl::boards::alveo::u280::HBM, 32, xhl::boards::alveo::u280::HBM_CHANNEL_SIZE
     );
+    planner.add_buffer({"values", nnz * sizeof(float), (double)nnz, spmv_banks});
+    planner.add_buffer({"col_idx", nnz * sizeof(unsigned), (double)nnz, spmv_banks});
+    planner.add_buffer({"row_ptr", adj_indptr.size() * sizeof(unsigned), (double)adj_indptr.size(), spmv_banks});
+    planner.add_buffer({"vector_in", vector_in.size() * sizeof(float), (double)nnz, spmv_banks});
+    planner.add_buffer({"vector_out", vector_out.size() * sizeof(float), (double)mat.num_rows, spmv_banks});
+    std::map<std::string, xhl::BufferPlacement> placement = planner.plan();
+    for (auto &p : placement) {
+        // the spmv kernel takes a single pointer per array
+        if (p.second.segments.size() != 1) {
+            std::cout << "[ERROR]: " << p.first << " does not fit in a single HBM bank" << std::endl;
+            return 1;
+        }
+    }
+
+    xhl::create_placed_buffer(&device, placement["values"], adj_data.data(), xhl::BufferType::ReadOnly);
+    xhl::create_placed_buffer(&device, placement["col_idx"], adj_indices.data(), xhl::BufferType::ReadOnly);
+    xhl::create_placed_buffer(&device, placement["row_ptr"], adj_indptr.data(), xhl::BufferType::ReadOnly);
+    xhl::create_placed_buffer(&device, placement["vector_in"], vector_in.data(), xhl::BufferType::ReadWrite);
+    xhl::create_placed_buffer(&device, placement["vector_out"], vector_out.data(), xhl::BufferType::ReadWrite);
 
     xhl::sync_data_htod(&device, "values");
     xhl::sync_data_htod(&device, "col_idx");
@@ -204,11 +252,16 @@ int main(int argc, char** argv) {
     } else {
         xhl::sync_data_dtoh(&device, "vector_out");
     }
+    if (!order.empty()) {
+        unpermute_vector(vector_out.data(), order);
+    }
 
     //--------------------------------------------------------------------
     // compare result
     //--------------------------------------------------------------------
-    bool pass = check_results(vector_out, ref_result);
+    ValidationReport report = validate_results(vector_out, ref_result);
+    print_validation_report(std::cout, report, vector_out.data(), ref_result.data());
+    bool pass = report.passed() && quantized_pass;
     std::cout << (pass ? "[INFO]: Test Passed !" : "[ERROR]: Test Failed!") << std::endl;
     std::cout << "\t\tTotal\t\tAvg\t\tMin\t\tMax" << std::endl;
     std::cout << "Compute:\t" << compute_time << std::endl;
@@ -0,0 +1,209 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <random>
+
+#include "xocl-host-lib.hpp"
+#include "device.hpp"
+#include "compute_unit.hpp"
+#include "sparse-io.hpp"
+#include "spmv-cpu.hpp"
+#include "csr-pack.hpp"
+#include "validate.hpp"
+
+#include "profiling-infra.h"
+
+#include "xcl2.hpp"
+
+// the semiring of the kernel, set by SEMIRING in the Makefile
+#ifndef SPMV_SEMIRING
+#define SPMV_SEMIRING PlusTimes
+#endif
+
+//-----------------------------------------------------------------------------
+// small random graphs, like the graphs of a GNN inference batch
+//-----------------------------------------------------------------------------
+std::vector<CSRMatrix<float>> generate_graphs(size_t count, uint32_t min_nodes, uint32_t max_nodes,
+                                              uint32_t max_degree) {
+    std::mt19937 rng(42);
+    std::vector<CSRMatrix<float>> graphs(count);
+    for (auto &g : graphs) {
+        uint32_t n = min_nodes + rng() % (max_nodes - min_nodes + 1);
+        g.num_rows = n;
+        g.num_cols = n;
+        g.adj_indptr.push_back(0);
+        for (uint32_t r = 0; r < n; r++) {
+            uint32_t degree = rng() % (max_degree + 1);
+            for (uint32_t d = 0; d < degree; d++) {
+                g.adj_indices.push_back(rng() % n);
+                g.adj_data.push_back((float)rng() / (float)(rng.max() / 10));
+            }
+            g.adj_indptr.push_back(g.adj_indices.size());
+        }
+    }
+    return graphs;
+}
+
+//----------------------------------------------------------------------------
+// Testbench
+//----------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    // parse arguments
+    if(argc < 2) {
+        std::cout << "Usage : " << argv[0] << " <xclbin path> [number of graphs]" << std::endl;
+        std::cout << "Aborting..." << std::endl;
+        return 1;
+    }
+    size_t num_graphs = (argc > 2) ? std::stoul(argv[2]) : 1000;
+
+    //--------------------------------------------------------------------
+    // generate graphs and input vectors
+    //--------------------------------------------------------------------
+    std::vector<CSRMatrix<float>> graphs = generate_graphs(num_graphs, 8, 64, 6);
+    PackedCSRMatrix<float> packed = pack_csr_matrices(graphs);
+    const CSRMatrix<float> &mat = packed.matrix;
+    xhl::aligned_vector<float> vector_in(mat.num_cols);
+    xhl::aligned_vector<float> vector_out(mat.num_rows);
+    std::generate(
+        vector_in.begin(),
+        vector_in.end(),
+        [&](){return (float)rand() / (float)(RAND_MAX/10);}
+    );
+    std::cout << "INFO : " << num_graphs << " graphs, " << mat.num_rows << " rows, "
+              << mat.adj_data.size() << " non-zeros in total" << std::endl;
+
+    //--------------------------------------------------------------------
+    // compute reference
+    //--------------------------------------------------------------------
+    std::vector<float> ref_result(mat.num_rows);
+    CPUSpMVEngine<float, SPMV_SEMIRING<float>> engine(mat);
+    engine.spmv(vector_in.data(), ref_result.data());
+    std::cout << "INFO : Compute reference complete!" << std::endl;
+
+    //--------------------------------------------------------------------
+    // Profiling Setup
+    //--------------------------------------------------------------------
+    TIMER_INIT(time);
+    Measure loop_time;
+    Measure packed_time;
+
+    //--------------------------------------------------------------------
+    // Compute Unit Setup
+    //--------------------------------------------------------------------
+    xhl::KernelSignature spmv = {
+        "spmv", {
+            {"values", "float*"},
+            {"col_idx", "unsigned*"},
+            {"row_ptr", "unsigned*"},
+            {"vector_in", "float*"},
+            {"vector_out", "float*"},
+            {"num_rows", "unsigned"},
+            {"num_cols", "unsigned"}
+        }
+    };
+    std::vector<xhl::Device> devices = xhl::find_devices(
+        xhl::boards::alveo::u280::identifier
+    );
+    xhl::Device device = devices[0];
+    device.program_device(argv[1]);
+
+    xhl::ComputeUnit* spmv_cu = device.find(spmv);
+    const int bank = xhl::boards::alveo::u280::HBM[0];
+
+    //--------------------------------------------------------------------
+    // one upload and one launch per graph
+    //--------------------------------------------------------------------
+    std::cout << "INFO : Per-graph loop" << std::endl;
+    xhl::aligned_vector<float> loop_out(mat.num_rows);
+    TIME_IT(time) {
+        for (size_t g = 0; g < num_graphs; g++) {
+            CSRMatrix<float> &graph = graphs[g];
+            ArrayView<float> in = packed_cols_view(packed, g, vector_in);
+            ArrayView<float> out = packed_rows_view(packed, g, loop_out);
+            device.create_buffer("values", graph.adj_data.size() * sizeof(float),
+                graph.adj_data.data(), xhl::BufferType::ReadOnly, bank);
+            device.create_buffer("col_idx", graph.adj_indices.size() * sizeof(unsigned),
+                graph.adj_indices.data(), xhl::BufferType::ReadOnly, bank);
+            device.create_buffer("row_ptr", graph.adj_indptr.size() * sizeof(unsigned),
+                graph.adj_indptr.data(), xhl::BufferType::ReadOnly, bank);
+            device.create_buffer("vector_in", in.size * sizeof(float), in.data,
+                xhl::BufferType::ReadOnly, bank);
+            device.create_buffer("vector_out", out.size * sizeof(float), out.data,
+                xhl::BufferType::WriteOnly, bank);
+            for (const char *name : {"values", "col_idx", "row_ptr", "vector_in"}) {
+                xhl::nb_sync_data_htod(&device, name);
+            }
+            spmv_cu->launch(
+                device.get_buffer("values"),
+                device.get_buffer("col_idx"),
+                device.get_buffer("row_ptr"),
+                device.get_buffer("vector_in"),
+                device.get_buffer("vector_out"),
+                graph.num_rows,
+                graph.num_cols
+            );
+            xhl::nb_sync_data_dtoh(&device, "vector_out");
+            device.finish_all_tasks();
+            for (const char *name : {"values", "col_idx", "row_ptr", "vector_in", "vector_out"}) {
+                device.release_buffer(name);
+            }
+        }
+    }
+    loop_time.addSample(time);
+
+    //--------------------------------------------------------------------
+    // all graphs packed: one upload and one launch
+    //--------------------------------------------------------------------
+    std::cout << "INFO : Packed batch" << std::endl;
+    TIME_IT(time) {
+        device.create_buffer("values", mat.adj_data.size() * sizeof(float),
+            const_cast<float*>(mat.adj_data.data()), xhl::BufferType::ReadOnly, bank);
+        device.create_buffer("col_idx", mat.adj_indices.size() * sizeof(unsigned),
+            const_cast<uint32_t*>(mat.adj_indices.data()), xhl::BufferType::ReadOnly, bank);
+        device.create_buffer("row_ptr", mat.adj_indptr.size() * sizeof(unsigned),
+            const_cast<uint32_t*>(mat.adj_indptr.data()), xhl::BufferType::ReadOnly, bank);
+        device.create_buffer("vector_in", vector_in.size() * sizeof(float), vector_in.data(),
+            xhl::BufferType::ReadOnly, bank);
+        device.create_buffer("vector_out", vector_out.size() * sizeof(float), vector_out.data(),
+            xhl::BufferType::WriteOnly, bank);
+        for (const char *name : {"values", "col_idx", "row_ptr", "vector_in"}) {
+            xhl::nb_sync_data_htod(&device, name);
+        }
+        spmv_cu->launch(
+            device.get_buffer("values"),
+            device.get_buffer("col_idx"),
+            device.get_buffer("row_ptr"),
+            device.get_buffer("vector_in"),
+            device.get_buffer("vector_out"),
+            mat.num_rows,
+            mat.num_cols
+        );
+        xhl::sync_data_dtoh(&device, "vector_out");
+    }
+    packed_time.addSample(time);
+
+    //--------------------------------------------------------------------
+    // compare result
+    //--------------------------------------------------------------------
+    // the result of graph g is read in place, e.g., packed_rows_view(packed, g, vector_out)
+    ValidationReport loop_report = validate_results(loop_out, ref_result);
+    ValidationReport packed_report = validate_results(vector_out, ref_result);
+    print_validation_report(std::cout, loop_report, loop_out.data(), ref_result.data());
+    print_validation_report(std::cout, packed_report, vector_out.data(), ref_result.data());
+    bool pass = loop_report.passed() && packed_report.passed();
+    std::cout << (pass ? "[INFO]: Test Passed !" : "[ERROR]: Test Failed!") << std::endl;
+    std::cout << "\t\tTotal\t\tAvg\t\tMin\t\tMax" << std::endl;
+    std::cout << "Per-graph:\t" << loop_time << std::endl;
+    std::cout << "Packed:\t\t" << packed_time << std::endl;
+    std::cout << "Per-graph:\t" << num_graphs / loop_time.total.count() << " graphs/s" << std::endl;
+    std::cout << "Packed:\t\t" << num_graphs / packed_time.total.count() << " graphs/s" << std::endl;
+
+    std::cout << "INFO : SpMV batch complete!" << std::endl;
+
+    delete spmv_cu;
+
+    return pass ? 0 : 1;
+}
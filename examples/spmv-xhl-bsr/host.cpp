@@ -0,0 +1,201 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+#include "xocl-host-lib.hpp"
+#include "device.hpp"
+#include "compute_unit.hpp"
+#include "sparse-io.hpp"
+#include "spmv-cpu.hpp"
+#include "bsr.hpp"
+#include "validate.hpp"
+
+#include "profiling-infra.h"
+
+#include "xcl2.hpp"
+
+// the semiring and the block size of the kernel, set by SEMIRING and BSR_BLOCK in the Makefile
+#ifndef SPMV_SEMIRING
+#define SPMV_SEMIRING PlusTimes
+#endif
+#ifndef BSR_BLOCK
+#define BSR_BLOCK 4
+#endif
+
+// the compute units and their HBM channels, as in spmv_bsr.link.config
+const int NUM_CUS = 4;
+const int MATRIX_BANK[NUM_CUS] = {0, 2, 4, 6};
+const int VECTOR_BANK[NUM_CUS] = {1, 3, 5, 7};
+
+//-----------------------------------------------------------------------------
+// upload helper: block row slice p goes to the channels of compute unit p
+//-----------------------------------------------------------------------------
+void upload_bsr_slices(
+    xhl::Device &device,
+    std::vector<BSRMatrix<float>> &slices,
+    std::vector<uint32_t> const &bounds,
+    xhl::aligned_vector<float> &vector_in,
+    xhl::aligned_vector<float> &vector_out
+) {
+    for (size_t p = 0; p < slices.size(); p++) {
+        BSRMatrix<float> &slice = slices[p];
+        const int matrix_bank = xhl::boards::alveo::u280::HBM[MATRIX_BANK[p]];
+        const int vector_bank = xhl::boards::alveo::u280::HBM[VECTOR_BANK[p]];
+        std::string id = std::to_string(p);
+        device.create_buffer("values_" + id, slice.adj_data.size() * sizeof(float),
+            slice.adj_data.data(), xhl::BufferType::ReadOnly, matrix_bank);
+        device.create_buffer("col_idx_" + id, slice.adj_indices.size() * sizeof(unsigned),
+            slice.adj_indices.data(), xhl::BufferType::ReadOnly, matrix_bank);
+        device.create_buffer("row_ptr_" + id, slice.adj_indptr.size() * sizeof(unsigned),
+            slice.adj_indptr.data(), xhl::BufferType::ReadOnly, matrix_bank);
+        // every compute unit reads the whole input vector from its own channel
+        device.create_buffer("vector_in_" + id, vector_in.size() * sizeof(float),
+            vector_in.data(), xhl::BufferType::ReadOnly, vector_bank);
+        device.create_buffer("vector_out_" + id, slice.num_rows * sizeof(float),
+            vector_out.data() + (size_t)bounds[p] * slice.block_size, xhl::BufferType::WriteOnly, vector_bank);
+        for (const char *name : {"values_", "col_idx_", "row_ptr_", "vector_in_"}) {
+            xhl::nb_sync_data_htod(&device, name + id);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Testbench
+//----------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    // parse arguments
+    if(argc < 3) {
+        std::cout << "Usage : " << argv[0] << " <xclbin path> <dataset path>" << std::endl;
+        std::cout << "Aborting..." << std::endl;
+        return 1;
+    }
+
+    //--------------------------------------------------------------------
+    // loading matrix data
+    //--------------------------------------------------------------------
+    std::cout << "INFO : Loading Dataset" << std::endl;
+    CSRMatrix<float> mat = load_csr_matrix_from_float_npz(argv[2]);
+    uint32_t detected = detect_bsr_block_size(mat);
+    if (detected != BSR_BLOCK) {
+        std::cout << "INFO : Detected block size " << detected << ", the kernel is built for "
+                  << BSR_BLOCK << " (set BSR_BLOCK in the Makefile)" << std::endl;
+    }
+    BSRMatrix<float> bsr = csr2bsr<float, SPMV_SEMIRING<float>>(mat, BSR_BLOCK);
+    std::vector<uint32_t> bounds = partition_bsr_block_rows(bsr, NUM_CUS);
+    std::vector<BSRMatrix<float>> slices;
+    for (int p = 0; p < NUM_CUS; p++) {
+        slices.push_back(slice_bsr_block_rows(bsr, bounds[p], bounds[p + 1]));
+    }
+    std::cout << "INFO : " << bsr.num_blocks() << " blocks of " << BSR_BLOCK << "x" << BSR_BLOCK
+              << ", fill ratio " << bsr_fill_ratio(bsr, mat.adj_data.size()) << std::endl;
+    std::cout << "INFO : Column indices " << mat.adj_indices.size() * sizeof(unsigned) << " bytes in csr, "
+              << bsr.adj_indices.size() * sizeof(unsigned) << " bytes in bsr" << std::endl;
+
+    //--------------------------------------------------------------------
+    // generate input vector
+    //--------------------------------------------------------------------
+    xhl::aligned_vector<float> vector_in(mat.num_cols);
+    xhl::aligned_vector<float> vector_out(mat.num_rows);
+    std::generate(
+        vector_in.begin(),
+        vector_in.end(),
+        [&](){return (float)rand() / (float)(RAND_MAX/10);}
+    );
+
+    //--------------------------------------------------------------------
+    // compute reference
+    //--------------------------------------------------------------------
+    std::vector<float> ref_result(mat.num_rows);
+    std::vector<float> bsr_result(mat.num_rows);
+    CPUSpMVEngine<float, SPMV_SEMIRING<float>> engine(mat);
+    engine.spmv(vector_in.data(), ref_result.data());
+    spmv_bsr_parallel<float, SPMV_SEMIRING<float>>(bsr, vector_in.data(), bsr_result.data());
+    std::cout << "INFO : Compute reference complete!" << std::endl;
+
+    //--------------------------------------------------------------------
+    // Profiling Setup
+    //--------------------------------------------------------------------
+    TIMER_INIT(time);
+    Measure upload_time;
+    Measure compute_time;
+
+    //--------------------------------------------------------------------
+    // Compute Unit Setup
+    //--------------------------------------------------------------------
+    std::vector<xhl::Device> devices = xhl::find_devices(
+        xhl::boards::alveo::u280::identifier
+    );
+    xhl::Device device = devices[0];
+    device.program_device(argv[1]);
+
+    std::vector<xhl::ComputeUnit*> spmv_cus;
+    for (int p = 0; p < NUM_CUS; p++) {
+        xhl::KernelSignature spmv_bsr = {
+            "spmv_bsr:{spmv_bsr_" + std::to_string(p + 1) + "}", {
+                {"values", "float*"},
+                {"col_idx", "unsigned*"},
+                {"row_ptr", "unsigned*"},
+                {"vector_in", "float*"},
+                {"vector_out", "float*"},
+                {"num_block_rows", "unsigned"},
+                {"num_rows", "unsigned"},
+                {"num_cols", "unsigned"}
+            }
+        };
+        spmv_cus.push_back(device.find(spmv_bsr));
+    }
+
+    TIME_IT(time) {
+        upload_bsr_slices(device, slices, bounds, vector_in, vector_out);
+        device.finish_all_tasks();
+    }
+    upload_time.addSample(time);
+
+    //--------------------------------------------------------------------
+    // run the compute units on their slices concurrently
+    //--------------------------------------------------------------------
+    TIME_IT(time) {
+        for (int p = 0; p < NUM_CUS; p++) {
+            std::string id = std::to_string(p);
+            spmv_cus[p]->launch(
+                device.get_buffer("values_" + id),
+                device.get_buffer("col_idx_" + id),
+                device.get_buffer("row_ptr_" + id),
+                device.get_buffer("vector_in_" + id),
+                device.get_buffer("vector_out_" + id),
+                slices[p].num_block_rows,
+                slices[p].num_rows,
+                slices[p].num_cols
+            );
+        }
+        for (int p = 0; p < NUM_CUS; p++) {
+            xhl::nb_sync_data_dtoh(&device, "vector_out_" + std::to_string(p));
+        }
+        device.finish_all_tasks();
+    }
+    compute_time.addSample(time);
+
+    //--------------------------------------------------------------------
+    // compare result
+    //--------------------------------------------------------------------
+    ValidationReport cpu_report = validate_results(bsr_result, ref_result);
+    ValidationReport report = validate_results(vector_out, ref_result);
+    print_validation_report(std::cout, cpu_report, bsr_result.data(), ref_result.data());
+    print_validation_report(std::cout, report, vector_out.data(), ref_result.data());
+    bool pass = cpu_report.passed() && report.passed();
+    std::cout << (pass ? "[INFO]: Test Passed !" : "[ERROR]: Test Failed!") << std::endl;
+    std::cout << "\t\tTotal\t\tAvg\t\tMin\t\tMax" << std::endl;
+    std::cout << "Upload:\t\t" << upload_time << std::endl;
+    std::cout << "Compute:\t" << compute_time << std::endl;
+
+    std::cout << "INFO : SpMV BSR complete!" << std::endl;
+
+    for (xhl::ComputeUnit *cu : spmv_cus) {
+        delete cu;
+    }
+
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+#include "semiring.hpp"
+
+// the semiring and the block size are picked at build time, e.g., -DSPMV_SEMIRING=MinPlus -DBSR_BLOCK=8
+#ifndef SPMV_SEMIRING
+#define SPMV_SEMIRING PlusTimes
+#endif
+#ifndef BSR_BLOCK
+#define BSR_BLOCK 4
+#endif
+
+const unsigned FPADD_LATENCY = 8;
+
+// A block row at a time: the block_size partial results stay in registers and every block costs
+// one column index and one burst of block_size * block_size values.
+template<typename semiring, unsigned block_size>
+void spmv_bsr_rows(
+    const float* values,
+    const unsigned* col_idx,
+    const unsigned* row_ptr,
+    float* vector_in,
+    float* vector_out,
+    const unsigned num_block_rows,
+    const unsigned num_rows,
+    const unsigned num_cols
+) {
+    for (unsigned block_row = 0; block_row < num_block_rows; block_row++) {
+        #pragma HLS pipeline off
+        unsigned start = row_ptr[block_row];
+        unsigned end = row_ptr[block_row + 1];
+
+        float res[block_size];
+        #pragma HLS array_partition variable=res complete
+        for (unsigned r = 0; r < block_size; r++) {
+            #pragma HLS unroll
+            res[r] = semiring::zero();
+        }
+        for (unsigned k = start; k < end; k++) {
+            #pragma HLS pipeline II=FPADD_LATENCY style=flp
+            unsigned col = col_idx[k] * block_size;
+            float x[block_size];
+            #pragma HLS array_partition variable=x complete
+            for (unsigned c = 0; c < block_size; c++) {
+                #pragma HLS unroll
+                // the last block column may reach beyond the vector, its values are zero()
+                x[c] = (col + c < num_cols) ? vector_in[col + c] : semiring::zero();
+            }
+            for (unsigned r = 0; r < block_size; r++) {
+                #pragma HLS unroll
+                for (unsigned c = 0; c < block_size; c++) {
+                    #pragma HLS unroll
+                    res[r] = semiring::add(res[r], semiring::mul(values[k * block_size * block_size + r * block_size + c], x[c]));
+                }
+            }
+        }
+
+        for (unsigned r = 0; r < block_size; r++) {
+            #pragma HLS pipeline II=1
+            if (block_row * block_size + r < num_rows) {
+                vector_out[block_row * block_size + r] = res[r];
+            }
+        }
+    }
+}
+
+extern "C"  void spmv_bsr (
+    const float* values,
+    const unsigned* col_idx,
+    const unsigned* row_ptr,
+    float* vector_in,
+    float* vector_out,
+
+    const unsigned num_block_rows,
+    const unsigned num_rows,
+    const unsigned num_cols
+) {
+    #pragma HLS interface m_axi port=values         offset=slave bundle=gmem_mat1
+    #pragma HLS interface m_axi port=col_idx        offset=slave bundle=gmem_mat2
+    #pragma HLS interface m_axi port=row_ptr        offset=slave bundle=gmem_mat3
+    #pragma HLS interface m_axi port=vector_in      offset=slave bundle=gmem_vec1
+    #pragma HLS interface m_axi port=vector_out     offset=slave bundle=gmem_vec2
+
+    spmv_bsr_rows<SPMV_SEMIRING<float>, BSR_BLOCK>(
+        values, col_idx, row_ptr, vector_in, vector_out, num_block_rows, num_rows, num_cols
+    );
+}
@@ -0,0 +1,233 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <random>
+
+#include "xocl-host-lib.hpp"
+#include "device.hpp"
+#include "compute_unit.hpp"
+#include "sparse-io.hpp"
+#include "spmv-cpu.hpp"
+#include "dynamic-csr.hpp"
+#include "validate.hpp"
+
+#include "profiling-infra.h"
+
+#include "xcl2.hpp"
+
+// the semiring of the kernel, set by SEMIRING in the Makefile
+#ifndef SPMV_SEMIRING
+#define SPMV_SEMIRING PlusTimes
+#endif
+
+using DynamicMatrix = DynamicCSRMatrix<float, SPMV_SEMIRING<float>>;
+
+//-----------------------------------------------------------------------------
+// device buffers of the slot arrays
+//-----------------------------------------------------------------------------
+void create_matrix_buffers(xhl::Device &device, DynamicMatrix const &dyn, int bank) {
+    CSRMatrix<float> const &slots = dyn.slots();
+    device.create_buffer("values", slots.adj_data.size() * sizeof(float),
+        const_cast<float*>(slots.adj_data.data()), xhl::BufferType::ReadOnly, bank);
+    device.create_buffer("col_idx", slots.adj_indices.size() * sizeof(unsigned),
+        const_cast<uint32_t*>(slots.adj_indices.data()), xhl::BufferType::ReadOnly, bank);
+    device.create_buffer("row_ptr", slots.adj_indptr.size() * sizeof(unsigned),
+        const_cast<uint32_t*>(slots.adj_indptr.data()), xhl::BufferType::ReadOnly, bank);
+}
+
+// after a merge, the slot arrays have new sizes and host pointers
+void rebind_matrix_buffers(xhl::Device &device, DynamicMatrix const &dyn) {
+    CSRMatrix<float> const &slots = dyn.slots();
+    device.rebind_buffer("values", slots.adj_data.size() * sizeof(float),
+        const_cast<float*>(slots.adj_data.data()));
+    device.rebind_buffer("col_idx", slots.adj_indices.size() * sizeof(unsigned),
+        const_cast<uint32_t*>(slots.adj_indices.data()));
+    device.rebind_buffer("row_ptr", slots.adj_indptr.size() * sizeof(unsigned),
+        const_cast<uint32_t*>(slots.adj_indptr.data()));
+}
+
+// after a merge, every slot and the row pointers changed: migrate the three arrays whole, returns
+// the number of bytes moved
+size_t upload_merged_matrix(xhl::Device &device, DynamicMatrix &dyn) {
+    CSRMatrix<float> const &slots = dyn.slots();
+    dyn.take_dirty_ranges();
+    xhl::nb_sync_data_htod(&device, "values");
+    xhl::nb_sync_data_htod(&device, "col_idx");
+    xhl::nb_sync_data_htod(&device, "row_ptr");
+    return slots.adj_data.size() * sizeof(float) + slots.adj_indices.size() * sizeof(unsigned)
+           + slots.adj_indptr.size() * sizeof(unsigned);
+}
+
+// migrate the slots changed since the last upload, returns the number of bytes moved
+size_t upload_dirty_slots(xhl::Device &device, DynamicMatrix &dyn) {
+    std::vector<xhl::ByteRange> data_ranges;
+    std::vector<xhl::ByteRange> index_ranges;
+    size_t bytes = 0;
+    for (auto const &range : dyn.take_dirty_ranges()) {
+        size_t n = range.second - range.first;
+        data_ranges.push_back({range.first * sizeof(float), n * sizeof(float)});
+        index_ranges.push_back({range.first * sizeof(unsigned), n * sizeof(unsigned)});
+        bytes += n * (sizeof(float) + sizeof(unsigned));
+    }
+    xhl::nb_sync_data_htod(&device, "values", data_ranges);
+    xhl::nb_sync_data_htod(&device, "col_idx", index_ranges);
+    return bytes;
+}
+
+//----------------------------------------------------------------------------
+// Testbench
+//----------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    // parse arguments
+    if(argc < 3) {
+        std::cout << "Usage : " << argv[0] << " <xclbin path> <dataset path> [update batches] [updates per batch]"
+                  << std::endl;
+        std::cout << "Aborting..." << std::endl;
+        return 1;
+    }
+    size_t num_batches = (argc > 3) ? std::stoul(argv[3]) : 100;
+    size_t batch_size = (argc > 4) ? std::stoul(argv[4]) : 1000;
+
+    //--------------------------------------------------------------------
+    // loading matrix data
+    //--------------------------------------------------------------------
+    std::cout << "INFO : Loading Dataset" << std::endl;
+    CSRMatrix<float> mat = load_csr_matrix_from_float_npz(argv[2]);
+    DynamicMatrix dyn(mat);
+
+    //--------------------------------------------------------------------
+    // generate input vector
+    //--------------------------------------------------------------------
+    xhl::aligned_vector<float> vector_in(mat.num_cols);
+    xhl::aligned_vector<float> vector_out(mat.num_rows);
+    std::generate(
+        vector_in.begin(),
+        vector_in.end(),
+        [&](){return (float)rand() / (float)(RAND_MAX/10);}
+    );
+
+    //--------------------------------------------------------------------
+    // Profiling Setup
+    //--------------------------------------------------------------------
+    TIMER_INIT(time);
+    Measure full_time;
+    Measure delta_time;
+    size_t delta_bytes = 0;
+    size_t num_merges = 0;
+
+    //--------------------------------------------------------------------
+    // Compute Unit Setup
+    //--------------------------------------------------------------------
+    xhl::KernelSignature spmv = {
+        "spmv", {
+            {"values", "float*"},
+            {"col_idx", "unsigned*"},
+            {"row_ptr", "unsigned*"},
+            {"vector_in", "float*"},
+            {"vector_out", "float*"},
+            {"num_rows", "unsigned"},
+            {"num_cols", "unsigned"}
+        }
+    };
+    std::vector<xhl::Device> devices = xhl::find_devices(
+        xhl::boards::alveo::u280::identifier
+    );
+    xhl::Device device = devices[0];
+    device.program_device(argv[1]);
+
+    xhl::ComputeUnit* spmv_cu = device.find(spmv);
+    const int bank = xhl::boards::alveo::u280::HBM[0];
+
+    create_matrix_buffers(device, dyn, bank);
+    device.create_buffer("vector_in", vector_in.size() * sizeof(float), vector_in.data(),
+        xhl::BufferType::ReadOnly, bank);
+    device.create_buffer("vector_out", vector_out.size() * sizeof(float), vector_out.data(),
+        xhl::BufferType::WriteOnly, bank);
+    xhl::sync_data_htod(&device, "vector_in");
+
+    auto run_spmv = [&]() {
+        spmv_cu->launch(
+            device.get_buffer("values"),
+            device.get_buffer("col_idx"),
+            device.get_buffer("row_ptr"),
+            device.get_buffer("vector_in"),
+            device.get_buffer("vector_out"),
+            dyn.slots().num_rows,
+            dyn.slots().num_cols
+        );
+        xhl::sync_data_dtoh(&device, "vector_out");
+        dyn.spmv_overlay(vector_in.data(), vector_out.data());
+    };
+
+    //--------------------------------------------------------------------
+    // baseline: upload the whole matrix for a result
+    //--------------------------------------------------------------------
+    std::cout << "INFO : Full upload" << std::endl;
+    dyn.take_dirty_ranges();
+    for (size_t i = 0; i < 3; i++) {
+        TIME_IT(time) {
+            xhl::nb_sync_data_htod(&device, "values");
+            xhl::nb_sync_data_htod(&device, "col_idx");
+            xhl::nb_sync_data_htod(&device, "row_ptr");
+            run_spmv();
+        }
+        full_time.addSample(time);
+    }
+
+    //--------------------------------------------------------------------
+    // stream of edge updates, only the changed slots are uploaded
+    //--------------------------------------------------------------------
+    std::cout << "INFO : " << num_batches << " batches of " << batch_size << " edge updates" << std::endl;
+    std::mt19937 rng(42);
+    for (size_t b = 0; b < num_batches; b++) {
+        for (size_t u = 0; u < batch_size; u++) {
+            uint32_t row = rng() % mat.num_rows;
+            uint32_t col = rng() % mat.num_cols;
+            if (rng() % 4 == 0) {
+                dyn.remove_edge(row, col);
+            } else {
+                dyn.insert_edge(row, col, (float)rng() / (float)(rng.max() / 10));
+            }
+        }
+        TIME_IT(time) {
+            if (dyn.poll_merge()) {
+                rebind_matrix_buffers(device, dyn);
+                delta_bytes += upload_merged_matrix(device, dyn);
+                num_merges++;
+            } else {
+                delta_bytes += upload_dirty_slots(device, dyn);
+            }
+            run_spmv();
+        }
+        delta_time.addSample(time);
+        if (dyn.needs_merge()) {
+            dyn.start_merge();
+        }
+    }
+
+    //--------------------------------------------------------------------
+    // compare result
+    //--------------------------------------------------------------------
+    std::vector<float> ref_result(mat.num_rows);
+    CSRMatrix<float> current = dyn.to_csr();
+    CPUSpMVEngine<float, SPMV_SEMIRING<float>> engine(current);
+    engine.spmv(vector_in.data(), ref_result.data());
+    ValidationReport report = validate_results(vector_out, ref_result);
+    print_validation_report(std::cout, report, vector_out.data(), ref_result.data());
+    bool pass = report.passed();
+    std::cout << (pass ? "[INFO]: Test Passed !" : "[ERROR]: Test Failed!") << std::endl;
+    std::cout << "\t\tTotal\t\tAvg\t\tMin\t\tMax" << std::endl;
+    std::cout << "Full upload:\t" << full_time << std::endl;
+    std::cout << "Delta upload:\t" << delta_time << std::endl;
+    std::cout << "INFO : " << delta_bytes / std::max<size_t>(num_batches, 1) << " bytes uploaded per batch, "
+              << num_merges << " merges, " << dyn.overlay_size() << " overlay edges" << std::endl;
+
+    std::cout << "INFO : SpMV dynamic graph complete!" << std::endl;
+
+    delete spmv_cu;
+
+    return pass ? 0 : 1;
+}
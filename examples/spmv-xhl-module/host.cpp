@@ -0,0 +1,113 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <algorithm>
+#include <cstdlib>   // For rand() function
+
+#include "xocl-host-lib.hpp"
+#include "device.hpp"
+#include "compute_unit.hpp"
+#include "sparse-io.hpp"
+#include "spmv-cpu.hpp"
+#include "validate.hpp"
+#include "module_spmv.hpp"
+
+#include "profiling-infra.h"
+
+#include "xcl2.hpp"
+
+// the semiring of the kernel, set by SEMIRING in the Makefile
+#ifndef SPMV_SEMIRING
+#define SPMV_SEMIRING PlusTimes
+#endif
+
+//----------------------------------------------------------------------------
+// Testbench
+//----------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    const int N = 8;
+    // parse arguments
+    if(argc < 3) {
+        std::cout << "Usage : " << argv[0] << " <xclbin path> <dataset path> [initial cpu fraction]" << std::endl;
+        std::cout << "Aborting..." << std::endl;
+        return 1;
+    }
+    double cpu_fraction = (argc > 3) ? std::stod(argv[3]) : 0.2;
+
+    //--------------------------------------------------------------------
+    // loading matrix data
+    //--------------------------------------------------------------------
+    std::cout << "INFO : Loading Dataset" << std::endl;
+    CSRMatrix<float> mat = load_csr_matrix_from_float_npz(argv[2]);
+
+    //--------------------------------------------------------------------
+    // generate input vector
+    //--------------------------------------------------------------------
+    xhl::aligned_vector<float> vector_in(mat.num_cols);
+    xhl::aligned_vector<float> vector_out(mat.num_rows);
+    std::generate(
+        vector_in.begin(),
+        vector_in.end(),
+        [&](){return (float)rand() / (float)(RAND_MAX/10);}
+    );
+
+    //--------------------------------------------------------------------
+    // compute reference
+    //--------------------------------------------------------------------
+    CPUSpMVEngine<float, SPMV_SEMIRING<float>> engine(mat);
+    std::vector<float> ref_result(vector_in.begin(), vector_in.end());
+    std::vector<float> scratch(mat.num_rows);
+    if (engine.iterate(ref_result.data(), scratch.data(), N) != ref_result.data()) {
+        ref_result.swap(scratch);
+    }
+    std::cout << "INFO : Compute reference complete!" << std::endl;
+
+    //--------------------------------------------------------------------
+    // Profiling Setup
+    //--------------------------------------------------------------------
+    TIMER_INIT(time);
+    Measure compute_time;
+
+    //--------------------------------------------------------------------
+    // Module Setup
+    //--------------------------------------------------------------------
+    std::cout << "INFO : CPU+FPGA SpMV " << N << " Iterations Test" << std::endl;
+    std::vector<xhl::Device> devices = xhl::find_devices(
+        xhl::boards::alveo::u280::identifier
+    );
+    devices[0].program_device(argv[1]);
+
+    xhl::Module_spmv<SPMV_SEMIRING<float>> module(cpu_fraction);
+    module.initialize(devices);
+    module.load_matrix(mat);
+
+    // the two vectors alternate as input and output, each stays bound to its device buffer
+    for (int i = 0; i < N; i++) {
+        TIME_IT(time) {
+            module.run((i % 2) ? vector_out : vector_in, (i % 2) ? vector_in : vector_out);
+        }
+        compute_time.addSample(time);
+        std::cout << "Iteration " << i << ": CPU rows from " << module.split_row()
+                  << ", next CPU share " << module.cpu_fraction() << std::endl;
+    }
+    // an even number of iterations ends in vector_in
+    if (N % 2 == 0) {
+        std::copy(vector_in.begin(), vector_in.end(), vector_out.begin());
+    }
+
+    //--------------------------------------------------------------------
+    // compare result
+    //--------------------------------------------------------------------
+    ValidationReport report = validate_results(vector_out, ref_result);
+    print_validation_report(std::cout, report, vector_out.data(), ref_result.data());
+    bool pass = report.passed();
+    std::cout << (pass ? "[INFO]: Test Passed !" : "[ERROR]: Test Failed!") << std::endl;
+    std::cout << "\t\tTotal\t\tAvg\t\tMin\t\tMax" << std::endl;
+    std::cout << "Compute:\t" << compute_time << std::endl;
+
+    std::cout << "INFO : SpMV module complete!" << std::endl;
+
+    return pass ? 0 : 1;
+}
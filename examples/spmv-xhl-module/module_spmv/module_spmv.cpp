@@ -0,0 +1,212 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+#include "xocl-host-lib.hpp"
+#include "device.hpp"
+#include "compute_unit.hpp"
+#include "placement.hpp"
+#include "spmv-cpu.hpp"
+#include "module_spmv.hpp"
+
+namespace xhl{
+
+// the device part ends on a page boundary of vector_out so it can be read back as a sub-buffer
+const uint32_t SPLIT_ALIGNMENT = 4096 / sizeof(float);
+// weight of the latest measurement in the throughput estimates
+const double RATE_SMOOTHING = 0.5;
+// the two vector buffers, each one is the input or the output of a run
+const char *const VECTOR_BUFFERS[] = {"vector_0", "vector_1"};
+
+template<typename semiring>
+Module_spmv<semiring>::Module_spmv(double cpu_fraction, unsigned num_threads)
+    : spmv_cu(nullptr), _mat(nullptr), _cpu_fraction(cpu_fraction), _num_threads(num_threads),
+      _split_row(0), _cpu_rate(0), _device_rate(0) {}
+
+template<typename semiring>
+void Module_spmv<semiring>::initialize(std::vector<Device>& devices) {
+    this->spmv_cu = devices[0].find(this->spmv);
+}
+
+template<typename semiring>
+void Module_spmv<semiring>::free_cu(){
+    delete this->spmv_cu;
+    this->spmv_cu = nullptr;
+}
+
+template<typename semiring>
+Module_spmv<semiring>::~Module_spmv(){
+    this->free_cu();
+}
+
+template<typename semiring>
+void Module_spmv<semiring>::load_matrix(const CSRMatrix<float> &mat) {
+    auto device_1 = this->spmv_cu->cu_device;
+    this->_mat = &mat;
+    this->_cpu_rate = 0;
+    this->_device_rate = 0;
+
+    // the kernel takes unsigned indices, which match the uint32_t of CSRMatrix
+    const size_t nnz = mat.adj_data.size();
+    const std::vector<int> spmv_banks = {0, 1, 2, 3, 4, 5, 6, 7};
+    PlacementPlanner planner(boards::alveo::u280::HBM, 32, boards::alveo::u280::HBM_CHANNEL_SIZE);
+    planner.add_buffer({"values", nnz * sizeof(float), (double)nnz, spmv_banks});
+    planner.add_buffer({"col_idx", nnz * sizeof(unsigned), (double)nnz, spmv_banks});
+    planner.add_buffer({"row_ptr", (mat.num_rows + 1) * sizeof(unsigned), (double)mat.num_rows, spmv_banks});
+    // either vector buffer may hold an input or an output
+    size_t vector_size = std::max(mat.num_rows, mat.num_cols) * sizeof(float);
+    for (const char *name : VECTOR_BUFFERS) {
+        planner.add_buffer({name, vector_size, (double)std::max<size_t>(nnz, mat.num_rows), spmv_banks});
+    }
+    this->_placement = planner.plan();
+    // the kernel takes each array as one pointer, a split buffer would leave it incomplete
+    for (auto &placement : this->_placement) {
+        if (placement.second.segments.size() > 1) {
+            throw std::runtime_error(
+                "Buffer " + placement.first + " does not fit in one HBM channel"
+            );
+        }
+    }
+
+    for (const char *name : {"values", "col_idx", "row_ptr", "vector_0", "vector_1"}) {
+        if (device_1->contains_buffer(name)) device_1->release_buffer(name);
+    }
+    // matrix arrays are ReadOnly for the device, it never writes through these pointers
+    create_placed_buffer(device_1, this->_placement["values"],
+        const_cast<float*>(mat.adj_data.data()), BufferType::ReadOnly);
+    create_placed_buffer(device_1, this->_placement["col_idx"],
+        const_cast<uint32_t*>(mat.adj_indices.data()), BufferType::ReadOnly);
+    create_placed_buffer(device_1, this->_placement["row_ptr"],
+        const_cast<uint32_t*>(mat.adj_indptr.data()), BufferType::ReadOnly);
+    nb_sync_data_htod(device_1, "values");
+    nb_sync_data_htod(device_1, "col_idx");
+    nb_sync_data_htod(device_1, "row_ptr");
+}
+
+template<typename semiring>
+std::string Module_spmv<semiring>::_bind_vector(aligned_vector<float> &v, const std::string &other) {
+    auto device_1 = this->spmv_cu->cu_device;
+    size_t size = v.size() * sizeof(float);
+    // a vector keeps the buffer it is bound to
+    for (const char *name : VECTOR_BUFFERS) {
+        if (name != other && device_1->contains_buffer(name)
+            && device_1->host_ptr(name) == v.data() && device_1->buffer_size(name) == size) {
+            return name;
+        }
+    }
+    // otherwise it takes the buffer the other vector of the run does not use
+    std::string name = (other == VECTOR_BUFFERS[0]) ? VECTOR_BUFFERS[1] : VECTOR_BUFFERS[0];
+    if (!device_1->contains_buffer(name)) {
+        BufferPlacement placement = this->_placement[name];
+        placement.segments[0].size = size;
+        create_placed_buffer(device_1, placement, v.data(), BufferType::ReadWrite);
+    } else {
+        device_1->rebind_buffer(name, size, v.data());
+    }
+    return name;
+}
+
+template<typename semiring>
+uint32_t Module_spmv<semiring>::_pick_split() const {
+    const CSRMatrix<float> &mat = *this->_mat;
+    double fraction = std::min(1.0, std::max(0.0, this->_cpu_fraction));
+    // the device takes the rows holding the first (1 - fraction) of the non-zeros
+    uint64_t target = (uint64_t)((1.0 - fraction) * mat.adj_indptr[mat.num_rows]);
+    uint32_t row = std::upper_bound(mat.adj_indptr.begin(), mat.adj_indptr.end(), target)
+        - mat.adj_indptr.begin() - 1;
+    row = row / SPLIT_ALIGNMENT * SPLIT_ALIGNMENT;
+    return std::min(row, mat.num_rows);
+}
+
+template<typename semiring>
+void Module_spmv<semiring>::run(
+    aligned_vector<float> &vector_in,
+    aligned_vector<float> &vector_out
+) {
+    if (this->_mat == nullptr) {
+        throw std::runtime_error("No matrix loaded, call load_matrix first");
+    }
+    const CSRMatrix<float> &mat = *this->_mat;
+    auto device_1 = this->spmv_cu->cu_device;
+    std::string in = this->_bind_vector(vector_in, "");
+    std::string out = this->_bind_vector(vector_out, in);
+
+    uint32_t split = this->_pick_split();
+    this->_split_row = split;
+
+    // device rows [0, split): the kernel stops at its num_rows argument
+    cl::Event kernel;
+    if (split > 0) {
+        nb_sync_data_htod(device_1, in);
+        kernel = this->spmv_cu->launch(
+            device_1->get_buffer("values"),
+            device_1->get_buffer("col_idx"),
+            device_1->get_buffer("row_ptr"),
+            device_1->get_buffer(in),
+            device_1->get_buffer(out),
+            split,
+            mat.num_cols
+        );
+    }
+
+    // CPU rows [split, num_rows) while the kernel runs, written in place into vector_out
+    auto cpu_start = std::chrono::high_resolution_clock::now();
+    spmv_cpu_parallel<float, semiring>(mat, vector_in.data(), vector_out.data(), split, mat.num_rows, this->_num_threads);
+    std::chrono::duration<double> cpu_time = std::chrono::high_resolution_clock::now() - cpu_start;
+
+    if (split > 0) {
+        // read back only the device rows, so the CPU rows in vector_out are not overwritten
+        cl_buffer_region region = {0, split * sizeof(float)};
+        cl_int err = 0;
+        cl::Buffer device_rows = device_1->get_buffer(out).createSubBuffer(
+            CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION, &region, &err
+        );
+        if (err != CL_SUCCESS) {
+            throw std::runtime_error(
+                "Failed to create sub-buffer for device rows (code:" + std::to_string(err) + ")"
+            );
+        }
+        kernel.wait();
+        sync_data_dtoh(device_1, device_rows);
+    }
+
+    // retune the split from the non-zeros each side processed per second
+    uint64_t device_nnz = mat.adj_indptr[split];
+    uint64_t cpu_nnz = mat.adj_indptr[mat.num_rows] - device_nnz;
+    if (cpu_nnz > 0 && cpu_time.count() > 0) {
+        double rate = cpu_nnz / cpu_time.count();
+        this->_cpu_rate = (this->_cpu_rate == 0) ? rate
+            : RATE_SMOOTHING * rate + (1 - RATE_SMOOTHING) * this->_cpu_rate;
+    }
+    if (device_nnz > 0) {
+        cl_ulong start = kernel.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+        cl_ulong end = kernel.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+        if (end > start) {
+            double rate = device_nnz / ((end - start) * 1e-9);
+            this->_device_rate = (this->_device_rate == 0) ? rate
+                : RATE_SMOOTHING * rate + (1 - RATE_SMOOTHING) * this->_device_rate;
+        }
+    }
+    if (this->_cpu_rate > 0 && this->_device_rate > 0) {
+        this->_cpu_fraction = this->_cpu_rate / (this->_cpu_rate + this->_device_rate);
+    }
+}
+
+template<typename semiring>
+double Module_spmv<semiring>::cpu_fraction() const {
+    return this->_cpu_fraction;
+}
+
+template<typename semiring>
+uint32_t Module_spmv<semiring>::split_row() const {
+    return this->_split_row;
+}
+
+// the semirings of semiring.hpp
+template class Module_spmv<PlusTimes<float>>;
+template class Module_spmv<MinPlus<float>>;
+template class Module_spmv<OrAnd<float>>;
+
+} // namespace xhl
@@ -0,0 +1,101 @@
+#ifndef MODULE_SPMV_HPP
+#define MODULE_SPMV_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+
+#include "xocl-host-lib.hpp"
+#include "compute_unit.hpp"
+#include "module.hpp"
+#include "device.hpp"
+#include "placement.hpp"
+#include "sparse-io.hpp"
+#include "semiring.hpp"
+
+namespace xhl{
+/**
+ * @brief SpMV co-executed on the FPGA and the host cores. The first rows of
+ * each product run on the device, the remaining rows on the CPU, and the
+ * split is tuned after every run from the measured throughput of each side.
+ *
+ * @tparam semiring the semiring of the product (see semiring.hpp), it must
+ * match the one the spmv kernel was built with
+ */
+template<typename semiring = PlusTimes<float>>
+class Module_spmv : public xhl::Module {
+    public:
+    ComputeUnit* spmv_cu;
+
+    const KernelSignature spmv = {
+        "spmv", {
+            {"values", "float*"},
+            {"col_idx", "unsigned*"},
+            {"row_ptr", "unsigned*"},
+            {"vector_in", "float*"},
+            {"vector_out", "float*"},
+            {"num_rows", "unsigned"},
+            {"num_cols", "unsigned"}
+        }
+    };
+
+    /**
+     * @brief constructor
+     *
+     * @param cpu_fraction the initial share of non-zeros computed on the CPU
+     * @param num_threads the number of CPU threads, 0 means all cores
+     */
+    Module_spmv(double cpu_fraction = 0.2, unsigned num_threads = 0);
+
+    void initialize(std::vector<Device>& devices) override;
+
+    void free_cu() override;
+
+    ~Module_spmv();
+
+    /**
+     * @brief upload the matrix, it stays resident on the device for all runs
+     *
+     * @param mat the matrix, must outlive the module
+     */
+    void load_matrix(const CSRMatrix<float> &mat);
+
+    /**
+     * @brief vector_out = mat * vector_in. The device writes its rows straight
+     * into vector_out, so both vectors must be 4KB aligned. The module keeps two
+     * vector buffers on the device, each bound to one host vector: iterations
+     * that alternate two vectors as input and output rebind nothing.
+     *
+     * @param vector_in the input vector, num_cols entries
+     * @param vector_out the output vector, num_rows entries
+     */
+    void run(
+        aligned_vector<float> &vector_in,
+        aligned_vector<float> &vector_out
+    );
+
+    /**
+     * @brief get the share of non-zeros the next run computes on the CPU
+     */
+    double cpu_fraction() const;
+
+    /**
+     * @brief get the first row computed on the CPU in the last run
+     */
+    uint32_t split_row() const;
+
+    private:
+    const CSRMatrix<float> *_mat;
+    std::map<std::string, BufferPlacement> _placement;
+    double _cpu_fraction;
+    unsigned _num_threads;
+    uint32_t _split_row;
+    double _cpu_rate; // non-zeros per second, 0 until measured
+    double _device_rate; // non-zeros per second, 0 until measured
+
+    uint32_t _pick_split() const;
+    std::string _bind_vector(aligned_vector<float> &v, const std::string &other);
+};
+} // namespace xhl
+#endif // MODULE_SPMV_HPP
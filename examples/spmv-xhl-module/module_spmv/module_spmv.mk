@@ -0,0 +1,2 @@
+module_spmv_CXXFLAGS += -I$(XOCL_HOST_LIB)/examples/spmv-xhl-module/module_spmv
+module_spmv_SRCS += $(XOCL_HOST_LIB)/examples/spmv-xhl-module/module_spmv/module_spmv.cpp
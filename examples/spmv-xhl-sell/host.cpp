@@ -0,0 +1,151 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+#include "xocl-host-lib.hpp"
+#include "device.hpp"
+#include "compute_unit.hpp"
+#include "sparse-io.hpp"
+#include "spmv-cpu.hpp"
+#include "sell.hpp"
+#include "validate.hpp"
+
+#include "profiling-infra.h"
+
+#include "xcl2.hpp"
+
+// the semiring and the chunk size of the kernel, set by SEMIRING and SELL_C in the Makefile
+#ifndef SPMV_SEMIRING
+#define SPMV_SEMIRING PlusTimes
+#endif
+#ifndef SELL_C
+#define SELL_C 8
+#endif
+
+//----------------------------------------------------------------------------
+// Testbench
+//----------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    // parse arguments
+    if(argc < 3) {
+        std::cout << "Usage : " << argv[0] << " <xclbin path> <dataset path> [sigma]" << std::endl;
+        std::cout << "Aborting..." << std::endl;
+        return 1;
+    }
+    uint32_t sigma = (argc > 3) ? std::stoul(argv[3]) : 128 * SELL_C;
+
+    //--------------------------------------------------------------------
+    // loading matrix data
+    //--------------------------------------------------------------------
+    std::cout << "INFO : Loading Dataset" << std::endl;
+    CSRMatrix<float> mat = load_csr_matrix_from_float_npz(argv[2]);
+    for (uint32_t s : {1u, 16u * SELL_C, sigma, mat.num_rows / SELL_C * SELL_C + SELL_C}) {
+        print_sell_padding_report(std::cout, sell_padding_report(mat, SELL_C, s));
+    }
+    SELLMatrix<float> sell = csr2sell<float, SPMV_SEMIRING<float>>(mat, SELL_C, sigma);
+
+    //--------------------------------------------------------------------
+    // generate input vector
+    //--------------------------------------------------------------------
+    xhl::aligned_vector<float> vector_in(mat.num_cols);
+    xhl::aligned_vector<float> vector_out(mat.num_rows);
+    std::generate(
+        vector_in.begin(),
+        vector_in.end(),
+        [&](){return (float)rand() / (float)(RAND_MAX/10);}
+    );
+
+    //--------------------------------------------------------------------
+    // compute reference
+    //--------------------------------------------------------------------
+    std::vector<float> ref_result(mat.num_rows);
+    std::vector<float> sell_result(mat.num_rows);
+    CPUSpMVEngine<float, SPMV_SEMIRING<float>> engine(mat);
+    engine.spmv(vector_in.data(), ref_result.data());
+    spmv_sell_parallel<float, SPMV_SEMIRING<float>>(sell, vector_in.data(), sell_result.data());
+    std::cout << "INFO : Compute reference complete!" << std::endl;
+
+    //--------------------------------------------------------------------
+    // Profiling Setup
+    //--------------------------------------------------------------------
+    TIMER_INIT(time);
+    Measure compute_time;
+
+    //--------------------------------------------------------------------
+    // Compute Unit Setup
+    //--------------------------------------------------------------------
+    xhl::KernelSignature spmv_sell = {
+        "spmv_sell", {
+            {"values", "float*"},
+            {"col_idx", "unsigned*"},
+            {"chunk_ptr", "unsigned*"},
+            {"row_perm", "unsigned*"},
+            {"vector_in", "float*"},
+            {"vector_out", "float*"},
+            {"num_chunks", "unsigned"},
+            {"num_rows", "unsigned"}
+        }
+    };
+    std::vector<xhl::Device> devices = xhl::find_devices(
+        xhl::boards::alveo::u280::identifier
+    );
+    xhl::Device device = devices[0];
+    device.program_device(argv[1]);
+
+    xhl::ComputeUnit* spmv_cu = device.find(spmv_sell);
+    const int bank = xhl::boards::alveo::u280::HBM[0];
+
+    device.create_buffer("values", sell.adj_data.size() * sizeof(float),
+        sell.adj_data.data(), xhl::BufferType::ReadOnly, bank);
+    device.create_buffer("col_idx", sell.adj_indices.size() * sizeof(unsigned),
+        sell.adj_indices.data(), xhl::BufferType::ReadOnly, bank);
+    device.create_buffer("chunk_ptr", sell.chunk_ptr.size() * sizeof(unsigned),
+        sell.chunk_ptr.data(), xhl::BufferType::ReadOnly, bank);
+    device.create_buffer("row_perm", sell.row_perm.size() * sizeof(unsigned),
+        sell.row_perm.data(), xhl::BufferType::ReadOnly, bank);
+    device.create_buffer("vector_in", vector_in.size() * sizeof(float),
+        vector_in.data(), xhl::BufferType::ReadOnly, bank);
+    device.create_buffer("vector_out", vector_out.size() * sizeof(float),
+        vector_out.data(), xhl::BufferType::WriteOnly, bank);
+    for (const char *name : {"values", "col_idx", "chunk_ptr", "row_perm", "vector_in"}) {
+        xhl::nb_sync_data_htod(&device, name);
+    }
+    device.finish_all_tasks();
+
+    TIME_IT(time) {
+        spmv_cu->launch(
+            device.get_buffer("values"),
+            device.get_buffer("col_idx"),
+            device.get_buffer("chunk_ptr"),
+            device.get_buffer("row_perm"),
+            device.get_buffer("vector_in"),
+            device.get_buffer("vector_out"),
+            sell.num_chunks(),
+            sell.num_rows
+        );
+        device.finish_all_tasks();
+    }
+    compute_time.addSample(time);
+    xhl::sync_data_dtoh(&device, "vector_out");
+
+    //--------------------------------------------------------------------
+    // compare result
+    //--------------------------------------------------------------------
+    ValidationReport cpu_report = validate_results(sell_result, ref_result);
+    ValidationReport report = validate_results(vector_out, ref_result);
+    print_validation_report(std::cout, cpu_report, sell_result.data(), ref_result.data());
+    print_validation_report(std::cout, report, vector_out.data(), ref_result.data());
+    bool pass = cpu_report.passed() && report.passed();
+    std::cout << (pass ? "[INFO]: Test Passed !" : "[ERROR]: Test Failed!") << std::endl;
+    std::cout << "\t\tTotal\t\tAvg\t\tMin\t\tMax" << std::endl;
+    std::cout << "Compute:\t" << compute_time << std::endl;
+
+    std::cout << "INFO : SpMV SELL complete!" << std::endl;
+
+    delete spmv_cu;
+
+    return pass ? 0 : 1;
+}
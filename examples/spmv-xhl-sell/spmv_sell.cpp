@@ -0,0 +1,77 @@
+#include "semiring.hpp"
+
+// the semiring and the chunk size are picked at build time, e.g., -DSPMV_SEMIRING=MinPlus -DSELL_C=16
+#ifndef SPMV_SEMIRING
+#define SPMV_SEMIRING PlusTimes
+#endif
+#ifndef SELL_C
+#define SELL_C 8
+#endif
+
+const unsigned FPADD_LATENCY = 8;
+
+// A chunk at a time: its chunk_size rows advance together, one column-major run of chunk_size
+// entries per iteration, so every iteration is a full-width burst with no end-of-row check.
+template<typename semiring, unsigned chunk_size>
+void spmv_sell_chunks(
+    const float* values,
+    const unsigned* col_idx,
+    const unsigned* chunk_ptr,
+    const unsigned* row_perm,
+    float* vector_in,
+    float* vector_out,
+    const unsigned num_chunks,
+    const unsigned num_rows
+) {
+    for (unsigned chunk = 0; chunk < num_chunks; chunk++) {
+        #pragma HLS pipeline off
+        unsigned start = chunk_ptr[chunk];
+        unsigned width = (chunk_ptr[chunk + 1] - start) / chunk_size;
+
+        float res[chunk_size];
+        #pragma HLS array_partition variable=res complete
+        for (unsigned l = 0; l < chunk_size; l++) {
+            #pragma HLS unroll
+            res[l] = semiring::zero();
+        }
+        for (unsigned j = 0; j < width; j++) {
+            #pragma HLS pipeline II=FPADD_LATENCY style=flp
+            for (unsigned l = 0; l < chunk_size; l++) {
+                #pragma HLS unroll
+                unsigned i = start + j * chunk_size + l;
+                res[l] = semiring::add(res[l], semiring::mul(values[i], vector_in[col_idx[i]]));
+            }
+        }
+
+        for (unsigned l = 0; l < chunk_size; l++) {
+            #pragma HLS pipeline II=1
+            unsigned row = row_perm[chunk * chunk_size + l];
+            if (row < num_rows) {
+                vector_out[row] = res[l];
+            }
+        }
+    }
+}
+
+extern "C"  void spmv_sell (
+    const float* values,
+    const unsigned* col_idx,
+    const unsigned* chunk_ptr,
+    const unsigned* row_perm,
+    float* vector_in,
+    float* vector_out,
+
+    const unsigned num_chunks,
+    const unsigned num_rows
+) {
+    #pragma HLS interface m_axi port=values         offset=slave bundle=gmem_mat1
+    #pragma HLS interface m_axi port=col_idx        offset=slave bundle=gmem_mat2
+    #pragma HLS interface m_axi port=chunk_ptr      offset=slave bundle=gmem_mat3
+    #pragma HLS interface m_axi port=row_perm       offset=slave bundle=gmem_mat3
+    #pragma HLS interface m_axi port=vector_in      offset=slave bundle=gmem_vec1
+    #pragma HLS interface m_axi port=vector_out     offset=slave bundle=gmem_vec2
+
+    spmv_sell_chunks<SPMV_SEMIRING<float>, SELL_C>(
+        values, col_idx, chunk_ptr, row_perm, vector_in, vector_out, num_chunks, num_rows
+    );
+}
@@ -0,0 +1,218 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+#include "xocl-host-lib.hpp"
+#include "device.hpp"
+#include "compute_unit.hpp"
+#include "sparse-io.hpp"
+#include "spmv-cpu.hpp"
+#include "csr-partition.hpp"
+#include "row-split.hpp"
+#include "validate.hpp"
+
+#include "profiling-infra.h"
+
+#include "xcl2.hpp"
+
+// the semiring of the kernel, set by SEMIRING in the Makefile
+#ifndef SPMV_SEMIRING
+#define SPMV_SEMIRING PlusTimes
+#endif
+
+// the compute units and their HBM channels, as in spmv.link.config
+const int NUM_CUS = 4;
+const int MATRIX_BANK[NUM_CUS] = {0, 2, 4, 6};
+const int VECTOR_BANK[NUM_CUS] = {1, 3, 5, 7};
+
+//-----------------------------------------------------------------------------
+// ground true data
+//-----------------------------------------------------------------------------
+void compute_ref(
+    CSRMatrix<float> &mat,
+    xhl::aligned_vector<float> &vector,
+    std::vector<float> &ref_result,
+    size_t iterations
+) {
+    CPUSpMVEngine<float, SPMV_SEMIRING<float>> engine(mat);
+    ref_result.assign(vector.begin(), vector.end());
+    std::vector<float> scratch(mat.num_rows);
+    float *result = engine.iterate(ref_result.data(), scratch.data(), iterations);
+    if (result != ref_result.data()) ref_result.swap(scratch);
+}
+
+//----------------------------------------------------------------------------
+// Testbench
+//----------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    const int N = 3;
+    // parse arguments
+    if(argc < 3) {
+        std::cout << "Usage : " << argv[0] << " <xclbin path> <dataset path> [max segment nnz]" << std::endl;
+        std::cout << "Aborting..." << std::endl;
+        return 1;
+    }
+
+    //--------------------------------------------------------------------
+    // loading matrix data, split the heavy rows and spread the segments
+    //--------------------------------------------------------------------
+    std::cout << "INFO : Loading Dataset" << std::endl;
+    CSRMatrix<float> mat = load_csr_matrix_from_float_npz(argv[2]);
+    uint32_t max_segment = (argc > 3) ? std::stoul(argv[3]) : default_split_threshold(mat, NUM_CUS);
+    SplitCSRMatrix<float> split = split_heavy_rows(mat, max_segment);
+    std::vector<CSRRowPartition<float>> parts = partition_csr_rows_by_nnz(split.segments, NUM_CUS);
+    std::cout << "INFO : " << split.num_split_rows << " rows above " << max_segment << " non-zeros split, "
+              << split.num_segments() << " segments" << std::endl;
+    for (int p = 0; p < NUM_CUS; p++) {
+        std::cout << "INFO : Compute unit " << p << ": " << parts[p].local.num_rows << " segments, "
+                  << parts[p].local.adj_data.size() << " non-zeros" << std::endl;
+    }
+
+    //--------------------------------------------------------------------
+    // generate input vector
+    //--------------------------------------------------------------------
+    xhl::aligned_vector<float> vector(mat.num_cols);
+    std::generate(
+        vector.begin(),
+        vector.end(),
+        [&](){return (float)rand() / (float)(RAND_MAX/10);}
+    );
+
+    //--------------------------------------------------------------------
+    // compute reference, and the CPU reference of the split matrix
+    //--------------------------------------------------------------------
+    std::vector<float> ref_result;
+    compute_ref(mat, vector, ref_result, N);
+    std::vector<float> split_result(vector.begin(), vector.end());
+    std::vector<float> split_partial(split.num_segments());
+    for (int i = 0; i < N; i++) {
+        spmv_cpu_split<float, SPMV_SEMIRING<float>>(split, split_result.data(), split_partial.data(),
+                                                    split_result.data());
+    }
+    std::cout << "INFO : Compute reference complete!" << std::endl;
+
+    //--------------------------------------------------------------------
+    // data setup: the compute units write the partial results of their
+    // segments, merged on the host after every iteration
+    //--------------------------------------------------------------------
+    xhl::aligned_vector<float> partial(split.num_segments());
+    // the output of a compute unit without segments, which must not alias another one
+    xhl::aligned_vector<float> unused_out(NUM_CUS);
+
+    //--------------------------------------------------------------------
+    // Profiling Setup
+    //--------------------------------------------------------------------
+    TIMER_INIT(time);
+    Measure compute_time;
+    Measure merge_time;
+
+    //--------------------------------------------------------------------
+    // Compute Unit Setup
+    //--------------------------------------------------------------------
+    std::cout << "INFO : Split SpMV " << N << " Iterations Test" << std::endl;
+    std::vector<xhl::Device> devices = xhl::find_devices(
+        xhl::boards::alveo::u280::identifier
+    );
+    xhl::Device device = devices[0];
+    device.program_device(argv[1]);
+
+    std::vector<xhl::ComputeUnit*> spmv_cus;
+    for (int p = 0; p < NUM_CUS; p++) {
+        xhl::KernelSignature spmv = {
+            "spmv:{spmv_" + std::to_string(p + 1) + "}", {
+                {"values", "float*"},
+                {"col_idx", "unsigned*"},
+                {"row_ptr", "unsigned*"},
+                {"vector_in", "float*"},
+                {"vector_out", "float*"},
+                {"num_rows", "unsigned"},
+                {"num_cols", "unsigned"}
+            }
+        };
+        spmv_cus.push_back(device.find(spmv));
+    }
+
+    for (int p = 0; p < NUM_CUS; p++) {
+        CSRMatrix<float> &local = parts[p].local;
+        const int matrix_bank = xhl::boards::alveo::u280::HBM[MATRIX_BANK[p]];
+        const int vector_bank = xhl::boards::alveo::u280::HBM[VECTOR_BANK[p]];
+        std::string id = std::to_string(p);
+        // buffers are never empty, even for a compute unit without non-zeros
+        local.adj_data.resize(std::max<size_t>(local.adj_data.size(), 1));
+        local.adj_indices.resize(std::max<size_t>(local.adj_indices.size(), 1));
+        device.create_buffer("values_" + id, local.adj_data.size() * sizeof(float),
+            local.adj_data.data(), xhl::BufferType::ReadOnly, matrix_bank);
+        device.create_buffer("col_idx_" + id, local.adj_indices.size() * sizeof(unsigned),
+            local.adj_indices.data(), xhl::BufferType::ReadOnly, matrix_bank);
+        device.create_buffer("row_ptr_" + id, local.adj_indptr.size() * sizeof(unsigned),
+            local.adj_indptr.data(), xhl::BufferType::ReadOnly, matrix_bank);
+        // every compute unit reads the whole input vector from its own channel
+        device.create_buffer("vector_in_" + id, vector.size() * sizeof(float),
+            vector.data(), xhl::BufferType::ReadOnly, vector_bank);
+        float *out = (local.num_rows > 0) ? partial.data() + parts[p].row_begin : unused_out.data() + p;
+        device.create_buffer("vector_out_" + id, std::max<size_t>(local.num_rows, 1) * sizeof(float),
+            out, xhl::BufferType::WriteOnly, vector_bank);
+        for (const char *name : {"values_", "col_idx_", "row_ptr_"}) {
+            xhl::nb_sync_data_htod(&device, name + id);
+        }
+    }
+    device.finish_all_tasks();
+
+    //--------------------------------------------------------------------
+    // iterate: the compute units run their segments concurrently, then
+    // the segments of the split rows are merged on the host
+    //--------------------------------------------------------------------
+    for (int i = 0; i < N; i++) {
+        TIME_IT(time) {
+            for (int p = 0; p < NUM_CUS; p++) {
+                xhl::nb_sync_data_htod(&device, "vector_in_" + std::to_string(p));
+            }
+            for (int p = 0; p < NUM_CUS; p++) {
+                std::string id = std::to_string(p);
+                spmv_cus[p]->launch(
+                    device.get_buffer("values_" + id),
+                    device.get_buffer("col_idx_" + id),
+                    device.get_buffer("row_ptr_" + id),
+                    device.get_buffer("vector_in_" + id),
+                    device.get_buffer("vector_out_" + id),
+                    parts[p].local.num_rows,
+                    parts[p].local.num_cols
+                );
+            }
+            for (int p = 0; p < NUM_CUS; p++) {
+                xhl::nb_sync_data_dtoh(&device, "vector_out_" + std::to_string(p));
+            }
+            device.finish_all_tasks();
+        }
+        compute_time.addSample(time);
+
+        TIME_IT(time) {
+            merge_split_results<float, SPMV_SEMIRING<float>>(split, partial.data(), vector.data());
+        }
+        merge_time.addSample(time);
+    }
+
+    //--------------------------------------------------------------------
+    // compare result
+    //--------------------------------------------------------------------
+    ValidationReport cpu_report = validate_results(split_result, ref_result);
+    ValidationReport report = validate_results(vector, ref_result);
+    print_validation_report(std::cout, cpu_report, split_result.data(), ref_result.data());
+    print_validation_report(std::cout, report, vector.data(), ref_result.data());
+    bool pass = cpu_report.passed() && report.passed();
+    std::cout << (pass ? "[INFO]: Test Passed !" : "[ERROR]: Test Failed!") << std::endl;
+    std::cout << "\t\tTotal\t\tAvg\t\tMin\t\tMax" << std::endl;
+    std::cout << "Compute:\t" << compute_time << std::endl;
+    std::cout << "Merge:\t\t" << merge_time << std::endl;
+
+    std::cout << "INFO : Split SpMV complete!" << std::endl;
+
+    for (xhl::ComputeUnit *cu : spmv_cus) {
+        delete cu;
+    }
+
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+#include "xocl-host-lib.hpp"
+#include "device.hpp"
+#include "compute_unit.hpp"
+#include "sparse-io.hpp"
+#include "spmv-cpu.hpp"
+#include "validate.hpp"
+
+#include "profiling-infra.h"
+
+#include "xcl2.hpp"
+
+// the semiring of the kernels, set by SEMIRING in the Makefile
+#ifndef SPMV_SEMIRING
+#define SPMV_SEMIRING PlusTimes
+#endif
+
+//-----------------------------------------------------------------------------
+// buffers of a csr matrix, returns the number of bytes uploaded
+//-----------------------------------------------------------------------------
+size_t upload_matrix(xhl::Device &device, CSRMatrix<float> const &mat, int bank) {
+    device.create_buffer("values", mat.adj_data.size() * sizeof(float),
+        const_cast<float*>(mat.adj_data.data()), xhl::BufferType::ReadOnly, bank);
+    device.create_buffer("col_idx", mat.adj_indices.size() * sizeof(unsigned),
+        const_cast<uint32_t*>(mat.adj_indices.data()), xhl::BufferType::ReadOnly, bank);
+    device.create_buffer("row_ptr", mat.adj_indptr.size() * sizeof(unsigned),
+        const_cast<uint32_t*>(mat.adj_indptr.data()), xhl::BufferType::ReadOnly, bank);
+    xhl::nb_sync_data_htod(&device, "values");
+    xhl::nb_sync_data_htod(&device, "col_idx");
+    xhl::nb_sync_data_htod(&device, "row_ptr");
+    return mat.adj_data.size() * sizeof(float) + mat.adj_indices.size() * sizeof(unsigned)
+        + mat.adj_indptr.size() * sizeof(unsigned);
+}
+
+void release_matrix(xhl::Device &device) {
+    device.release_buffer("values");
+    device.release_buffer("col_idx");
+    device.release_buffer("row_ptr");
+}
+
+//----------------------------------------------------------------------------
+// Testbench
+//----------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    // parse arguments
+    if(argc < 3) {
+        std::cout << "Usage : " << argv[0] << " <xclbin path> <dataset path>" << std::endl;
+        std::cout << "Aborting..." << std::endl;
+        return 1;
+    }
+
+    //--------------------------------------------------------------------
+    // loading matrix data
+    //--------------------------------------------------------------------
+    std::cout << "INFO : Loading Dataset" << std::endl;
+    CSRMatrix<float> loaded;
+    SymmetricCSRMatrix<float> sym;
+    if (load_float_npz_detect_symmetry(argv[2], loaded, sym)) {
+        std::cout << "INFO : The matrix is symmetric, keeping its upper triangle" << std::endl;
+    } else {
+        std::cout << "INFO : The matrix is not symmetric, using its upper triangle as a symmetric matrix"
+                  << std::endl;
+        sym = csr_to_symmetric(loaded);
+    }
+    // the pipeline for kernels that only read rows
+    CSRMatrix<float> full = symmetric_to_csr(sym);
+    std::cout << "INFO : " << full.adj_data.size() << " non-zeros, " << sym.upper.adj_data.size()
+              << " stored in the upper triangle" << std::endl;
+
+    //--------------------------------------------------------------------
+    // generate input vector
+    //--------------------------------------------------------------------
+    xhl::aligned_vector<float> vector_in(full.num_cols);
+    xhl::aligned_vector<float> vector_out(full.num_rows);
+    xhl::aligned_vector<float> vector_out_sym(full.num_rows);
+    std::generate(
+        vector_in.begin(),
+        vector_in.end(),
+        [&](){return (float)rand() / (float)(RAND_MAX/10);}
+    );
+
+    //--------------------------------------------------------------------
+    // compute reference
+    //--------------------------------------------------------------------
+    std::vector<float> ref_result(full.num_rows);
+    spmv_cpu_symmetric<float, SPMV_SEMIRING<float>>(sym, vector_in.data(), ref_result.data());
+    std::cout << "INFO : Compute reference complete!" << std::endl;
+
+    //--------------------------------------------------------------------
+    // Profiling Setup
+    //--------------------------------------------------------------------
+    TIMER_INIT(time);
+    Measure full_time;
+    Measure sym_time;
+
+    //--------------------------------------------------------------------
+    // Compute Unit Setup
+    //--------------------------------------------------------------------
+    xhl::KernelSignature spmv = {
+        "spmv", {
+            {"values", "float*"},
+            {"col_idx", "unsigned*"},
+            {"row_ptr", "unsigned*"},
+            {"vector_in", "float*"},
+            {"vector_out", "float*"},
+            {"num_rows", "unsigned"},
+            {"num_cols", "unsigned"}
+        }
+    };
+    xhl::KernelSignature spmv_sym = {
+        "spmv_sym", {
+            {"values", "float*"},
+            {"col_idx", "unsigned*"},
+            {"row_ptr", "unsigned*"},
+            {"vector_in", "float*"},
+            {"vector_out", "float*"},
+            {"num_rows", "unsigned"}
+        }
+    };
+    std::vector<xhl::Device> devices = xhl::find_devices(
+        xhl::boards::alveo::u280::identifier
+    );
+    xhl::Device device = devices[0];
+    device.program_device(argv[1]);
+
+    xhl::ComputeUnit* spmv_cu = device.find(spmv);
+    xhl::ComputeUnit* spmv_sym_cu = device.find(spmv_sym);
+    const int bank = xhl::boards::alveo::u280::HBM[0];
+
+    device.create_buffer("vector_in", vector_in.size() * sizeof(float), vector_in.data(),
+        xhl::BufferType::ReadOnly, bank);
+    xhl::sync_data_htod(&device, "vector_in");
+
+    //--------------------------------------------------------------------
+    // expanded: both triangles uploaded, row-only kernel
+    //--------------------------------------------------------------------
+    size_t full_bytes = 0;
+    device.create_buffer("vector_out", vector_out.size() * sizeof(float), vector_out.data(),
+        xhl::BufferType::WriteOnly, bank);
+    TIME_IT(time) {
+        full_bytes = upload_matrix(device, full, bank);
+        spmv_cu->launch(
+            device.get_buffer("values"),
+            device.get_buffer("col_idx"),
+            device.get_buffer("row_ptr"),
+            device.get_buffer("vector_in"),
+            device.get_buffer("vector_out"),
+            full.num_rows,
+            full.num_cols
+        );
+        xhl::sync_data_dtoh(&device, "vector_out");
+    }
+    full_time.addSample(time);
+    release_matrix(device);
+    device.release_buffer("vector_out");
+
+    //--------------------------------------------------------------------
+    // symmetric: upper triangle uploaded, the kernel applies both halves
+    //--------------------------------------------------------------------
+    size_t sym_bytes = 0;
+    device.create_buffer("vector_out", vector_out_sym.size() * sizeof(float), vector_out_sym.data(),
+        xhl::BufferType::ReadWrite, bank);
+    TIME_IT(time) {
+        sym_bytes = upload_matrix(device, sym.upper, bank);
+        spmv_sym_cu->launch(
+            device.get_buffer("values"),
+            device.get_buffer("col_idx"),
+            device.get_buffer("row_ptr"),
+            device.get_buffer("vector_in"),
+            device.get_buffer("vector_out"),
+            sym.upper.num_rows
+        );
+        xhl::sync_data_dtoh(&device, "vector_out");
+    }
+    sym_time.addSample(time);
+
+    //--------------------------------------------------------------------
+    // compare result
+    //--------------------------------------------------------------------
+    ValidationReport full_report = validate_results(vector_out, ref_result);
+    ValidationReport sym_report = validate_results(vector_out_sym, ref_result);
+    print_validation_report(std::cout, full_report, vector_out.data(), ref_result.data());
+    print_validation_report(std::cout, sym_report, vector_out_sym.data(), ref_result.data());
+    bool pass = full_report.passed() && sym_report.passed();
+    std::cout << (pass ? "[INFO]: Test Passed !" : "[ERROR]: Test Failed!") << std::endl;
+    std::cout << "\t\tTotal\t\tAvg\t\tMin\t\tMax" << std::endl;
+    std::cout << "Expanded:\t" << full_time << std::endl;
+    std::cout << "Symmetric:\t" << sym_time << std::endl;
+    std::cout << "INFO : Uploaded " << full_bytes << " bytes expanded, " << sym_bytes << " bytes symmetric"
+              << std::endl;
+
+    std::cout << "INFO : SpMV symmetric complete!" << std::endl;
+
+    delete spmv_cu;
+    delete spmv_sym_cu;
+
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,109 @@
+#include "semiring.hpp"
+
+// the semiring is picked at build time, e.g., -DSPMV_SEMIRING=MinPlus
+#ifndef SPMV_SEMIRING
+#define SPMV_SEMIRING PlusTimes
+#endif
+
+const unsigned FPADD_LATENCY = 8;
+
+template<typename semiring>
+void spmv_rows(
+    const float* values,
+    const unsigned* col_idx,
+    const unsigned* row_ptr,
+    float* vector_in,
+    float* vector_out,
+    const unsigned num_rows
+) {
+    for (unsigned row_idx = 0; row_idx < num_rows; row_idx++) {
+        #pragma HLS pipeline off
+        unsigned start = row_ptr[row_idx];
+        unsigned end = row_ptr[row_idx + 1];
+
+        float res = semiring::zero();
+        for (unsigned i = start; i < end; i++) {
+            #pragma HLS pipeline II=FPADD_LATENCY style=flp
+            unsigned idx = col_idx[i];
+            res = semiring::add(res, semiring::mul(values[i], vector_in[idx]));
+        }
+
+        vector_out[row_idx] = res;
+    }
+}
+
+// Both halves of a symmetric matrix from its upper triangle: row r adds its dot product to
+// vector_out[r] and scatters its entries (r, c), c > r, into vector_out[c]. Rows run in order, so
+// every scatter into row r is done before row r is final.
+template<typename semiring>
+void spmv_sym_rows(
+    const float* values,
+    const unsigned* col_idx,
+    const unsigned* row_ptr,
+    float* vector_in,
+    float* vector_out,
+    const unsigned num_rows
+) {
+    for (unsigned row_idx = 0; row_idx < num_rows; row_idx++) {
+        #pragma HLS pipeline II=1
+        vector_out[row_idx] = semiring::zero();
+    }
+    for (unsigned row_idx = 0; row_idx < num_rows; row_idx++) {
+        #pragma HLS pipeline off
+        unsigned start = row_ptr[row_idx];
+        unsigned end = row_ptr[row_idx + 1];
+        float x = vector_in[row_idx];
+
+        float res = semiring::zero();
+        for (unsigned i = start; i < end; i++) {
+            #pragma HLS pipeline II=FPADD_LATENCY style=flp
+            // the columns of a row are distinct, the scatters of a row never alias
+            #pragma HLS dependence variable=vector_out type=inter false
+            unsigned idx = col_idx[i];
+            float value = values[i];
+            res = semiring::add(res, semiring::mul(value, vector_in[idx]));
+            if (idx != row_idx) {
+                vector_out[idx] = semiring::add(vector_out[idx], semiring::mul(value, x));
+            }
+        }
+
+        vector_out[row_idx] = semiring::add(vector_out[row_idx], res);
+    }
+}
+
+extern "C"  void spmv (
+    const float* values,
+    const unsigned* col_idx,
+    const unsigned* row_ptr,
+    float* vector_in,
+    float* vector_out,
+
+    const unsigned num_rows,
+    const unsigned num_cols
+) {
+    #pragma HLS interface m_axi port=values         offset=slave bundle=gmem_mat1
+    #pragma HLS interface m_axi port=col_idx        offset=slave bundle=gmem_mat2
+    #pragma HLS interface m_axi port=row_ptr        offset=slave bundle=gmem_mat3
+    #pragma HLS interface m_axi port=vector_in      offset=slave bundle=gmem_vec1
+    #pragma HLS interface m_axi port=vector_out     offset=slave bundle=gmem_vec2
+
+    spmv_rows<SPMV_SEMIRING<float>>(values, col_idx, row_ptr, vector_in, vector_out, num_rows);
+}
+
+extern "C"  void spmv_sym (
+    const float* values,
+    const unsigned* col_idx,
+    const unsigned* row_ptr,
+    float* vector_in,
+    float* vector_out,
+
+    const unsigned num_rows
+) {
+    #pragma HLS interface m_axi port=values         offset=slave bundle=gmem_mat1
+    #pragma HLS interface m_axi port=col_idx        offset=slave bundle=gmem_mat2
+    #pragma HLS interface m_axi port=row_ptr        offset=slave bundle=gmem_mat3
+    #pragma HLS interface m_axi port=vector_in      offset=slave bundle=gmem_vec1
+    #pragma HLS interface m_axi port=vector_out     offset=slave bundle=gmem_vec2
+
+    spmv_sym_rows<SPMV_SEMIRING<float>>(values, col_idx, row_ptr, vector_in, vector_out, num_rows);
+}
@@ -0,0 +1,225 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+#include "xocl-host-lib.hpp"
+#include "device.hpp"
+#include "compute_unit.hpp"
+#include "sparse-io.hpp"
+#include "spmv-cpu.hpp"
+#include "csr-partition.hpp"
+#include "validate.hpp"
+
+#include "profiling-infra.h"
+
+#include "xcl2.hpp"
+
+// the semiring of the kernel, set by SEMIRING in the Makefile
+#ifndef SPMV_SEMIRING
+#define SPMV_SEMIRING PlusTimes
+#endif
+
+// a 2 x 2 grid of tiles, tile p on compute unit p and its HBM channels, as in spmv.link.config
+const int ROW_BLOCKS = 2;
+const int COL_BLOCKS = 2;
+const int NUM_CUS = ROW_BLOCKS * COL_BLOCKS;
+const int MATRIX_BANK[NUM_CUS] = {0, 2, 4, 6};
+const int VECTOR_BANK[NUM_CUS] = {1, 3, 5, 7};
+
+//-----------------------------------------------------------------------------
+// ground true data
+//-----------------------------------------------------------------------------
+void compute_ref(
+    CSRMatrix<float> &mat,
+    xhl::aligned_vector<float> &vector,
+    std::vector<float> &ref_result,
+    size_t iterations
+) {
+    CPUSpMVEngine<float, SPMV_SEMIRING<float>> engine(mat);
+    ref_result.assign(vector.begin(), vector.end());
+    std::vector<float> scratch(mat.num_rows);
+    float *result = engine.iterate(ref_result.data(), scratch.data(), iterations);
+    if (result != ref_result.data()) ref_result.swap(scratch);
+}
+
+//----------------------------------------------------------------------------
+// Testbench
+//----------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    const int N = 3;
+    // parse arguments
+    if(argc < 3) {
+        std::cout << "Usage : " << argv[0] << " <xclbin path> <dataset path>" << std::endl;
+        std::cout << "Aborting..." << std::endl;
+        return 1;
+    }
+
+    //--------------------------------------------------------------------
+    // loading matrix data, cut into tiles with compacted columns
+    //--------------------------------------------------------------------
+    std::cout << "INFO : Loading Dataset" << std::endl;
+    CSRMatrix<float> mat = load_csr_matrix_from_float_npz(argv[2]);
+    std::vector<uint32_t> row_split = partition_rows_by_nnz(mat, ROW_BLOCKS);
+    std::vector<uint64_t> row_bounds(row_split.begin(), row_split.end());
+    std::vector<uint64_t> col_bounds;
+    for (int j = 0; j <= COL_BLOCKS; j++) {
+        col_bounds.push_back((uint64_t)mat.num_cols * j / COL_BLOCKS);
+    }
+    std::vector<CompactCSRTile<float>> tiles = partition_csr_2d(mat, row_bounds, col_bounds);
+    size_t compact_entries = 0;
+    for (auto &tile : tiles) {
+        compact_entries += tile.col_map.size();
+    }
+    std::cout << "INFO : Vector upload per iteration " << compact_entries * sizeof(float) << " bytes, "
+              << (size_t)mat.num_cols * NUM_CUS * sizeof(float) << " bytes without compaction" << std::endl;
+
+    //--------------------------------------------------------------------
+    // generate input vector
+    //--------------------------------------------------------------------
+    xhl::aligned_vector<float> vector(mat.num_cols);
+    std::generate(
+        vector.begin(),
+        vector.end(),
+        [&](){return (float)rand() / (float)(RAND_MAX/10);}
+    );
+
+    //--------------------------------------------------------------------
+    // compute reference
+    //--------------------------------------------------------------------
+    std::vector<float> ref_result;
+    compute_ref(mat, vector, ref_result, N);
+    std::cout << "INFO : Compute reference complete!" << std::endl;
+
+    //--------------------------------------------------------------------
+    // data setup: the vectors of a tile only cover its rows and columns
+    //--------------------------------------------------------------------
+    std::vector<xhl::aligned_vector<float>> tile_in(NUM_CUS);
+    std::vector<xhl::aligned_vector<float>> tile_out(NUM_CUS);
+    std::vector<const float*> partial;
+    for (int p = 0; p < NUM_CUS; p++) {
+        // buffers are never empty, even for a tile without non-zeros
+        tile_in[p].resize(std::max<size_t>(tiles[p].col_map.size(), 1));
+        tile_out[p].resize(std::max<size_t>(tiles[p].local.num_rows, 1));
+        partial.push_back(tile_out[p].data());
+    }
+
+    //--------------------------------------------------------------------
+    // Profiling Setup
+    //--------------------------------------------------------------------
+    TIMER_INIT(time);
+    Measure upload_time;
+    Measure compute_time;
+    Measure reduce_time;
+
+    //--------------------------------------------------------------------
+    // Compute Unit Setup
+    //--------------------------------------------------------------------
+    std::cout << "INFO : Tiled SpMV " << N << " Iterations Test" << std::endl;
+    std::vector<xhl::Device> devices = xhl::find_devices(
+        xhl::boards::alveo::u280::identifier
+    );
+    xhl::Device device = devices[0];
+    device.program_device(argv[1]);
+
+    std::vector<xhl::ComputeUnit*> spmv_cus;
+    for (int p = 0; p < NUM_CUS; p++) {
+        xhl::KernelSignature spmv = {
+            "spmv:{spmv_" + std::to_string(p + 1) + "}", {
+                {"values", "float*"},
+                {"col_idx", "unsigned*"},
+                {"row_ptr", "unsigned*"},
+                {"vector_in", "float*"},
+                {"vector_out", "float*"},
+                {"num_rows", "unsigned"},
+                {"num_cols", "unsigned"}
+            }
+        };
+        spmv_cus.push_back(device.find(spmv));
+    }
+
+    for (int p = 0; p < NUM_CUS; p++) {
+        CSRMatrix<float> &local = tiles[p].local;
+        const int matrix_bank = xhl::boards::alveo::u280::HBM[MATRIX_BANK[p]];
+        const int vector_bank = xhl::boards::alveo::u280::HBM[VECTOR_BANK[p]];
+        std::string id = std::to_string(p);
+        local.adj_data.resize(std::max<size_t>(local.adj_data.size(), 1));
+        local.adj_indices.resize(std::max<size_t>(local.adj_indices.size(), 1));
+        device.create_buffer("values_" + id, local.adj_data.size() * sizeof(float),
+            local.adj_data.data(), xhl::BufferType::ReadOnly, matrix_bank);
+        device.create_buffer("col_idx_" + id, local.adj_indices.size() * sizeof(unsigned),
+            local.adj_indices.data(), xhl::BufferType::ReadOnly, matrix_bank);
+        device.create_buffer("row_ptr_" + id, local.adj_indptr.size() * sizeof(unsigned),
+            local.adj_indptr.data(), xhl::BufferType::ReadOnly, matrix_bank);
+        device.create_buffer("vector_in_" + id, tile_in[p].size() * sizeof(float),
+            tile_in[p].data(), xhl::BufferType::ReadOnly, vector_bank);
+        device.create_buffer("vector_out_" + id, tile_out[p].size() * sizeof(float),
+            tile_out[p].data(), xhl::BufferType::WriteOnly, vector_bank);
+        for (const char *name : {"values_", "col_idx_", "row_ptr_"}) {
+            xhl::nb_sync_data_htod(&device, name + id);
+        }
+    }
+    device.finish_all_tasks();
+
+    //--------------------------------------------------------------------
+    // iterate: gather and upload the columns of every tile, run the
+    // tiles concurrently, reduce the column blocks of every row block
+    //--------------------------------------------------------------------
+    for (int i = 0; i < N; i++) {
+        TIME_IT(time) {
+            for (int p = 0; p < NUM_CUS; p++) {
+                gather_tile_vector(vector.data(), tiles[p].col_map, tile_in[p].data());
+                xhl::nb_sync_data_htod(&device, "vector_in_" + std::to_string(p));
+            }
+            device.finish_all_tasks();
+        }
+        upload_time.addSample(time);
+
+        TIME_IT(time) {
+            for (int p = 0; p < NUM_CUS; p++) {
+                std::string id = std::to_string(p);
+                spmv_cus[p]->launch(
+                    device.get_buffer("values_" + id),
+                    device.get_buffer("col_idx_" + id),
+                    device.get_buffer("row_ptr_" + id),
+                    device.get_buffer("vector_in_" + id),
+                    device.get_buffer("vector_out_" + id),
+                    tiles[p].local.num_rows,
+                    tiles[p].local.num_cols
+                );
+            }
+            for (int p = 0; p < NUM_CUS; p++) {
+                xhl::nb_sync_data_dtoh(&device, "vector_out_" + std::to_string(p));
+            }
+            device.finish_all_tasks();
+        }
+        compute_time.addSample(time);
+
+        TIME_IT(time) {
+            reduce_tile_results<float, SPMV_SEMIRING<float>>(tiles, COL_BLOCKS, partial, vector.data());
+        }
+        reduce_time.addSample(time);
+    }
+
+    //--------------------------------------------------------------------
+    // compare result
+    //--------------------------------------------------------------------
+    ValidationReport report = validate_results(vector, ref_result);
+    print_validation_report(std::cout, report, vector.data(), ref_result.data());
+    bool pass = report.passed();
+    std::cout << (pass ? "[INFO]: Test Passed !" : "[ERROR]: Test Failed!") << std::endl;
+    std::cout << "\t\tTotal\t\tAvg\t\tMin\t\tMax" << std::endl;
+    std::cout << "Upload:\t\t" << upload_time << std::endl;
+    std::cout << "Compute:\t" << compute_time << std::endl;
+    std::cout << "Reduce:\t\t" << reduce_time << std::endl;
+
+    std::cout << "INFO : Tiled SpMV complete!" << std::endl;
+
+    for (xhl::ComputeUnit *cu : spmv_cus) {
+        delete cu;
+    }
+
+    return pass ? 0 : 1;
+}
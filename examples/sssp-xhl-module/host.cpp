@@ -0,0 +1,99 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <algorithm>
+
+#include "xocl-host-lib.hpp"
+#include "device.hpp"
+#include "compute_unit.hpp"
+#include "sparse-io.hpp"
+#include "frontier.hpp"
+#include "validate.hpp"
+#include "module_sssp.hpp"
+
+#include "profiling-infra.h"
+
+#include "xcl2.hpp"
+
+//----------------------------------------------------------------------------
+// Testbench
+//----------------------------------------------------------------------------
+int main(int argc, char** argv) {
+    // parse arguments
+    if(argc < 3) {
+        std::cout << "Usage : " << argv[0] << " <xclbin path> <dataset path> [source] [bfs|sssp]" << std::endl;
+        std::cout << "Aborting..." << std::endl;
+        return 1;
+    }
+    uint32_t source = (argc > 3) ? std::stoul(argv[3]) : 0;
+    bool bfs = (argc > 4) ? (std::string(argv[4]) == "bfs") : true;
+
+    //--------------------------------------------------------------------
+    // loading graph data
+    //--------------------------------------------------------------------
+    std::cout << "INFO : Loading Dataset" << std::endl;
+    CSRMatrix<float> graph = load_csr_matrix_from_float_npz(argv[2]);
+    if (bfs) {
+        // BFS levels are shortest paths with unit weights
+        std::fill(graph.adj_data.begin(), graph.adj_data.end(), 1.0f);
+    }
+
+    //--------------------------------------------------------------------
+    // compute reference
+    //--------------------------------------------------------------------
+    CSCMatrix<float> graph_csc = csr2csc(graph);
+    TraversalStats ref_stats;
+    std::vector<float> ref_result = sssp_frontier_cpu(graph, graph_csc, source, &ref_stats);
+    std::cout << "INFO : Compute reference complete! " << ref_stats.levels << " levels, "
+              << ref_stats.pull_levels << " pulled" << std::endl;
+
+    //--------------------------------------------------------------------
+    // Profiling Setup
+    //--------------------------------------------------------------------
+    TIMER_INIT(time);
+    Measure load_time;
+    Measure compute_time;
+
+    //--------------------------------------------------------------------
+    // Module Setup
+    //--------------------------------------------------------------------
+    std::cout << "INFO : " << (bfs ? "BFS" : "SSSP") << " Test from vertex " << source << std::endl;
+    std::vector<xhl::Device> devices = xhl::find_devices(
+        xhl::boards::alveo::u280::identifier
+    );
+    devices[0].program_device(argv[1]);
+
+    xhl::Module_sssp module;
+    module.initialize(devices);
+    TIME_IT(time) {
+        module.load_graph(graph);
+    }
+    load_time.addSample(time);
+
+    xhl::aligned_vector<float> dist;
+    TIME_IT(time) {
+        dist = module.run(source);
+    }
+    compute_time.addSample(time);
+    const TraversalStats &stats = module.stats();
+    std::cout << "INFO : " << stats.levels << " levels (" << stats.pull_levels << " pulled), "
+              << stats.edges << " edges relaxed, "
+              << (double)stats.edges / graph.adj_data.size() << "x nnz" << std::endl;
+
+    //--------------------------------------------------------------------
+    // compare result
+    //--------------------------------------------------------------------
+    ValidationReport report = validate_results(dist, ref_result);
+    print_validation_report(std::cout, report, dist.data(), ref_result.data());
+    bool pass = report.passed();
+    std::cout << (pass ? "[INFO]: Test Passed !" : "[ERROR]: Test Failed!") << std::endl;
+    std::cout << "\t\tTotal\t\tAvg\t\tMin\t\tMax" << std::endl;
+    std::cout << "Load:\t\t" << load_time << std::endl;
+    std::cout << "Compute:\t" << compute_time << std::endl;
+
+    std::cout << "INFO : SSSP module complete!" << std::endl;
+
+    return pass ? 0 : 1;
+}
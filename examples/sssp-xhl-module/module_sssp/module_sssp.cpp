@@ -0,0 +1,187 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <limits>
+
+#include "xocl-host-lib.hpp"
+#include "device.hpp"
+#include "compute_unit.hpp"
+#include "placement.hpp"
+#include "module_sssp.hpp"
+
+namespace xhl{
+
+Module_sssp::Module_sssp(double alpha)
+    : push_cu(nullptr), pull_cu(nullptr), _alpha(alpha), _csr(nullptr), _stamp(0) {}
+
+void Module_sssp::initialize(std::vector<Device>& devices) {
+    this->push_cu = devices[0].find(this->sssp_push);
+    this->pull_cu = devices[0].find(this->sssp_pull);
+}
+
+void Module_sssp::free_cu(){
+    delete this->push_cu;
+    delete this->pull_cu;
+    this->push_cu = nullptr;
+    this->pull_cu = nullptr;
+}
+
+Module_sssp::~Module_sssp(){
+    this->free_cu();
+}
+
+void Module_sssp::load_graph(const CSRMatrix<float> &graph) {
+    if (graph.num_rows != graph.num_cols) {
+        throw std::runtime_error(
+            "SSSP needs a square matrix, got " + std::to_string(graph.num_rows)
+            + "x" + std::to_string(graph.num_cols)
+        );
+    }
+    auto device_1 = this->push_cu->cu_device;
+    device_1->finish_all_tasks();
+    this->_csr = &graph;
+    this->_csc = csr2csc(graph);
+    const uint32_t n = graph.num_rows;
+    const size_t nnz = graph.adj_data.size();
+    this->_dist.assign(n, 0);
+    this->_mark.assign(n, 0);
+    this->_frontier[0].assign(n, 0);
+    this->_frontier[1].assign(n, 0);
+    this->_frontier_size.assign(1, 0);
+    this->_stamp = 0;
+
+    // the graph in banks 0-7, the vertex data in banks 8-15, as in sssp.link.config
+    const std::vector<int> graph_banks = {0, 1, 2, 3, 4, 5, 6, 7};
+    const std::vector<int> vertex_banks = {8, 9, 10, 11, 12, 13, 14, 15};
+    PlacementPlanner planner(boards::alveo::u280::HBM, 32, boards::alveo::u280::HBM_CHANNEL_SIZE);
+    planner.add_buffer({"csr_values", nnz * sizeof(float), (double)nnz, graph_banks});
+    planner.add_buffer({"csr_col_idx", nnz * sizeof(unsigned), (double)nnz, graph_banks});
+    planner.add_buffer({"csr_row_ptr", (n + 1) * sizeof(unsigned), (double)n, graph_banks});
+    planner.add_buffer({"csc_values", nnz * sizeof(float), (double)nnz, graph_banks});
+    planner.add_buffer({"csc_row_idx", nnz * sizeof(unsigned), (double)nnz, graph_banks});
+    planner.add_buffer({"csc_col_ptr", (n + 1) * sizeof(unsigned), (double)n, graph_banks});
+    planner.add_buffer({"dist", n * sizeof(float), (double)nnz, vertex_banks});
+    planner.add_buffer({"mark", n * sizeof(unsigned), (double)n, vertex_banks});
+    planner.add_buffer({"frontier_0", n * sizeof(unsigned), (double)n, vertex_banks});
+    planner.add_buffer({"frontier_1", n * sizeof(unsigned), (double)n, vertex_banks});
+    planner.add_buffer({"frontier_size", sizeof(unsigned), 1, vertex_banks});
+    this->_placement = planner.plan();
+
+    for (auto &placement : this->_placement) {
+        if (placement.second.segments.size() > 1) {
+            throw std::runtime_error(
+                "Buffer " + placement.first + " does not fit in one HBM channel"
+            );
+        }
+        if (device_1->contains_buffer(placement.first)) device_1->release_buffer(placement.first);
+    }
+    create_placed_buffer(device_1, this->_placement["csr_values"],
+        const_cast<float*>(graph.adj_data.data()), BufferType::ReadOnly);
+    create_placed_buffer(device_1, this->_placement["csr_col_idx"],
+        const_cast<uint32_t*>(graph.adj_indices.data()), BufferType::ReadOnly);
+    create_placed_buffer(device_1, this->_placement["csr_row_ptr"],
+        const_cast<uint32_t*>(graph.adj_indptr.data()), BufferType::ReadOnly);
+    create_placed_buffer(device_1, this->_placement["csc_values"],
+        this->_csc.adj_data.data(), BufferType::ReadOnly);
+    create_placed_buffer(device_1, this->_placement["csc_row_idx"],
+        this->_csc.adj_indices.data(), BufferType::ReadOnly);
+    create_placed_buffer(device_1, this->_placement["csc_col_ptr"],
+        this->_csc.adj_indptr.data(), BufferType::ReadOnly);
+    create_placed_buffer(device_1, this->_placement["dist"], this->_dist.data(), BufferType::ReadWrite);
+    create_placed_buffer(device_1, this->_placement["mark"], this->_mark.data(), BufferType::ReadWrite);
+    create_placed_buffer(device_1, this->_placement["frontier_0"],
+        this->_frontier[0].data(), BufferType::ReadWrite);
+    create_placed_buffer(device_1, this->_placement["frontier_1"],
+        this->_frontier[1].data(), BufferType::ReadWrite);
+    create_placed_buffer(device_1, this->_placement["frontier_size"],
+        this->_frontier_size.data(), BufferType::ReadWrite);
+    for (auto &placement : this->_placement) {
+        if (placement.first.compare(0, 8, "frontier") != 0) nb_sync_data_htod(device_1, placement.first);
+    }
+}
+
+cl::Buffer Module_sssp::_prefix(const std::string &name, uint32_t count) {
+    cl_buffer_region region = {0, count * sizeof(unsigned)};
+    cl_int err = 0;
+    cl::Buffer prefix = this->push_cu->cu_device->get_buffer(name).createSubBuffer(
+        CL_MEM_READ_WRITE, CL_BUFFER_CREATE_TYPE_REGION, &region, &err
+    );
+    if (err != CL_SUCCESS) {
+        throw std::runtime_error(
+            "Failed to create sub-buffer for " + name + " (code:" + std::to_string(err) + ")"
+        );
+    }
+    return prefix;
+}
+
+const aligned_vector<float> &Module_sssp::run(uint32_t source) {
+    if (this->_csr == nullptr) {
+        throw std::runtime_error("No graph loaded, call load_graph first");
+    }
+    const CSRMatrix<float> &csr = *this->_csr;
+    if (source >= csr.num_rows) {
+        throw std::runtime_error("Source vertex " + std::to_string(source) + " is out of range");
+    }
+    auto device_1 = this->push_cu->cu_device;
+    const uint64_t nnz = csr.adj_indptr[csr.num_rows];
+    std::fill(this->_dist.begin(), this->_dist.end(), std::numeric_limits<float>::infinity());
+    this->_dist[source] = 0;
+    nb_sync_data_htod(device_1, "dist");
+    this->_frontier[0][0] = source;
+    nb_sync_data_htod(device_1, this->_prefix("frontier_0", 1));
+    uint32_t frontier_size = 1;
+    this->_stats = TraversalStats();
+
+    // frontier_cur holds this level's frontier, the kernels write the next one to the other buffer
+    int cur = 0;
+    for (uint32_t level = 1; frontier_size > 0 && level <= csr.num_rows; level++) {
+        std::string frontier_in = "frontier_" + std::to_string(cur);
+        std::string frontier_out = "frontier_" + std::to_string(1 - cur);
+        uint64_t edges = frontier_edges(this->_csc, this->_frontier[cur].data(), frontier_size);
+        if (choose_direction(edges, nnz, this->_alpha) == Direction::Pull) {
+            this->pull_cu->launch(
+                device_1->get_buffer("csr_values"),
+                device_1->get_buffer("csr_col_idx"),
+                device_1->get_buffer("csr_row_ptr"),
+                device_1->get_buffer("dist"),
+                device_1->get_buffer(frontier_out),
+                device_1->get_buffer("frontier_size"),
+                csr.num_rows
+            );
+            this->_stats.pull_levels++;
+            this->_stats.edges += nnz;
+        } else {
+            this->push_cu->launch(
+                device_1->get_buffer("csc_values"),
+                device_1->get_buffer("csc_row_idx"),
+                device_1->get_buffer("csc_col_ptr"),
+                device_1->get_buffer("dist"),
+                device_1->get_buffer("mark"),
+                as_input(device_1->get_buffer(frontier_in)),
+                device_1->get_buffer(frontier_out),
+                device_1->get_buffer("frontier_size"),
+                frontier_size,
+                ++this->_stamp
+            );
+            this->_stats.edges += edges;
+        }
+        this->_stats.levels++;
+
+        // only the size and the vertex ids of the next frontier come back
+        sync_data_dtoh(device_1, "frontier_size");
+        frontier_size = this->_frontier_size[0];
+        if (frontier_size > 0) {
+            sync_data_dtoh(device_1, this->_prefix(frontier_out, frontier_size));
+        }
+        cur = 1 - cur;
+    }
+    sync_data_dtoh(device_1, "dist");
+    return this->_dist;
+}
+
+const TraversalStats &Module_sssp::stats() const {
+    return this->_stats;
+}
+
+} // namespace xhl
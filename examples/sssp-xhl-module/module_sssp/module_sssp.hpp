@@ -0,0 +1,110 @@
+#ifndef MODULE_SSSP_HPP
+#define MODULE_SSSP_HPP
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+
+#include "xocl-host-lib.hpp"
+#include "compute_unit.hpp"
+#include "module.hpp"
+#include "device.hpp"
+#include "placement.hpp"
+#include "sparse-io.hpp"
+#include "frontier.hpp"
+
+namespace xhl{
+/**
+ * @brief frontier-based single-source shortest paths (BFS with unit weights).
+ * The graph and the distances stay resident on the device. The frontier is
+ * kept compacted: each level moves only its size and vertex ids back to the
+ * host, which picks push (csc) for sparse frontiers and pull (csr) for dense
+ * ones.
+ */
+class Module_sssp : public xhl::Module {
+    public:
+    ComputeUnit* push_cu;
+    ComputeUnit* pull_cu;
+
+    const KernelSignature sssp_push = {
+        "sssp_push", {
+            {"values", "float*"},
+            {"row_idx", "unsigned*"},
+            {"col_ptr", "unsigned*"},
+            {"dist", "float*"},
+            {"mark", "unsigned*"},
+            {"frontier_in", "unsigned*"},
+            {"frontier_out", "unsigned*"},
+            {"frontier_out_size", "unsigned*"},
+            {"frontier_size", "unsigned"},
+            {"level", "unsigned"}
+        }
+    };
+
+    const KernelSignature sssp_pull = {
+        "sssp_pull", {
+            {"values", "float*"},
+            {"col_idx", "unsigned*"},
+            {"row_ptr", "unsigned*"},
+            {"dist", "float*"},
+            {"frontier_out", "unsigned*"},
+            {"frontier_out_size", "unsigned*"},
+            {"num_rows", "unsigned"}
+        }
+    };
+
+    /**
+     * @brief constructor
+     *
+     * @param alpha pull once the out-edges of the frontier exceed nnz / alpha
+     */
+    Module_sssp(double alpha = 14);
+
+    void initialize(std::vector<Device>& devices) override;
+
+    void free_cu() override;
+
+    ~Module_sssp();
+
+    /**
+     * @brief upload the graph in both directions, it stays resident on the
+     * device for all runs
+     *
+     * @param graph square matrix, row i lists the in-edges of vertex i with
+     * their weights, must outlive the module
+     *
+     * @exception std::runtime_error if the matrix is not square
+     */
+    void load_graph(const CSRMatrix<float> &graph);
+
+    /**
+     * @brief compute the distances from a source vertex, infinity for
+     * unreachable vertices
+     *
+     * @param source the source vertex
+     * @return the distances, valid until the next run or load_graph
+     */
+    const aligned_vector<float> &run(uint32_t source);
+
+    /**
+     * @brief get the levels and edges of the last run
+     */
+    const TraversalStats &stats() const;
+
+    private:
+    double _alpha;
+    const CSRMatrix<float> *_csr;
+    CSCMatrix<float> _csc;
+    std::map<std::string, BufferPlacement> _placement;
+    aligned_vector<float> _dist;
+    aligned_vector<uint32_t> _mark;
+    aligned_vector<uint32_t> _frontier[2];
+    aligned_vector<uint32_t> _frontier_size;
+    uint32_t _stamp; // level stamp of mark, grows across runs so mark is never cleared
+    TraversalStats _stats;
+
+    cl::Buffer _prefix(const std::string &name, uint32_t count);
+};
+} // namespace xhl
+#endif // MODULE_SSSP_HPP
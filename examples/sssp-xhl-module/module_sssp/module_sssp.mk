@@ -0,0 +1,2 @@
+module_sssp_CXXFLAGS += -I$(XOCL_HOST_LIB)/examples/sssp-xhl-module/module_sssp
+module_sssp_SRCS += $(XOCL_HOST_LIB)/examples/sssp-xhl-module/module_sssp/module_sssp.cpp
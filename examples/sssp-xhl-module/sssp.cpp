@@ -0,0 +1,90 @@
+// Level kernels of frontier-based SSSP. Both relax distances in place in dist and write the
+// vertices whose distance dropped to frontier_out, each once, with their count in
+// frontier_out_size[0].
+
+// push: relax the out-edges of the frontier along the columns of the graph (csc)
+extern "C" void sssp_push (
+    const float* values,
+    const unsigned* row_idx,
+    const unsigned* col_ptr,
+    float* dist,
+    unsigned* mark,
+    const unsigned* frontier_in,
+    unsigned* frontier_out,
+    unsigned* frontier_out_size,
+
+    const unsigned frontier_size,
+    const unsigned level
+) {
+    #pragma HLS interface m_axi port=values             offset=slave bundle=gmem_mat1
+    #pragma HLS interface m_axi port=row_idx            offset=slave bundle=gmem_mat2
+    #pragma HLS interface m_axi port=col_ptr            offset=slave bundle=gmem_mat3
+    #pragma HLS interface m_axi port=dist               offset=slave bundle=gmem_vec1
+    #pragma HLS interface m_axi port=mark               offset=slave bundle=gmem_vec2
+    #pragma HLS interface m_axi port=frontier_in        offset=slave bundle=gmem_frt1
+    #pragma HLS interface m_axi port=frontier_out       offset=slave bundle=gmem_frt2
+    #pragma HLS interface m_axi port=frontier_out_size  offset=slave bundle=gmem_frt2
+
+    unsigned count = 0;
+    for (unsigned k = 0; k < frontier_size; k++) {
+        #pragma HLS pipeline off
+        unsigned col = frontier_in[k];
+        unsigned start = col_ptr[col];
+        unsigned end = col_ptr[col + 1];
+        float dist_col = dist[col];
+
+        for (unsigned i = start; i < end; i++) {
+            #pragma HLS pipeline off
+            unsigned row = row_idx[i];
+            float new_dist = dist_col + values[i];
+            if (new_dist < dist[row]) {
+                dist[row] = new_dist;
+                // mark holds the last level a vertex entered the frontier, so it is never cleared
+                if (mark[row] != level) {
+                    mark[row] = level;
+                    frontier_out[count++] = row;
+                }
+            }
+        }
+    }
+    frontier_out_size[0] = count;
+}
+
+// pull: relax every vertex from its in-edges along the rows of the graph (csr)
+extern "C" void sssp_pull (
+    const float* values,
+    const unsigned* col_idx,
+    const unsigned* row_ptr,
+    float* dist,
+    unsigned* frontier_out,
+    unsigned* frontier_out_size,
+
+    const unsigned num_rows
+) {
+    #pragma HLS interface m_axi port=values             offset=slave bundle=gmem_mat1
+    #pragma HLS interface m_axi port=col_idx            offset=slave bundle=gmem_mat2
+    #pragma HLS interface m_axi port=row_ptr            offset=slave bundle=gmem_mat3
+    #pragma HLS interface m_axi port=dist               offset=slave bundle=gmem_vec1
+    #pragma HLS interface m_axi port=frontier_out       offset=slave bundle=gmem_frt2
+    #pragma HLS interface m_axi port=frontier_out_size  offset=slave bundle=gmem_frt2
+
+    unsigned count = 0;
+    for (unsigned row = 0; row < num_rows; row++) {
+        #pragma HLS pipeline off
+        unsigned start = row_ptr[row];
+        unsigned end = row_ptr[row + 1];
+        float old_dist = dist[row];
+
+        float best = old_dist;
+        for (unsigned i = start; i < end; i++) {
+            #pragma HLS pipeline off
+            float d = values[i] + dist[col_idx[i]];
+            best = (d < best) ? d : best;
+        }
+        if (best < old_dist) {
+            dist[row] = best;
+            frontier_out[count++] = row;
+        }
+    }
+    frontier_out_size[0] = count;
+}
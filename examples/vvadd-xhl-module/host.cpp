@@ -88,9 +88,22 @@ int main(int argc, char** argv) {
     xhl::Module_vvadd module;
     module.initialize(devices);
     // module.bind_cu(cus_1);
-    out = module.run(in1, in2, out);
+    module.run(in1, in2, out);
     bool pass = check_ref(out, out_ref);
     std::cout << (pass ? "[INFO]: Test1 Passed !" : "[ERROR]: Test Failed!\n") 
     << std::endl;
+
+    // run again on new data, reusing the module's device buffers
+    std::generate(
+        in1.begin(), in1.end(),
+        [](){return rand() % 10;}
+    );
+    for (size_t i = 0; i < out_ref.size(); i++) {
+        out_ref[i] = in1[i] + in2[i];
+    }
+    module.run(in1, in2, out);
+    pass = check_ref(out, out_ref);
+    std::cout << (pass ? "[INFO]: Test2 Passed !" : "[ERROR]: Test Failed!\n")
+    << std::endl;
     return 0;
 }
@@ -17,27 +17,37 @@
 #define DATA_SIZE 4096
 
 namespace xhl{
-std::vector<int> Module_vvadd::run(
-    std::vector<int> in1, 
-    std::vector<int> in2,
-    std::vector<int> out
+void Module_vvadd::run(
+    const std::vector<int> &in1,
+    const std::vector<int> &in2,
+    std::vector<int> &out
     // Device &device_1
     // ComputeUnit &vvadd_cu
 ) {
     auto device_1 = this->vvadd_cu->cu_device;
+    // the inputs are read-only buffers, the device never writes through these pointers
+    void *in1_ptr = const_cast<int*>(in1.data());
+    void *in2_ptr = const_cast<int*>(in2.data());
     
-    device_1->create_buffer(
-        "in1", DATA_SIZE * sizeof(int), in1.data(),
-        xhl::BufferType::ReadOnly, xhl::boards::alveo::u280::HBM[0]
-    );
-    device_1->create_buffer(
-        "in2", DATA_SIZE * sizeof(int), in2.data(),
-        xhl::BufferType::ReadOnly, xhl::boards::alveo::u280::HBM[1]
-    );
-    device_1->create_buffer(
-        "out", DATA_SIZE * sizeof(int), out.data(),
-        xhl::BufferType::WriteOnly, xhl::boards::alveo::u280::HBM[2]
-    );
+    // buffers are kept across runs, point them to this run's data
+    if (device_1->contains_buffer("in1")) {
+        device_1->rebind_buffer("in1", DATA_SIZE * sizeof(int), in1_ptr);
+        device_1->rebind_buffer("in2", DATA_SIZE * sizeof(int), in2_ptr);
+        device_1->rebind_buffer("out", DATA_SIZE * sizeof(int), out.data());
+    } else {
+        device_1->create_buffer(
+            "in1", DATA_SIZE * sizeof(int), in1_ptr,
+            xhl::BufferType::ReadOnly, xhl::boards::alveo::u280::HBM[0]
+        );
+        device_1->create_buffer(
+            "in2", DATA_SIZE * sizeof(int), in2_ptr,
+            xhl::BufferType::ReadOnly, xhl::boards::alveo::u280::HBM[1]
+        );
+        device_1->create_buffer(
+            "out", DATA_SIZE * sizeof(int), out.data(),
+            xhl::BufferType::WriteOnly, xhl::boards::alveo::u280::HBM[2]
+        );
+    }
 
     xhl::sync_data_htod(device_1, "in1");
     xhl::sync_data_htod(device_1, "in2");
@@ -53,7 +63,6 @@ std::vector<int> Module_vvadd::run(
     device_1->finish_all_tasks();
 
     xhl::sync_data_dtoh(device_1, "out");
-    return out;
 }
 
 void Module_vvadd::initialize(std::vector<Device>& devices) {
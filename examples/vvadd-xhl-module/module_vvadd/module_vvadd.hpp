@@ -32,10 +32,10 @@ class Module_vvadd : public xhl::Module {
 
     ~Module_vvadd();
 
-    std::vector<int> run(
-        std::vector<int> in1, 
-        std::vector<int> in2,
-        std::vector<int> out
+    void run(
+        const std::vector<int> &in1,
+        const std::vector<int> &in2,
+        std::vector<int> &out
     );
 };
 } // namespace xhl
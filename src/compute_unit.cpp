@@ -2,7 +2,41 @@
 
 namespace xhl {
 
+ComputeUnit::ComputeUnit(const ComputeUnit &other)
+    : cu_device(other.cu_device), signature(other.signature), clkernel(other.clkernel),
+      command_q(other.command_q) {
+    if (this->cu_device != nullptr) {
+        this->cu_device->attach_compute_unit(this);
+    }
+}
+
+ComputeUnit &ComputeUnit::operator=(const ComputeUnit &other) {
+    if (this == &other) {
+        return *this;
+    }
+    if (this->cu_device != nullptr) {
+        this->cu_device->detach_compute_unit(this);
+    }
+    this->cu_device = other.cu_device;
+    this->signature = other.signature;
+    this->clkernel = other.clkernel;
+    this->command_q = other.command_q;
+    if (this->cu_device != nullptr) {
+        this->cu_device->attach_compute_unit(this);
+    }
+    return *this;
+}
+
+ComputeUnit::~ComputeUnit() {
+    if (this->cu_device != nullptr) {
+        this->cu_device->detach_compute_unit(this);
+    }
+}
+
 void ComputeUnit::bind (xhl::Device *d) {
+    if (this->cu_device != nullptr && this->cu_device != d) {
+        this->cu_device->detach_compute_unit(this);
+    }
     this->cu_device = d;
     // create CL kernel in compute unit
     cl_int errflag = 0;
@@ -15,6 +49,8 @@ void ComputeUnit::bind (xhl::Device *d) {
             + std::to_string(errflag) + ")"
         );
     }
+    this->command_q = this->cu_device->create_compute_queue();
+    this->cu_device->attach_compute_unit(this);
 }
 
 } // namespace xhl
\ No newline at end of file
@@ -13,6 +13,19 @@
 #include "xocl-host-lib.hpp"
 
 namespace xhl {
+/**
+ * @brief a buffer argument that a launch only reads, although the buffer is
+ * not ReadOnly (e.g., the input of a ping-pong pair). Its transfers to the
+ * host can then overlap with the launch.
+ */
+struct InputBuffer {
+    cl::Buffer buffer;
+};
+
+inline InputBuffer as_input(const cl::Buffer &buffer) {
+    return InputBuffer{buffer};
+}
+
 class ComputeUnit {
 private:
 
@@ -30,6 +43,13 @@ void __set_arg_impl(
     }
 }
 
+void __set_arg_impl(
+    const int arg_index,
+    const InputBuffer &arg_val
+) {
+    this->__set_arg_impl(arg_index, arg_val.buffer);
+}
+
 // reference: https://stackoverflow.com/a/71148253
 template <typename ...Ts, size_t ...Is>
 void __pick_arg_set(
@@ -43,10 +63,28 @@ void __set_arg(std::tuple<Ts...>& tpl, size_t idx) {
     __pick_arg_set(tpl, std::make_index_sequence<sizeof...(Ts)>{}, idx);
 }
 
+// collect the buffer arguments so the device can order the launch after their transfers
+static void __collect_buffer(
+    std::vector<cl::Buffer> &buffers, std::vector<cl::Buffer> &, const cl::Buffer &arg
+) {
+    buffers.push_back(arg);
+}
+
+static void __collect_buffer(
+    std::vector<cl::Buffer> &buffers, std::vector<cl::Buffer> &inputs, const InputBuffer &arg
+) {
+    buffers.push_back(arg.buffer);
+    inputs.push_back(arg.buffer);
+}
+
+template <typename T>
+static void __collect_buffer(std::vector<cl::Buffer> &, std::vector<cl::Buffer> &, const T &) {}
+
 public:
 xhl::Device *cu_device;
 struct xhl::KernelSignature signature;
 cl::Kernel clkernel;
+cl::CommandQueue command_q; // queue of this compute unit, created on bind
 
 ComputeUnit() = delete; // don't provide default constructor
 
@@ -59,6 +97,12 @@ ComputeUnit(const struct xhl::KernelSignature ks) : cu_device(nullptr) { // add
     this->signature = ks;
 }
 
+// a copy is registered with the device of the original
+ComputeUnit(const ComputeUnit &other);
+ComputeUnit &operator=(const ComputeUnit &other);
+
+~ComputeUnit();
+
 /**
  * @brief bind the device with the computeunit and create the cl::Kernel, which is the computeunit in our define
  *
@@ -69,12 +113,17 @@ ComputeUnit(const struct xhl::KernelSignature ks) : cu_device(nullptr) { // add
 void bind (xhl::Device *d);
 
 /**
- * @brief launch, start to run the computeunit
+ * @brief launch, start to run the computeunit. The launch waits for pending
+ * transfers of its buffer arguments, but not for unrelated commands.
  *
- * @param ... arguments of the kernel signature
+ * @param ... arguments of the kernel signature, buffers only read by this launch may be wrapped in `as_input`
+ * @return the event of the kernel, e.g., to wait for or profile this launch only
  */
 template <typename... Ts>
-void launch (Ts ... ts) {
+cl::Event launch (Ts ... ts) {
+    if (this->cu_device == nullptr) {
+        throw std::runtime_error("Compute unit " + this->signature.name + " is not bound to a programmed device");
+    }
     if (sizeof...(Ts) < this->signature.argmap.size()) {
         throw std::runtime_error("Too few arguments supplied to compute unit launch");
     }
@@ -87,7 +136,9 @@ void launch (Ts ... ts) {
     for (size_t i = 0; i < this->signature.argmap.size(); i++, ite++) {
         this->__set_arg(args, i);
     }
-    this->cu_device->command_q.enqueueTask(this->clkernel);
+    std::vector<cl::Buffer> buffers, inputs;
+    (__collect_buffer(buffers, inputs, ts), ...);
+    return this->cu_device->enqueue_task(this->command_q, this->clkernel, buffers, inputs);
 }
 
 }; // class ComputeUnit
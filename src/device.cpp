@@ -1,40 +1,52 @@
 #include "device.hpp"
 #include "compute_unit.hpp"
 #include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
 
 namespace xhl {
 
-void Device::create_buffer(
-    std::string name, size_t size, void* data_ptr, BufferType type,
-    const int memory_channel_name
-) {
-    if (this->_buffers.find(name) != this->_buffers.end()) {
-        throw std::runtime_error("Buffer name already used");
-    }
-    cl_mem_flags buffer_type_flag;
+cl_mem_flags buffer_type_flag(BufferType type) {
     switch (type) {
         case ReadOnly:
-            buffer_type_flag = CL_MEM_READ_ONLY;
-        break;
+            return CL_MEM_READ_ONLY;
         case WriteOnly:
-            buffer_type_flag = CL_MEM_WRITE_ONLY;
-        break;
+            return CL_MEM_WRITE_ONLY;
         case ReadWrite:
-            buffer_type_flag = CL_MEM_READ_WRITE;
-        break;
+            return CL_MEM_READ_WRITE;
         default:
             throw std::runtime_error("Invalid buffer type");
-        break;
     }
-    this->_ext_ptrs[name].flags = memory_channel_name;
-    this->_ext_ptrs[name].obj = data_ptr;
-    this->_ext_ptrs[name].param = 0;
+}
+
+// buffers are rounded up to 4 size classes per power of two (at most 25% waste)
+static size_t size_class(size_t size) {
+    const size_t min_class = 4096;
+    if (size <= min_class) return min_class;
+    size_t p = min_class;
+    while (p * 2 < size) p *= 2;
+    size_t step = p / 4;
+    return (size + step - 1) / step * step;
+}
+
+// pointers on a page boundary can be used in place by the runtime
+static TransferMode resolve_transfer_mode(const void *data_ptr, TransferMode mode) {
+    if (mode != Auto) return mode;
+    return (reinterpret_cast<uintptr_t>(data_ptr) % 4096 == 0) ? ZeroCopy : Staged;
+}
+
+cl::Buffer Device::_make_buffer(
+    size_t size, BufferType type, cl_mem_ext_ptr_t &ext_ptr, TransferMode mode
+) {
+    cl_mem_flags type_flag = buffer_type_flag(type);
+    cl_mem_flags host_flag = (mode == Staged) ? 0 : CL_MEM_USE_HOST_PTR;
     cl_int err = 0;
-    this->_buffers[name] = cl::Buffer(
+    cl::Buffer buffer(
         this->_context,
-        buffer_type_flag | CL_MEM_EXT_PTR_XILINX | CL_MEM_USE_HOST_PTR,
+        type_flag | CL_MEM_EXT_PTR_XILINX | host_flag,
         size,
-        &(this->_ext_ptrs[name]),
+        &ext_ptr,
         &(err)
     );
     if (err) {
@@ -43,6 +55,578 @@ void Device::create_buffer(
             " with error code " + std::to_string(err)
         );
     }
+    return buffer;
+}
+
+void Device::_insert_buffer(
+    const std::string &name, const cl::Buffer &buffer, const cl_mem_ext_ptr_t &ext_ptr,
+    const _BufferInfo &info
+) {
+    this->_ext_ptrs[name] = ext_ptr;
+    this->_buffers[name] = buffer;
+    this->_buffer_info[name] = info;
+    this->_dependencies[buffer()] = {info.type == ReadOnly, {}, {}, 0, size_t(info.size), buffer};
+}
+
+static bool is_complete(const cl::Event &event) {
+    cl_int status = -1;
+    event.getInfo(CL_EVENT_COMMAND_EXECUTION_STATUS, &status);
+    return status == CL_COMPLETE;
+}
+
+cl::CommandQueue Device::_make_queue() {
+    cl_int err = 0;
+    cl::CommandQueue q(
+        this->_context, this->_device,
+        CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE | CL_QUEUE_PROFILING_ENABLE,
+        &(err)
+    );
+    if (err != CL_SUCCESS) {
+        throw std::runtime_error("[ERROR]: Failed to create command queue, exit!\n");
+    }
+    return q;
+}
+
+cl_mem Device::_parent(const cl::Buffer &buffer) {
+    cl_mem parent = nullptr;
+    clGetMemObjectInfo(buffer(), CL_MEM_ASSOCIATED_MEMOBJECT, sizeof(cl_mem), &parent, nullptr);
+    return parent;
+}
+
+Device::_Dependency &Device::_dependency(const cl::Buffer &buffer) {
+    auto ite = this->_dependencies.find(buffer());
+    if (ite != this->_dependencies.end()) {
+        return ite->second;
+    }
+    // first command on a sub-buffer: track its region, with the access of its parent
+    cl_mem parent = this->_parent(buffer);
+    _Dependency dep = {false, {}, {}, 0, 0, buffer};
+    if (parent) {
+        auto parent_dep = this->_dependencies.find(parent);
+        dep.read_only = parent_dep != this->_dependencies.end() && parent_dep->second.read_only;
+        clGetMemObjectInfo(buffer(), CL_MEM_OFFSET, sizeof(size_t), &dep.offset, nullptr);
+        clGetMemObjectInfo(buffer(), CL_MEM_SIZE, sizeof(size_t), &dep.size, nullptr);
+        this->_prune_sub_buffers(parent);
+        this->_sub_buffers[parent].push_back(buffer());
+    }
+    return this->_dependencies[buffer()] = dep;
+}
+
+void Device::_prune_sub_buffers(cl_mem parent) {
+    // forget the sub-buffers only this device still holds and with no command left, e.g., the
+    // short-lived views created per level or chunk
+    auto subs = this->_sub_buffers.find(parent);
+    if (subs == this->_sub_buffers.end()) {
+        return;
+    }
+    auto idle = [&](cl_mem sub) {
+        auto dep = this->_dependencies.find(sub);
+        if (dep == this->_dependencies.end()) {
+            return true;
+        }
+        cl_uint references = 0;
+        clGetMemObjectInfo(sub, CL_MEM_REFERENCE_COUNT, sizeof(cl_uint), &references, nullptr);
+        if (references > 1
+            || !std::all_of(dep->second.writes.begin(), dep->second.writes.end(), is_complete)
+            || !std::all_of(dep->second.reads.begin(), dep->second.reads.end(), is_complete)) {
+            return false;
+        }
+        this->_dependencies.erase(dep);
+        return true;
+    };
+    subs->second.erase(std::remove_if(subs->second.begin(), subs->second.end(), idle), subs->second.end());
+}
+
+std::vector<cl::Event> Device::_wait_list(const cl::Buffer &buffer, bool write) {
+    // reads wait for the last write, writes also wait for the reads since then
+    std::vector<cl::Event> wait_list;
+    auto add = [&](const _Dependency &dep) {
+        wait_list.insert(wait_list.end(), dep.writes.begin(), dep.writes.end());
+        if (write) {
+            wait_list.insert(wait_list.end(), dep.reads.begin(), dep.reads.end());
+        }
+    };
+    const _Dependency &own = this->_dependency(buffer);
+    add(own);
+    // a sub-buffer is ordered against the commands on its whole parent and on the sub-buffers
+    // overlapping it, a whole buffer against the commands on all its sub-buffers
+    cl_mem parent = this->_parent(buffer);
+    cl_mem key = parent ? parent : buffer();
+    if (parent) {
+        auto parent_dep = this->_dependencies.find(parent);
+        if (parent_dep != this->_dependencies.end()) {
+            add(parent_dep->second);
+        }
+    }
+    auto subs = this->_sub_buffers.find(key);
+    if (subs != this->_sub_buffers.end()) {
+        for (cl_mem sub : subs->second) {
+            if (sub == buffer()) continue;
+            const _Dependency &dep = this->_dependencies.at(sub);
+            if (!parent || (dep.offset < own.offset + own.size && own.offset < dep.offset + dep.size)) {
+                add(dep);
+            }
+        }
+    }
+    return wait_list;
+}
+
+static void drop_complete(std::vector<cl::Event> &events) {
+    events.erase(std::remove_if(events.begin(), events.end(), is_complete), events.end());
+}
+
+void Device::_record(const cl::Buffer &buffer, bool write, const std::vector<cl::Event> &events) {
+    _Dependency &dep = this->_dependency(buffer);
+    if (write) {
+        dep.writes = events;
+        dep.reads.clear();
+        return;
+    }
+    // buffers read every iteration would collect events forever, drop finished ones
+    if (dep.reads.size() > 64) {
+        drop_complete(dep.reads);
+    }
+    dep.reads.insert(dep.reads.end(), events.begin(), events.end());
+}
+
+void Device::_complete_reads(bool wait) {
+    auto ite = this->_pending_reads.begin();
+    while (ite != this->_pending_reads.end()) {
+        if (wait) {
+            ite->event.wait();
+        } else if (!is_complete(ite->event)) {
+            ite++;
+            continue;
+        }
+        std::memcpy(ite->dst, ite->block.ptr, ite->size);
+        this->_staging.release(ite->block);
+        ite = this->_pending_reads.erase(ite);
+    }
+}
+
+void Device::create_buffer(
+    std::string name, size_t size, void* data_ptr, BufferType type,
+    const int memory_channel_name, TransferMode mode
+) {
+    if (this->_buffers.find(name) != this->_buffers.end()) {
+        throw std::runtime_error("Buffer name already used");
+    }
+    mode = resolve_transfer_mode(data_ptr, mode);
+    cl_mem_ext_ptr_t ext_ptr;
+    ext_ptr.flags = memory_channel_name;
+    ext_ptr.obj = (mode == Staged) ? nullptr : data_ptr;
+    ext_ptr.param = 0;
+    cl::Buffer buffer = this->_make_buffer(size, type, ext_ptr, mode);
+    this->_insert_buffer(
+        name, buffer, ext_ptr, {size, size, type, memory_channel_name, mode, data_ptr, nullptr}
+    );
+}
+
+void Device::create_buffer(
+    std::string name, size_t size, BufferType type, const int memory_channel_name
+) {
+    if (this->_buffers.find(name) != this->_buffers.end()) {
+        throw std::runtime_error("Buffer name already used");
+    }
+    size_t capacity = size_class(size);
+    auto free_list = this->_free_buffers.find(
+        std::make_tuple(memory_channel_name, (int)type, capacity)
+    );
+    if (free_list != this->_free_buffers.end() && !free_list->second.empty()) {
+        _FreeBuffer reused = free_list->second.back();
+        free_list->second.pop_back();
+        this->_insert_buffer(
+            name, reused.buffer, reused.ext_ptr,
+            {size, capacity, type, memory_channel_name, ZeroCopy, reused.storage->data(), reused.storage}
+        );
+        return;
+    }
+
+    auto storage = std::make_shared<aligned_vector<char>>(capacity);
+    cl_mem_ext_ptr_t ext_ptr;
+    ext_ptr.flags = memory_channel_name;
+    ext_ptr.obj = storage->data();
+    ext_ptr.param = 0;
+    cl::Buffer buffer = this->_make_buffer(capacity, type, ext_ptr);
+    this->_insert_buffer(
+        name, buffer, ext_ptr, {size, capacity, type, memory_channel_name, ZeroCopy, storage->data(), storage}
+    );
+}
+
+void Device::release_buffer(const std::string &name) {
+    auto info = this->_buffer_info.find(name);
+    if (info == this->_buffer_info.end()) {
+        throw std::runtime_error("Buffer " + name + " does not exist");
+    }
+    if (info->second.storage) {
+        this->_free_buffers[std::make_tuple(
+            info->second.memory_channel_name, (int)info->second.type, info->second.capacity
+        )].push_back({this->_buffers[name], this->_ext_ptrs[name], info->second.storage});
+    }
+    cl_mem mem = this->_buffers[name]();
+    auto subs = this->_sub_buffers.find(mem);
+    if (subs != this->_sub_buffers.end()) {
+        for (cl_mem sub : subs->second) {
+            this->_dependencies.erase(sub);
+        }
+        this->_sub_buffers.erase(subs);
+    }
+    this->_dependencies.erase(mem);
+    this->_buffer_info.erase(info);
+    this->_buffers.erase(name);
+    this->_ext_ptrs.erase(name);
+}
+
+void Device::_fold_sub_buffer(cl_mem parent, cl_mem sub) {
+    auto dep = this->_dependencies.find(sub);
+    if (dep == this->_dependencies.end()) {
+        return;
+    }
+    auto parent_dep = this->_dependencies.find(parent);
+    if (parent_dep != this->_dependencies.end()) {
+        drop_complete(dep->second.writes);
+        drop_complete(dep->second.reads);
+        std::vector<cl::Event> &writes = parent_dep->second.writes;
+        std::vector<cl::Event> &reads = parent_dep->second.reads;
+        writes.insert(writes.end(), dep->second.writes.begin(), dep->second.writes.end());
+        reads.insert(reads.end(), dep->second.reads.begin(), dep->second.reads.end());
+    }
+    this->_dependencies.erase(dep);
+}
+
+void Device::release_sub_buffer(const cl::Buffer &sub_buffer) {
+    cl_mem parent = this->_parent(sub_buffer);
+    auto subs = this->_sub_buffers.find(parent);
+    if (!parent || subs == this->_sub_buffers.end()) {
+        return;
+    }
+    auto ite = std::find(subs->second.begin(), subs->second.end(), sub_buffer());
+    if (ite == subs->second.end()) {
+        return;
+    }
+    this->_fold_sub_buffer(parent, sub_buffer());
+    subs->second.erase(ite);
+}
+
+void Device::release_sub_buffers(const cl::Buffer &buffer) {
+    auto subs = this->_sub_buffers.find(buffer());
+    if (subs == this->_sub_buffers.end()) {
+        return;
+    }
+    for (cl_mem sub : subs->second) {
+        this->_fold_sub_buffer(buffer(), sub);
+    }
+    this->_sub_buffers.erase(subs);
+}
+
+void Device::resize_buffer(const std::string &name, size_t size) {
+    auto info = this->_buffer_info.find(name);
+    if (info == this->_buffer_info.end()) {
+        throw std::runtime_error("Buffer " + name + " does not exist");
+    }
+    if (!info->second.storage) {
+        throw std::runtime_error(
+            "Buffer " + name + " uses a caller-owned host pointer, rebind it instead"
+        );
+    }
+    if (size <= info->second.capacity) {
+        info->second.size = size;
+        return;
+    }
+
+    // reallocate, keeping the old storage alive until its data is copied
+    _BufferInfo old = info->second;
+    this->release_buffer(name);
+    this->create_buffer(name, size, old.type, old.memory_channel_name);
+    char *dst = static_cast<char*>(this->host_ptr(name));
+    std::copy(old.storage->begin(), old.storage->begin() + old.size, dst);
+}
+
+void Device::rebind_buffer(
+    const std::string &name, size_t size, void* data_ptr, TransferMode mode
+) {
+    auto info = this->_buffer_info.find(name);
+    if (info == this->_buffer_info.end()) {
+        throw std::runtime_error("Buffer " + name + " does not exist");
+    }
+    mode = resolve_transfer_mode(data_ptr, mode);
+    _BufferInfo old = info->second;
+    // a staged buffer does not depend on the host pointer, keep it
+    if (mode == Staged && old.mode == Staged && size == old.size) {
+        info->second.host_ptr = data_ptr;
+        return;
+    }
+    cl_mem_ext_ptr_t ext_ptr;
+    ext_ptr.flags = old.memory_channel_name;
+    ext_ptr.obj = (mode == Staged) ? nullptr : data_ptr;
+    ext_ptr.param = 0;
+    cl::Buffer buffer = this->_make_buffer(size, old.type, ext_ptr, mode);
+    this->release_buffer(name);
+    this->_insert_buffer(
+        name, buffer, ext_ptr, {size, size, old.type, old.memory_channel_name, mode, data_ptr, nullptr}
+    );
+}
+
+void Device::enqueue_htod(const std::string &name) {
+    auto info = this->_buffer_info.find(name);
+    if (info == this->_buffer_info.end()) {
+        throw std::runtime_error("Buffer " + name + " does not exist");
+    }
+    cl::Buffer buffer = this->_buffers[name];
+    if (info->second.mode == ZeroCopy) {
+        this->enqueue_htod(buffer);
+        return;
+    }
+    this->enqueue_htod(name, {{0, info->second.size}});
+}
+
+void Device::enqueue_htod(const std::string &name, const std::vector<ByteRange> &ranges) {
+    auto info = this->_buffer_info.find(name);
+    if (info == this->_buffer_info.end()) {
+        throw std::runtime_error("Buffer " + name + " does not exist");
+    }
+    for (const ByteRange &range : ranges) {
+        if (range.offset + range.size > info->second.size) {
+            throw std::runtime_error("Byte range out of buffer " + name);
+        }
+    }
+    if (ranges.empty()) {
+        return;
+    }
+    cl::Buffer buffer = this->_buffers[name];
+    const char *src = static_cast<const char*>(info->second.host_ptr);
+    std::vector<cl::Event> wait_list = this->_wait_list(buffer, true);
+    std::vector<cl::Event> events;
+    // the staging block being filled, the offset of its free space and the writes reading from it
+    StagingBlock block;
+    size_t block_used = 0;
+    std::vector<cl::Event> block_events;
+    auto retire_block = [&]() {
+        if (block.ptr == nullptr) {
+            return;
+        }
+        if (block_events.empty()) {
+            this->_staging.release(block);
+        } else if (block_events.size() == 1) {
+            this->_staging.retire(block, block_events[0]);
+        } else {
+            // the queue is out of order, the block is free once all its writes are done
+            cl::Event marker;
+            this->h2d_q.enqueueMarkerWithWaitList(&block_events, &marker);
+            this->_staging.retire(block, marker);
+        }
+        block = StagingBlock();
+        block_used = 0;
+        block_events.clear();
+    };
+    for (const ByteRange &range : ranges) {
+        if (info->second.mode == ZeroCopy) {
+            // the host data backs the buffer, write the range from it directly
+            cl::Event event;
+            cl_int err = this->h2d_q.enqueueWriteBuffer(
+                buffer, CL_FALSE, range.offset, range.size, src + range.offset, &wait_list, &event
+            );
+            if (err != CL_SUCCESS) {
+                throw std::runtime_error(
+                    "Failed to write data for buffer to device (code:"
+                    + std::to_string(err) + ")"
+                );
+            }
+            events.push_back(event);
+            continue;
+        }
+        // copy through pinned blocks, the caller data may be reused right after. Ranges are packed
+        // one after the other in the current block, a new block is only taken once it is full
+        size_t end = range.offset + range.size;
+        for (size_t offset = range.offset; offset < end;) {
+            if (block_used == this->_staging.block_size()) {
+                retire_block();
+            }
+            if (block.ptr == nullptr) {
+                block = this->_staging.acquire();
+            }
+            size_t n = std::min(this->_staging.block_size() - block_used, end - offset);
+            char *staged = static_cast<char*>(block.ptr) + block_used;
+            std::memcpy(staged, src + offset, n);
+            cl::Event event;
+            cl_int err = this->h2d_q.enqueueWriteBuffer(
+                buffer, CL_FALSE, offset, n, staged, &wait_list, &event
+            );
+            if (err != CL_SUCCESS) {
+                retire_block();
+                throw std::runtime_error(
+                    "Failed to write data for buffer to device (code:"
+                    + std::to_string(err) + ")"
+                );
+            }
+            block_events.push_back(event);
+            events.push_back(event);
+            block_used += n;
+            offset += n;
+        }
+    }
+    retire_block();
+    this->_record(buffer, true, events);
+}
+
+void Device::enqueue_dtoh(const std::string &name) {
+    auto info = this->_buffer_info.find(name);
+    if (info == this->_buffer_info.end()) {
+        throw std::runtime_error("Buffer " + name + " does not exist");
+    }
+    cl::Buffer buffer = this->_buffers[name];
+    if (info->second.mode == ZeroCopy) {
+        this->enqueue_dtoh(buffer);
+        return;
+    }
+
+    char *dst = static_cast<char*>(info->second.host_ptr);
+    size_t size = info->second.size;
+    std::vector<cl::Event> wait_list = this->_wait_list(buffer, false);
+    std::vector<cl::Event> events;
+    for (size_t offset = 0; offset < size; offset += this->_staging.block_size()) {
+        size_t n = std::min(this->_staging.block_size(), size - offset);
+        StagingBlock block = this->_staging.acquire();
+        cl::Event event;
+        cl_int err = this->d2h_q.enqueueReadBuffer(
+            buffer, CL_FALSE, offset, n, block.ptr, &wait_list, &event
+        );
+        if (err != CL_SUCCESS) {
+            this->_staging.release(block);
+            throw std::runtime_error(
+                "Failed to read data for buffer from device (code:"
+                + std::to_string(err) + ")"
+            );
+        }
+        this->_pending_reads.push_back({block, event, dst + offset, n});
+        events.push_back(event);
+    }
+    this->_record(buffer, false, events);
+}
+
+cl::Event Device::enqueue_htod(const cl::Buffer &buffer) {
+    std::vector<cl::Event> wait_list = this->_wait_list(buffer, true);
+    cl::Event event;
+    cl_int err = this->h2d_q.enqueueMigrateMemObjects(
+        {buffer},
+        0 /* 0 means from host */,
+        &wait_list, &event
+    );
+    if (err != CL_SUCCESS) {
+        throw std::runtime_error(
+            "Failed to migrate data for buffer to device (code:"
+            + std::to_string(err) + ")"
+        );
+    }
+    this->_record(buffer, true, {event});
+    return event;
+}
+
+cl::Event Device::enqueue_dtoh(const cl::Buffer &buffer) {
+    std::vector<cl::Event> wait_list = this->_wait_list(buffer, false);
+    cl::Event event;
+    cl_int err = this->d2h_q.enqueueMigrateMemObjects(
+        {buffer},
+        CL_MIGRATE_MEM_OBJECT_HOST,
+        &wait_list, &event
+    );
+    if (err != CL_SUCCESS) {
+        throw std::runtime_error(
+            "Failed to migrate data for buffer to host (code:"
+            + std::to_string(err) + ")"
+        );
+    }
+    this->_record(buffer, false, {event});
+    return event;
+}
+
+cl::CommandQueue Device::create_compute_queue() {
+    cl::CommandQueue q = this->_make_queue();
+    this->_compute_queues.push_back(q);
+    return q;
+}
+
+void Device::attach_compute_unit(ComputeUnit *cu) {
+    if (std::find(this->_compute_units.begin(), this->_compute_units.end(), cu) == this->_compute_units.end()) {
+        this->_compute_units.push_back(cu);
+    }
+}
+
+void Device::detach_compute_unit(ComputeUnit *cu) {
+    this->_compute_units.erase(
+        std::remove(this->_compute_units.begin(), this->_compute_units.end(), cu), this->_compute_units.end()
+    );
+}
+
+cl::Event Device::enqueue_task(
+    const cl::CommandQueue &command_q, const cl::Kernel &kernel,
+    const std::vector<cl::Buffer> &buffers, const std::vector<cl::Buffer> &inputs
+) {
+    std::vector<cl::Event> wait_list;
+    std::vector<bool> writes;
+    for (auto &buffer : buffers) {
+        bool write = !this->_dependency(buffer).read_only && std::none_of(
+            inputs.begin(), inputs.end(), [&](const cl::Buffer &in) { return in() == buffer(); }
+        );
+        std::vector<cl::Event> deps = this->_wait_list(buffer, write);
+        wait_list.insert(wait_list.end(), deps.begin(), deps.end());
+        writes.push_back(write);
+    }
+    cl::Event event;
+    cl_int err = command_q.enqueueTask(kernel, &wait_list, &event);
+    if (err != CL_SUCCESS) {
+        throw std::runtime_error(
+            "[ERROR]: Failed to enqueue CL Kernel, exit! (code:"
+            + std::to_string(err) + ")"
+        );
+    }
+    for (size_t i = 0; i < buffers.size(); i++) {
+        this->_record(buffers[i], writes[i], {event});
+    }
+    return event;
+}
+
+void Device::wait_buffer(const std::string &name) {
+    if (!this->contains_buffer(name)) {
+        throw std::runtime_error("Buffer " + name + " does not exist");
+    }
+    this->wait_buffer(this->_buffers[name]);
+}
+
+void Device::wait_buffer(const cl::Buffer &buffer) {
+    for (auto &event : this->_wait_list(buffer, true)) {
+        event.wait();
+    }
+    this->_complete_reads(false);
+    this->_staging.reclaim();
+}
+
+TransferMode Device::transfer_mode(const std::string &name) {
+    auto info = this->_buffer_info.find(name);
+    if (info == this->_buffer_info.end()) {
+        throw std::runtime_error("Buffer " + name + " does not exist");
+    }
+    return info->second.mode;
+}
+
+void Device::trim_free_buffers() {
+    this->_free_buffers.clear();
+}
+
+size_t Device::buffer_size(const std::string &name) {
+    auto info = this->_buffer_info.find(name);
+    if (info == this->_buffer_info.end()) {
+        throw std::runtime_error("Buffer " + name + " does not exist");
+    }
+    return info->second.size;
+}
+
+void* Device::host_ptr(const std::string &name) {
+    auto info = this->_buffer_info.find(name);
+    if (info == this->_buffer_info.end()) {
+        throw std::runtime_error("Buffer " + name + " does not exist");
+    }
+    return info->second.host_ptr;
 }
 
 void Device::bind_device(cl::Device cl_device) {
@@ -76,14 +660,24 @@ void Device::program_device(
         throw std::runtime_error("[ERROR]: Load bitstream failed, exit!\n");
     }
 
-    err = 0;
-    this->command_q = cl::CommandQueue(
-        this->_context, this->_device,
-        CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE | CL_QUEUE_PROFILING_ENABLE,
-        &(err)
-    );
-    if (err != CL_SUCCESS) {
-        throw std::runtime_error("[ERROR]: Failed to create command queue, exit!\n");
+    // separate queues let uploads, readbacks and kernels overlap
+    this->command_q = this->_make_queue();
+    this->h2d_q = this->_make_queue();
+    this->d2h_q = this->_make_queue();
+    this->_compute_queues.clear();
+    this->_dependencies.clear();
+    this->_sub_buffers.clear();
+    this->_staging.bind(this->_context, this->command_q);
+
+    // the kernels and queues of the bound compute units belong to the old program and context
+    std::vector<ComputeUnit*> units;
+    units.swap(this->_compute_units);
+    for (ComputeUnit *cu : units) {
+        try {
+            cu->bind(this);
+        } catch (const std::runtime_error &) {
+            cu->cu_device = nullptr;
+        }
     }
 }
 
@@ -124,52 +718,91 @@ std::vector<Device> find_devices(const xhl::BoardIdentifier &identifier) {
 }
 
 void Device::finish_all_tasks() {
-    cl_int err = this->command_q.finish();
-    if (err != CL_SUCCESS) {
-        throw std::runtime_error(
-            "[ERROR]: Failed to finish all tasks, exit! (code:"
-            + std::to_string(err) + ")"
-        );
+    std::vector<cl::CommandQueue> queues = {this->command_q, this->h2d_q, this->d2h_q};
+    queues.insert(queues.end(), this->_compute_queues.begin(), this->_compute_queues.end());
+    for (auto &q : queues) {
+        cl_int err = q.finish();
+        if (err != CL_SUCCESS) {
+            throw std::runtime_error(
+                "[ERROR]: Failed to finish all tasks, exit! (code:"
+                + std::to_string(err) + ")"
+            );
+        }
+    }
+    this->_complete_reads(true);
+    this->_staging.reclaim();
+    // everything completed, no command needs to wait for older events. The sub-buffers are
+    // forgotten too, they are tracked again on their next command.
+    for (auto &subs : this->_sub_buffers) {
+        for (cl_mem sub : subs.second) {
+            this->_dependencies.erase(sub);
+        }
+    }
+    this->_sub_buffers.clear();
+    for (auto &dep : this->_dependencies) {
+        dep.second.writes.clear();
+        dep.second.reads.clear();
     }
 }
 
-void nb_sync_data_htod(xhl::Device* device, const std::string &buffer_name) {
-    cl_int err = device->command_q.enqueueMigrateMemObjects(
-        {device->get_buffer(buffer_name)},
-        0 /* 0 means from host */
-    );
-    if (err != CL_SUCCESS) {
-        throw std::runtime_error(
-            "Failed to migrate data for buffer to device (code:"
-            + std::to_string(err) + ")"
-        );
+void Device::finish_compute_tasks() {
+    for (auto &q : this->_compute_queues) {
+        cl_int err = q.finish();
+        if (err != CL_SUCCESS) {
+            throw std::runtime_error(
+                "[ERROR]: Failed to finish compute tasks, exit! (code:"
+                + std::to_string(err) + ")"
+            );
+        }
     }
 }
 
+void nb_sync_data_htod(xhl::Device* device, const std::string &buffer_name) {
+    device->enqueue_htod(buffer_name);
+}
+
 
 void nb_sync_data_dtoh(xhl::Device* device, const std::string &buffer_name) {
-    cl_int err = device->command_q.enqueueMigrateMemObjects(
-        {device->get_buffer(buffer_name)},
-        CL_MIGRATE_MEM_OBJECT_HOST
-    );
-    if (err != CL_SUCCESS) {
-        throw std::runtime_error(
-            "Failed to migrate data for buffer to device (code:"
-            + std::to_string(err) + ")"
-        );
-    }
+    device->enqueue_dtoh(buffer_name);
+}
+
+
+void nb_sync_data_htod(xhl::Device* device, const std::string &buffer_name, const std::vector<ByteRange> &ranges) {
+    device->enqueue_htod(buffer_name, ranges);
 }
 
 
 void sync_data_htod(xhl::Device* device, const std::string &buffer_name) {
     nb_sync_data_htod(device, buffer_name);
-    device->command_q.finish();
+    device->wait_buffer(buffer_name);
 }
 
 
 void sync_data_dtoh(xhl::Device* device, const std::string &buffer_name) {
     nb_sync_data_dtoh(device, buffer_name);
-    device->command_q.finish();
+    device->wait_buffer(buffer_name);
+}
+
+
+void nb_sync_data_htod(xhl::Device* device, const cl::Buffer &buffer) {
+    device->enqueue_htod(buffer);
+}
+
+
+void nb_sync_data_dtoh(xhl::Device* device, const cl::Buffer &buffer) {
+    device->enqueue_dtoh(buffer);
+}
+
+
+void sync_data_htod(xhl::Device* device, const cl::Buffer &buffer) {
+    nb_sync_data_htod(device, buffer);
+    device->wait_buffer(buffer);
+}
+
+
+void sync_data_dtoh(xhl::Device* device, const cl::Buffer &buffer) {
+    nb_sync_data_dtoh(device, buffer);
+    device->wait_buffer(buffer);
 }
 
 } // namespace xhl
\ No newline at end of file
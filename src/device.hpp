@@ -3,12 +3,16 @@
 
 #include <vector>
 #include <unordered_map>
+#include <map>
+#include <tuple>
+#include <memory>
 #include <iostream>
 #include <string>
 
 #include "xcl2.hpp"
 
 #include "xocl-host-lib.hpp"
+#include "staging_pool.hpp"
 
 namespace xhl {
 class ComputeUnit;
@@ -18,11 +22,79 @@ private:
 cl::Device _device;
 cl::Context _context;
 
+// bookkeeping of a live buffer
+struct _BufferInfo {
+    size_t size; // requested size in bytes
+    size_t capacity; // allocated size in bytes
+    BufferType type;
+    int memory_channel_name;
+    TransferMode mode; // ZeroCopy or Staged, never Auto
+    void *host_ptr; // host data of the buffer
+    std::shared_ptr<aligned_vector<char>> storage; // host storage owned by the device, null if caller-owned
+};
+
+// a staged readback waiting for its transfer to complete
+struct _PendingRead {
+    StagingBlock block;
+    cl::Event event;
+    void *dst;
+    size_t size;
+};
+
+// events of the pending commands touching a buffer, used to order commands across queues. A
+// sub-buffer has its own events, so that commands on disjoint regions of a parent do not wait
+// for each other.
+struct _Dependency {
+    bool read_only; // kernels only read the buffer
+    std::vector<cl::Event> writes; // commands writing the device copy
+    std::vector<cl::Event> reads; // commands reading the device copy since the last write
+    size_t offset; // region of a sub-buffer in its parent, in bytes
+    size_t size;
+    cl::Buffer handle; // retained, so the cl_mem key is not reused while it is tracked
+};
+
+// a released device-owned buffer kept for reuse
+struct _FreeBuffer {
+    cl::Buffer buffer;
+    cl_mem_ext_ptr_t ext_ptr;
+    std::shared_ptr<aligned_vector<char>> storage;
+};
+// (memory channel, buffer type, capacity) -> released buffers
+using _FreeKey = std::tuple<int, int, size_t>;
+
 std::unordered_map<std::string, cl_mem_ext_ptr_t> _ext_ptrs;
 std::unordered_map<std::string, cl::Buffer> _buffers;
+std::unordered_map<std::string, _BufferInfo> _buffer_info;
+std::map<_FreeKey, std::vector<_FreeBuffer>> _free_buffers;
+
+StagingPool _staging;
+std::vector<_PendingRead> _pending_reads;
+
+std::unordered_map<cl_mem, _Dependency> _dependencies;
+std::unordered_map<cl_mem, std::vector<cl_mem>> _sub_buffers; // parent -> sub-buffers with events
+std::vector<cl::CommandQueue> _compute_queues;
+std::vector<ComputeUnit*> _compute_units; // bound compute units, rebound when the device is reprogrammed
+
+cl::Buffer _make_buffer(
+    size_t size, BufferType type, cl_mem_ext_ptr_t &ext_ptr, TransferMode mode = ZeroCopy
+);
+void _insert_buffer(
+    const std::string &name, const cl::Buffer &buffer, const cl_mem_ext_ptr_t &ext_ptr,
+    const _BufferInfo &info
+);
+cl::CommandQueue _make_queue();
+cl_mem _parent(const cl::Buffer &buffer); // the buffer a sub-buffer was created from, null otherwise
+_Dependency &_dependency(const cl::Buffer &buffer);
+void _prune_sub_buffers(cl_mem parent);
+void _fold_sub_buffer(cl_mem parent, cl_mem sub);
+std::vector<cl::Event> _wait_list(const cl::Buffer &buffer, bool write);
+void _record(const cl::Buffer &buffer, bool write, const std::vector<cl::Event> &events);
+void _complete_reads(bool wait);
 
 public:
-cl::CommandQueue command_q; // used to queue tasks
+cl::CommandQueue command_q; // used to queue general tasks (e.g., mapping staging blocks)
+cl::CommandQueue h2d_q; // used to queue host to device transfers
+cl::CommandQueue d2h_q; // used to queue device to host transfers
 cl::Program program; // used to create kernel
 
 /**
@@ -41,6 +113,7 @@ void bind_device(cl::Device cl_device);
  * @param type the BufferType: ReadOnly, WriteOnly, and ReadWrite
  * @param memory_channel_name should be an int from an array in of a particular board under xhl::boards
  * (e.g., xhl::boards::alveo::u280::DDR[0])
+ * @param mode how data is moved, by default picked from the alignment of `data_ptr`
  *
  * @exception std::runtime_error if the underlying xocl call fails
  * @exception std::runtime_error if the buffer type is wrong
@@ -48,9 +121,227 @@ void bind_device(cl::Device cl_device);
  */
 void create_buffer(
     std::string name, size_t size, void* data_ptr, BufferType type,
-    const int memory_channel_name
+    const int memory_channel_name, TransferMode mode = Auto
+);
+
+
+/**
+ * @brief create a buffer whose host storage is owned by the device. The
+ * storage is 4KB aligned and rounded up to a size class, so released buffers
+ * of the same class, bank and type are reused without a new allocation.
+ * Use `host_ptr` to fill or read the data.
+ *
+ * @param name the argument name
+ * @param size the size of the buffer in bytes
+ * @param type the BufferType: ReadOnly, WriteOnly, and ReadWrite
+ * @param memory_channel_name should be an int from an array in of a particular board under xhl::boards
+ *
+ * @exception std::runtime_error if the underlying xocl call fails
+ * @exception std::runtime_error if the buffer name is already used
+ */
+void create_buffer(
+    std::string name, size_t size, BufferType type, const int memory_channel_name
+);
+
+/**
+ * @brief release a buffer so that its name can be used again. Device-owned
+ * buffers are kept in a free list for reuse by later `create_buffer` calls.
+ * The caller must make sure no pending task uses the buffer.
+ *
+ * @param name the name of the buffer to release
+ *
+ * @exception std::runtime_error if there is no buffer with this name
+ */
+void release_buffer(const std::string &name);
+
+/**
+ * @brief stop tracking a sub-buffer that will not be used again (e.g., one
+ * returned to a `MemoryArena`). Its pending tasks are kept as tasks on the
+ * parent buffer, so later sub-buffers of the same region still wait for them.
+ *
+ * @param sub_buffer the sub-buffer
+ */
+void release_sub_buffer(const cl::Buffer &sub_buffer);
+
+/**
+ * @brief stop tracking all the sub-buffers of a buffer, see `release_sub_buffer`
+ *
+ * @param buffer the parent buffer
+ */
+void release_sub_buffers(const cl::Buffer &buffer);
+
+/**
+ * @brief change the size of a device-owned buffer. The buffer grows in place
+ * if its size class is large enough, otherwise it is reallocated and the host
+ * data is copied over. Sync the buffer to the host first if the device holds
+ * newer data, and to the device afterwards.
+ *
+ * @param name the name of the buffer to resize
+ * @param size the new size in bytes
+ *
+ * @exception std::runtime_error if there is no buffer with this name
+ * @exception std::runtime_error if the buffer uses a caller-owned host pointer (use `rebind_buffer`)
+ */
+void resize_buffer(const std::string &name, size_t size);
+
+/**
+ * @brief point an existing buffer to a new caller-owned host pointer, keeping
+ * its bank and type. The underlying cl::Buffer is recreated, except for a
+ * staged buffer whose size does not change.
+ *
+ * @param name the name of the buffer to rebind
+ * @param size the size of the new host data in bytes
+ * @param data_ptr the pointer to the new host data
+ * @param mode how data is moved, by default picked from the alignment of `data_ptr`
+ *
+ * @exception std::runtime_error if there is no buffer with this name
+ * @exception std::runtime_error if the underlying xocl call fails
+ */
+void rebind_buffer(
+    const std::string &name, size_t size, void* data_ptr, TransferMode mode = Auto
 );
 
+/**
+ * @brief enqueue the transfer of a buffer's host data to the device
+ *
+ * @param name the name of the buffer
+ *
+ * @exception std::runtime_error if the transfer cannot be enqueued
+ */
+void enqueue_htod(const std::string &name);
+
+/**
+ * @brief enqueue the transfer of some byte ranges of a buffer's host data to
+ * the device, e.g., the entries changed since the last transfer. The rest of
+ * the device copy is left untouched.
+ *
+ * @param name the name of the buffer
+ * @param ranges the byte ranges to transfer, within the buffer size
+ *
+ * @exception std::runtime_error if there is no buffer with this name
+ * @exception std::runtime_error if a range is out of the buffer
+ * @exception std::runtime_error if the transfer cannot be enqueued
+ */
+void enqueue_htod(const std::string &name, const std::vector<ByteRange> &ranges);
+
+/**
+ * @brief enqueue the transfer of a buffer's device data to the host. Staged
+ * data reaches the caller pointer in `finish_all_tasks`.
+ *
+ * @param name the name of the buffer
+ *
+ * @exception std::runtime_error if the transfer cannot be enqueued
+ */
+void enqueue_dtoh(const std::string &name);
+
+/**
+ * @brief enqueue the migration of an unnamed buffer to the device. A
+ * sub-buffer is ordered against the commands touching its parent buffer.
+ *
+ * @param buffer
+ * @return the event of the migration
+ *
+ * @exception std::runtime_error if the transfer cannot be enqueued
+ */
+cl::Event enqueue_htod(const cl::Buffer &buffer);
+
+/**
+ * @brief enqueue the migration of an unnamed buffer to the host. A
+ * sub-buffer is ordered against the commands touching its parent buffer,
+ * e.g., reading back a chunk waits for the kernel writing the parent.
+ *
+ * @param buffer
+ * @return the event of the migration, e.g., to wait for this chunk only
+ *
+ * @exception std::runtime_error if the transfer cannot be enqueued
+ */
+cl::Event enqueue_dtoh(const cl::Buffer &buffer);
+
+/**
+ * @brief create a command queue for a compute unit. The queue is waited on
+ * by `finish_compute_tasks` and `finish_all_tasks`.
+ *
+ * @return the new queue
+ *
+ * @exception std::runtime_error if the queue cannot be created
+ */
+cl::CommandQueue create_compute_queue();
+
+/**
+ * @brief register a compute unit bound to this device, so that it gets a new
+ * kernel and queue when the device is reprogrammed. Called by `ComputeUnit::bind`.
+ *
+ * @param cu the compute unit
+ */
+void attach_compute_unit(ComputeUnit *cu);
+
+/**
+ * @brief forget a compute unit, e.g., when it is destroyed
+ *
+ * @param cu the compute unit
+ */
+void detach_compute_unit(ComputeUnit *cu);
+
+/**
+ * @brief enqueue a kernel on a queue after all pending commands it depends
+ * on. ReadOnly buffers and the buffers in `inputs` are treated as inputs, all
+ * other buffers as outputs.
+ *
+ * @param command_q the queue of the compute unit
+ * @param kernel the kernel with all its arguments set
+ * @param buffers the buffer arguments of the kernel
+ * @param inputs the buffer arguments this launch only reads, although they are not ReadOnly
+ * @return the event of the kernel
+ *
+ * @exception std::runtime_error if the kernel cannot be enqueued
+ */
+cl::Event enqueue_task(
+    const cl::CommandQueue &command_q, const cl::Kernel &kernel,
+    const std::vector<cl::Buffer> &buffers, const std::vector<cl::Buffer> &inputs = {}
+);
+
+/**
+ * @brief wait until all pending commands touching a buffer finish, without
+ * waiting for unrelated transfers or kernels
+ *
+ * @param name the name of the buffer
+ *
+ * @exception std::runtime_error if there is no buffer with this name
+ */
+void wait_buffer(const std::string &name);
+
+/**
+ * @brief wait until all pending commands touching an unnamed buffer finish
+ *
+ * @param buffer
+ */
+void wait_buffer(const cl::Buffer &buffer);
+
+/**
+ * @brief get the transfer mode picked for a buffer (ZeroCopy or Staged)
+ *
+ * @exception std::runtime_error if there is no buffer with this name
+ */
+TransferMode transfer_mode(const std::string &name);
+
+/**
+ * @brief drop all released buffers kept for reuse, returning their memory
+ */
+void trim_free_buffers();
+
+/**
+ * @brief get the size in bytes a buffer was created or resized with
+ *
+ * @exception std::runtime_error if there is no buffer with this name
+ */
+size_t buffer_size(const std::string &name);
+
+/**
+ * @brief get the host pointer backing a buffer
+ *
+ * @exception std::runtime_error if there is no buffer with this name
+ */
+void* host_ptr(const std::string &name);
 
 /**
  * @brief Determines if this `xhl::runtime::Device` contains a buffer with the provided name
@@ -71,8 +362,9 @@ cl::Buffer get_buffer(const std::string &name);
 
 
 /**
- * @brief use bitstream to program the device. Create the compute units,
- * return all existing compute units, including the new ones.
+ * @brief use bitstream to program the device. The compute units already
+ * bound to the device get a kernel from the new program and a new queue;
+ * those whose kernel is not in the new bitstream are unbound and throw on launch.
  *
  * @param xclbin_path the path of bitstream/xclbin
  * @param signatures the kernel signatures
@@ -93,14 +385,30 @@ ComputeUnit* find(const KernelSignature &signature);
 std::string name();
 
 /**
- * @brief wait until all tasks to finish
+ * @brief wait until all tasks on all queues finish, then complete staged readbacks
  * @throws std::runtime_error when fail to finish all tasks
  */
 void finish_all_tasks();
 
+/**
+ * @brief wait until all kernels finish, transfers may still be in flight
+ * @throws std::runtime_error when fail to finish the compute tasks
+ */
+void finish_compute_tasks();
+
 };
 
 
+/**
+ * @brief convert a BufferType into the matching OpenCL access flag
+ *
+ * @param type the BufferType: ReadOnly, WriteOnly, and ReadWrite
+ * @return the CL_MEM_* access flag
+ *
+ * @exception std::runtime_error if the buffer type is wrong
+ */
+cl_mem_flags buffer_type_flag(BufferType type);
+
 /**
  * @brief
  *
@@ -141,6 +449,48 @@ void sync_data_htod(Device* device, const std::string &buffer_name);
  */
 void sync_data_dtoh(Device* device, const std::string &buffer_name);
 
+/**
+ * @brief non-blocking host to device transfer of some byte ranges of a buffer
+ *
+ * @param device
+ * @param buffer_name
+ * @param ranges
+ */
+void nb_sync_data_htod(Device* device, const std::string &buffer_name, const std::vector<ByteRange> &ranges);
+
+/**
+ * @brief non-blocking host to device migration of a buffer that is not
+ * registered by name (e.g., a sub-buffer handed out by `xhl::MemoryArena`)
+ *
+ * @param device
+ * @param buffer
+ */
+void nb_sync_data_htod(Device* device, const cl::Buffer &buffer);
+
+/**
+ * @brief non-blocking device to host migration of an unnamed buffer
+ *
+ * @param device
+ * @param buffer
+ */
+void nb_sync_data_dtoh(Device* device, const cl::Buffer &buffer);
+
+/**
+ * @brief blocking host to device migration of an unnamed buffer
+ *
+ * @param device
+ * @param buffer
+ */
+void sync_data_htod(Device* device, const cl::Buffer &buffer);
+
+/**
+ * @brief blocking device to host migration of an unnamed buffer
+ *
+ * @param device
+ * @param buffer
+ */
+void sync_data_dtoh(Device* device, const cl::Buffer &buffer);
+
 } // namespace xhl
 
 #endif // DEVICE_HPP
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "memory_arena.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+namespace xhl {
+
+ArenaBacking::~ArenaBacking() {
+    if (this->device->contains_buffer(this->name)) {
+        this->device->release_buffer(this->name);
+    }
+}
+
+MemoryArena::MemoryArena(
+    Device *device, const std::string &name, size_t capacity, BufferType type,
+    const int memory_channel_name, size_t alignment
+) : _flags(buffer_type_flag(type)), _alignment(alignment), _used(0) {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        throw std::runtime_error("Arena alignment must be a power of two");
+    }
+    auto backing = std::make_shared<ArenaBacking>();
+    backing->device = device;
+    backing->name = name;
+    backing->host.resize(capacity);
+    device->create_buffer(name, capacity, backing->host.data(), type, memory_channel_name);
+    backing->parent = device->get_buffer(name);
+    this->_backing = backing;
+    this->reset();
+}
+
+ArenaBuffer MemoryArena::allocate(size_t size) {
+    if (size == 0) {
+        throw std::runtime_error("Cannot allocate an empty sub-buffer in arena " + this->_backing->name);
+    }
+    size_t reserved = (size + this->_alignment - 1) & ~(this->_alignment - 1);
+    auto ite = this->_free_blocks.begin();
+    for (; ite != this->_free_blocks.end(); ite++) {
+        if (ite->second >= reserved) break;
+    }
+    if (ite == this->_free_blocks.end()) {
+        throw std::runtime_error(
+            "Arena " + this->_backing->name + " out of memory (requested " + std::to_string(size)
+            + " bytes, " + std::to_string(this->capacity() - this->_used) + " bytes free)"
+        );
+    }
+
+    size_t offset = ite->first;
+    cl_buffer_region region = {offset, size};
+    cl_int err = 0;
+    cl::Buffer sub_buffer = this->_backing->parent.createSubBuffer(
+        this->_flags, CL_BUFFER_CREATE_TYPE_REGION, &region, &err
+    );
+    if (err != CL_SUCCESS) {
+        throw std::runtime_error(
+            "Creation of sub-buffer in arena " + this->_backing->name
+            + " failed with error code " + std::to_string(err)
+        );
+    }
+
+    size_t remaining = ite->second - reserved;
+    this->_free_blocks.erase(ite);
+    if (remaining > 0) {
+        this->_free_blocks[offset + reserved] = remaining;
+    }
+    this->_allocated[offset] = reserved;
+    this->_used += reserved;
+    return {this->_backing, sub_buffer, this->_backing->host.data() + offset, offset, size};
+}
+
+void MemoryArena::free(const ArenaBuffer &buffer) {
+    auto alloc = this->_allocated.find(buffer.offset);
+    if (buffer.backing != this->_backing || alloc == this->_allocated.end()) {
+        throw std::runtime_error("Buffer was not allocated from arena " + this->_backing->name);
+    }
+    this->_backing->device->release_sub_buffer(buffer.buffer);
+    size_t offset = alloc->first;
+    size_t size = alloc->second;
+    this->_allocated.erase(alloc);
+    this->_used -= size;
+
+    // merge with the free blocks right after and right before
+    auto next = this->_free_blocks.lower_bound(offset);
+    if (next != this->_free_blocks.end() && next->first == offset + size) {
+        size += next->second;
+        next = this->_free_blocks.erase(next);
+    }
+    if (next != this->_free_blocks.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            prev->second += size;
+            return;
+        }
+    }
+    this->_free_blocks[offset] = size;
+}
+
+void MemoryArena::reset() {
+    this->_backing->device->release_sub_buffers(this->_backing->parent);
+    this->_allocated.clear();
+    this->_free_blocks.clear();
+    if (!this->_backing->host.empty()) {
+        this->_free_blocks[0] = this->_backing->host.size();
+    }
+    this->_used = 0;
+}
+
+cl::Buffer MemoryArena::buffer() const {
+    return this->_backing->parent;
+}
+
+size_t MemoryArena::capacity() const {
+    return this->_backing->host.size();
+}
+
+size_t MemoryArena::used() const {
+    return this->_used;
+}
+
+} // namespace xhl
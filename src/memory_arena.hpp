@@ -0,0 +1,120 @@
+#ifndef MEMORY_ARENA_HPP
+#define MEMORY_ARENA_HPP
+
+#include <string>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include "xcl2.hpp"
+#include "device.hpp"
+#include "xocl-host-lib.hpp"
+
+namespace xhl {
+
+/**
+ * @brief The backing buffer of an arena and its host storage, shared by the
+ * arena and its sub-buffers. It is released from the device once the arena
+ * and the last sub-buffer are gone.
+ */
+struct ArenaBacking {
+    Device *device;
+    std::string name; // the name of the backing buffer on the device
+    aligned_vector<char> host;
+    cl::Buffer parent;
+
+    ~ArenaBacking();
+};
+
+/**
+ * @brief A sub-buffer handed out by `xhl::MemoryArena`. It can be passed to
+ * `ComputeUnit::launch` and the `cl::Buffer` overloads of the sync functions.
+ */
+struct ArenaBuffer {
+    std::shared_ptr<ArenaBacking> backing; // keeps the arena's buffer alive, outlives the sub-buffer
+    cl::Buffer buffer; // the sub-buffer
+    void *host_ptr; // host side of the sub-buffer
+    size_t offset; // offset in the arena in bytes
+    size_t size; // size of the sub-buffer in bytes
+};
+
+/**
+ * @brief Sub-allocator for one memory bank. It creates a single large
+ * `cl::Buffer` and hands out aligned sub-buffers from it, so small buffers
+ * do not pay for a device allocation each. The backing buffer is released
+ * when the arena and all the sub-buffers it handed out are destroyed.
+ */
+class MemoryArena {
+private:
+std::shared_ptr<ArenaBacking> _backing;
+cl_mem_flags _flags;
+size_t _alignment;
+size_t _used;
+
+std::map<size_t, size_t> _free_blocks; // offset -> size, sorted to coalesce neighbours
+std::unordered_map<size_t, size_t> _allocated; // offset -> reserved size
+
+public:
+MemoryArena() = delete;
+MemoryArena(const MemoryArena &) = delete;
+MemoryArena &operator=(const MemoryArena &) = delete;
+
+/**
+ * @brief create the arena and its backing buffer on the device
+ *
+ * @param device the device to allocate on
+ * @param name the name of the backing buffer on the device
+ * @param capacity the size of the arena in bytes
+ * @param type the BufferType of all sub-buffers
+ * @param memory_channel_name the bank of the arena (e.g., xhl::boards::alveo::u280::HBM[0])
+ * @param alignment the alignment of sub-buffer offsets in bytes, must be a power of two
+ *
+ * @exception std::runtime_error if the backing buffer cannot be created
+ */
+MemoryArena(
+    Device *device, const std::string &name, size_t capacity, BufferType type,
+    const int memory_channel_name, size_t alignment = 4096
+);
+
+/**
+ * @brief allocate a sub-buffer (first fit)
+ *
+ * @param size the size of the sub-buffer in bytes
+ * @return the sub-buffer
+ *
+ * @exception std::runtime_error if size is 0
+ * @exception std::runtime_error if the arena is out of memory
+ * @exception std::runtime_error if the sub-buffer cannot be created
+ */
+ArenaBuffer allocate(size_t size);
+
+/**
+ * @brief return a sub-buffer to the arena. The sub-buffer must not be used afterwards.
+ *
+ * @param buffer a sub-buffer allocated from this arena
+ *
+ * @exception std::runtime_error if the buffer does not belong to this arena
+ */
+void free(const ArenaBuffer &buffer);
+
+/**
+ * @brief return all sub-buffers to the arena at once
+ */
+void reset();
+
+/**
+ * @brief get the backing buffer of the arena
+ */
+cl::Buffer buffer() const;
+
+size_t capacity() const;
+
+/**
+ * @brief get the number of bytes currently handed out, including alignment padding
+ */
+size_t used() const;
+};
+
+} // namespace xhl
+
+#endif // MEMORY_ARENA_HPP
@@ -0,0 +1,117 @@
+#include "placement.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <stdexcept>
+
+namespace xhl {
+
+// segments are split on page boundaries so that host pointers stay aligned
+const size_t SEGMENT_ALIGNMENT = 4096;
+
+std::string BufferPlacement::segment_name(size_t i) const {
+    if (this->segments.size() == 1) return this->name;
+    return this->name + "_" + std::to_string(i);
+}
+
+PlacementPlanner::PlacementPlanner(const int *channels, size_t num_banks, size_t bank_size)
+    : _channels(channels), _num_banks(num_banks), _bank_size(bank_size) {
+    if (bank_size < SEGMENT_ALIGNMENT) {
+        throw std::runtime_error("Bank size must be at least " + std::to_string(SEGMENT_ALIGNMENT) + " bytes");
+    }
+}
+
+void PlacementPlanner::add_buffer(const BufferRequest &request) {
+    for (auto &r : this->_requests) {
+        if (r.name == request.name) {
+            throw std::runtime_error("Buffer name already used");
+        }
+    }
+    for (int bank : request.banks) {
+        if (bank < 0 || (size_t)bank >= this->_num_banks) {
+            throw std::runtime_error(
+                "Bank index " + std::to_string(bank) + " out of range for buffer " + request.name
+            );
+        }
+    }
+    this->_requests.push_back(request);
+}
+
+std::map<std::string, BufferPlacement> PlacementPlanner::plan() const {
+    std::vector<double> bank_load(this->_num_banks, 0.0);
+    std::vector<size_t> bank_used(this->_num_banks, 0);
+
+    // the most demanding buffers get the first pick of the banks
+    std::vector<size_t> order(this->_requests.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const BufferRequest &ra = this->_requests[a], &rb = this->_requests[b];
+        if (ra.bandwidth != rb.bandwidth) return ra.bandwidth > rb.bandwidth;
+        return ra.size > rb.size;
+    });
+
+    std::map<std::string, BufferPlacement> placements;
+    for (size_t idx : order) {
+        const BufferRequest &req = this->_requests[idx];
+        std::vector<int> reachable = req.banks;
+        if (reachable.empty()) {
+            reachable.resize(this->_num_banks);
+            std::iota(reachable.begin(), reachable.end(), 0);
+        }
+
+        // split into page-aligned segments no larger than a bank
+        size_t num_segments = std::max<size_t>(1, (req.size + this->_bank_size - 1) / this->_bank_size);
+        if (num_segments > reachable.size()) {
+            throw std::runtime_error(
+                "Buffer " + req.name + " (" + std::to_string(req.size) + " bytes) does not fit in "
+                + std::to_string(reachable.size()) + " reachable banks"
+            );
+        }
+        size_t segment_size = (req.size + num_segments - 1) / num_segments;
+        segment_size = (segment_size + SEGMENT_ALIGNMENT - 1) / SEGMENT_ALIGNMENT * SEGMENT_ALIGNMENT;
+        segment_size = std::min(segment_size, this->_bank_size);
+
+        BufferPlacement placement;
+        placement.name = req.name;
+        std::vector<bool> taken(this->_num_banks, false);
+        for (size_t offset = 0; offset < req.size || placement.segments.empty(); offset += segment_size) {
+            size_t size = std::min(segment_size, req.size - offset);
+            double load = (req.size == 0) ? req.bandwidth : req.bandwidth * size / req.size;
+
+            // pick the least loaded bank with enough room, lowest index on ties
+            int best = -1;
+            for (int bank : reachable) {
+                if (taken[bank] || bank_used[bank] + size > this->_bank_size) continue;
+                if (best < 0 || bank_load[bank] < bank_load[best]
+                    || (bank_load[bank] == bank_load[best] && bank_used[bank] < bank_used[best])) {
+                    best = bank;
+                }
+            }
+            if (best < 0) {
+                throw std::runtime_error("Not enough memory in reachable banks for buffer " + req.name);
+            }
+            taken[best] = true;
+            bank_load[best] += load;
+            bank_used[best] += size;
+            placement.segments.push_back({best, this->_channels[best], offset, size});
+            if (size == 0) break;
+        }
+        placements[req.name] = placement;
+    }
+    return placements;
+}
+
+void create_placed_buffer(
+    Device *device, const BufferPlacement &placement, void *data_ptr, BufferType type
+) {
+    for (size_t i = 0; i < placement.segments.size(); i++) {
+        const BufferSegment &seg = placement.segments[i];
+        device->create_buffer(
+            placement.segment_name(i), seg.size, static_cast<char*>(data_ptr) + seg.offset,
+            type, seg.memory_channel_name
+        );
+    }
+}
+
+} // namespace xhl
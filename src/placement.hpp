@@ -0,0 +1,109 @@
+#ifndef PLACEMENT_HPP
+#define PLACEMENT_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "xcl2.hpp"
+#include "device.hpp"
+#include "xocl-host-lib.hpp"
+
+namespace xhl {
+
+/**
+ * @brief A buffer to be placed by the `xhl::PlacementPlanner`
+ */
+struct BufferRequest {
+    std::string name; // buffer name, used as the key on the device
+    size_t size; // size of the buffer in bytes
+    double bandwidth; // expected access bandwidth, in any unit consistent across requests
+    std::vector<int> banks; // bank indices the CU port is connected to, empty means all banks
+};
+
+/**
+ * @brief A contiguous piece of a placed buffer living in a single bank
+ */
+struct BufferSegment {
+    int bank; // bank index (e.g., 3 for HBM[3])
+    int memory_channel_name; // channel name to pass to `Device::create_buffer`
+    size_t offset; // offset of the segment in the original buffer, in bytes
+    size_t size; // size of the segment in bytes
+};
+
+/**
+ * @brief The banks assigned to one buffer. Buffers larger than a bank are
+ * spread over several segments, each in its own bank.
+ */
+struct BufferPlacement {
+    std::string name;
+    std::vector<BufferSegment> segments;
+
+    /**
+     * @brief get the device buffer name of a segment
+     *
+     * @param i the index of the segment
+     * @return `name` if the buffer has a single segment, `name_<i>` otherwise
+     */
+    std::string segment_name(size_t i) const;
+};
+
+/**
+ * @brief Assigns memory channels to buffers so that concurrently accessed
+ * buffers do not share a bank, and buffers larger than a bank are spread
+ * across banks.
+ */
+class PlacementPlanner {
+private:
+const int *_channels;
+size_t _num_banks;
+size_t _bank_size;
+std::vector<BufferRequest> _requests;
+
+public:
+PlacementPlanner() = delete;
+
+/**
+ * @brief constructor
+ *
+ * @param channels the memory channel names of a board (e.g., xhl::boards::alveo::u280::HBM)
+ * @param num_banks the number of entries in `channels`
+ * @param bank_size the capacity of each bank in bytes
+ */
+PlacementPlanner(const int *channels, size_t num_banks, size_t bank_size);
+
+/**
+ * @brief add a buffer to be placed
+ *
+ * @param request the buffer description
+ *
+ * @exception std::runtime_error if the name is already used or a bank index is out of range
+ */
+void add_buffer(const BufferRequest &request);
+
+/**
+ * @brief assign banks to all added buffers. Buffers are placed in decreasing
+ * order of bandwidth, each segment going to the least loaded reachable bank.
+ *
+ * @return the placement of each buffer, keyed by buffer name
+ *
+ * @exception std::runtime_error if a buffer does not fit in its reachable banks
+ */
+std::map<std::string, BufferPlacement> plan() const;
+};
+
+/**
+ * @brief create the device buffers of a placed buffer, one per segment
+ *
+ * @param device the device to create the buffers on
+ * @param placement the placement returned by `PlacementPlanner::plan`
+ * @param data_ptr the pointer to the data of the whole buffer
+ * @param type the BufferType: ReadOnly, WriteOnly, and ReadWrite
+ */
+void create_placed_buffer(
+    Device *device, const BufferPlacement &placement, void *data_ptr, BufferType type
+);
+
+} // namespace xhl
+
+#endif // PLACEMENT_HPP
@@ -0,0 +1,86 @@
+#include "staging_pool.hpp"
+
+#include <algorithm>
+#include <string>
+#include <stdexcept>
+
+namespace xhl {
+
+StagingPool::StagingPool(size_t block_size, size_t max_idle_bytes)
+    : _block_size(block_size), _max_idle_blocks(std::max<size_t>(max_idle_bytes / block_size, 1)) {}
+
+void StagingPool::_keep_idle(const StagingBlock &block) {
+    if (this->_idle.size() < this->_max_idle_blocks) {
+        this->_idle.push_back(block);
+        return;
+    }
+    // the buffer is released with the last handle, once unmapped
+    this->_command_q.enqueueUnmapMemObject(block.buffer, block.ptr);
+}
+
+void StagingPool::bind(const cl::Context &context, const cl::CommandQueue &command_q) {
+    this->_context = context;
+    this->_command_q = command_q;
+    this->_idle.clear();
+    this->_in_flight.clear();
+}
+
+StagingBlock StagingPool::acquire() {
+    if (this->_idle.empty()) {
+        this->reclaim();
+    }
+    if (!this->_idle.empty()) {
+        StagingBlock block = this->_idle.back();
+        this->_idle.pop_back();
+        return block;
+    }
+
+    cl_int err = 0;
+    StagingBlock block;
+    block.buffer = cl::Buffer(
+        this->_context, CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, this->_block_size, nullptr, &err
+    );
+    if (err != CL_SUCCESS) {
+        throw std::runtime_error(
+            "Failed to allocate staging block (code:" + std::to_string(err) + ")"
+        );
+    }
+    block.ptr = this->_command_q.enqueueMapBuffer(
+        block.buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, this->_block_size,
+        nullptr, nullptr, &err
+    );
+    if (err != CL_SUCCESS) {
+        throw std::runtime_error(
+            "Failed to map staging block (code:" + std::to_string(err) + ")"
+        );
+    }
+    return block;
+}
+
+void StagingPool::retire(const StagingBlock &block, const cl::Event &event) {
+    this->_in_flight.push_back({block, event});
+}
+
+void StagingPool::release(const StagingBlock &block) {
+    this->_keep_idle(block);
+}
+
+void StagingPool::reclaim() {
+    auto ite = this->_in_flight.begin();
+    while (ite != this->_in_flight.end()) {
+        cl_int status = -1;
+        ite->second.getInfo(CL_EVENT_COMMAND_EXECUTION_STATUS, &status);
+        if (status == CL_COMPLETE) {
+            this->_keep_idle(ite->first);
+            ite = this->_in_flight.erase(ite);
+        } else {
+            ite++;
+        }
+    }
+}
+
+size_t StagingPool::block_size() const {
+    return this->_block_size;
+}
+
+} // namespace xhl
@@ -0,0 +1,91 @@
+#ifndef STAGING_POOL_HPP
+#define STAGING_POOL_HPP
+
+#include <vector>
+#include <utility>
+
+#include "xcl2.hpp"
+
+namespace xhl {
+
+/**
+ * @brief A pinned, page-aligned host block used to stage transfers
+ */
+struct StagingBlock {
+    cl::Buffer buffer; // host-visible buffer backing the block
+    void *ptr = nullptr; // mapped host pointer of the block
+};
+
+/**
+ * @brief Pool of pinned host blocks for transfers of data that cannot be
+ * used in place by the runtime (i.e., data that is not 4KB aligned).
+ *
+ * Blocks are allocated by the runtime (CL_MEM_ALLOC_HOST_PTR) and mapped
+ * once, so DMA reads from and writes to them directly. Blocks handed to a
+ * pending transfer are recycled once the transfer's event completes. At
+ * most `max_idle_bytes` of idle blocks are kept, the blocks beyond are freed,
+ * so a burst of large transfers does not pin its memory for the whole run.
+ */
+class StagingPool {
+private:
+cl::Context _context;
+cl::CommandQueue _command_q;
+size_t _block_size;
+size_t _max_idle_blocks;
+std::vector<StagingBlock> _idle;
+std::vector<std::pair<StagingBlock, cl::Event>> _in_flight;
+
+void _keep_idle(const StagingBlock &block); // idle the block, or free it above the cap
+
+public:
+/**
+ * @brief constructor
+ *
+ * @param block_size the size of each staging block in bytes
+ * @param max_idle_bytes the pinned memory kept in idle blocks, at least one block
+ */
+StagingPool(size_t block_size = 16UL * 1024 * 1024, size_t max_idle_bytes = 256UL * 1024 * 1024);
+
+/**
+ * @brief bind the pool to the context and queue used to allocate and map blocks
+ *
+ * @param context
+ * @param command_q
+ */
+void bind(const cl::Context &context, const cl::CommandQueue &command_q);
+
+/**
+ * @brief get an idle block, allocating a new one if none is available
+ *
+ * @return a block of `block_size()` bytes
+ *
+ * @exception std::runtime_error if a new block cannot be allocated or mapped
+ */
+StagingBlock acquire();
+
+/**
+ * @brief hand a block to a pending transfer, it is reused after `event` completes
+ *
+ * @param block the block used by the transfer
+ * @param event the event of the transfer
+ */
+void retire(const StagingBlock &block, const cl::Event &event);
+
+/**
+ * @brief return a block that is no longer in use
+ *
+ * @param block
+ */
+void release(const StagingBlock &block);
+
+/**
+ * @brief return all blocks whose transfer completed to the idle list
+ */
+void reclaim();
+
+size_t block_size() const;
+};
+
+} // namespace xhl
+
+#endif // STAGING_POOL_HPP
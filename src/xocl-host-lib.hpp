@@ -26,6 +26,23 @@ using aligned_vector = std::vector<T, aligned_allocator<T>>;
  * @brief Access control for the device
  */
 enum BufferType {ReadOnly, WriteOnly, ReadWrite};
+/**
+ * @brief How data moves between a caller pointer and the device
+ *
+ * ZeroCopy: the runtime uses the caller pointer in place (CL_MEM_USE_HOST_PTR),
+ *           only efficient if the pointer is 4KB aligned.
+ * Staged:   the device buffer has its own storage and data is copied through
+ *           pinned staging blocks with enqueueWriteBuffer/enqueueReadBuffer.
+ * Auto:     ZeroCopy for 4KB aligned pointers, Staged otherwise.
+ */
+enum TransferMode {Auto, ZeroCopy, Staged};
+/**
+ * @brief A byte range of a buffer, e.g., the part of the host data changed since the last transfer
+ */
+struct ByteRange {
+    size_t offset;
+    size_t size;
+};
 /**
  * @brief Execution mode
  */
@@ -83,6 +100,10 @@ const int HBM[32] = {
 };
 const int DDR[2] = {CHANNEL_NAME(32), CHANNEL_NAME(33)};
 
+// capacity of each memory channel in bytes
+const size_t HBM_CHANNEL_SIZE = 256UL * 1024 * 1024;
+const size_t DDR_CHANNEL_SIZE = 16UL * 1024 * 1024 * 1024;
+
 }; // namespace u280
 
 }; // namespace alveo
@@ -4,3 +4,6 @@ xhl_SRCS += $(XOCL_HOST_LIB)/src/xocl-host-lib.cpp
 xhl_SRCS += $(XOCL_HOST_LIB)/src/compute_unit.cpp
 xhl_SRCS += $(XOCL_HOST_LIB)/src/device.cpp
 xhl_SRCS += $(XOCL_HOST_LIB)/src/link.cpp
+xhl_SRCS += $(XOCL_HOST_LIB)/src/placement.cpp
+xhl_SRCS += $(XOCL_HOST_LIB)/src/memory_arena.cpp
+xhl_SRCS += $(XOCL_HOST_LIB)/src/staging_pool.cpp